@@ -0,0 +1,254 @@
+#include <windows.h>
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <cxxopts.hpp>
+
+#include "maiascan/bench/cold_start.hpp"
+#include "maiascan/bench/fixture.hpp"
+#include "maiascan/bench/fixture_process.hpp"
+#include "maiascan/core/memory_reader.hpp"
+#include "maiascan/core/numa.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/pointer/pointer_map.hpp"
+#include "maiascan/pointer/pointer_scanner.hpp"
+#include "maiascan/scan/scanner.hpp"
+
+namespace {
+
+using maia::bench::FixtureLayout;
+
+struct Measurement {
+  double seconds{};
+  uint64_t bytes{};
+  // Whether the run found what the fixture planted.
+  bool found{};
+  // Part of `bytes` read by the workers of each NUMA node, indexed like maia::GetNumaNodes(). Only filled in when the
+  // pool is pinned, since otherwise workers move between nodes.
+  std::vector<uint64_t> node_bytes;
+};
+
+// Peak working set of the benchmark process so far, which includes every allocation the scans made.
+double PeakRssMiB() {
+  PROCESS_MEMORY_COUNTERS counters{};
+  counters.cb = sizeof(counters);
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return 0;
+  }
+  return static_cast<double>(counters.PeakWorkingSetSize) / (1 << 20);
+}
+
+// Bytes `reader` has delivered so far to the workers of each node, see Measurement::node_bytes.
+std::vector<uint64_t> BytesPerNode(const maia::ThreadPool& pool, const maia::MemoryReader& reader) {
+  const auto& nodes = maia::GetNumaNodes();
+  if (pool.node(0) == maia::kAnyNode) {
+    return {};
+  }
+  std::vector<uint64_t> bytes(nodes.size());
+  for (size_t worker = 0; worker < pool.size(); ++worker) {
+    const auto node = std::find_if(
+        nodes.begin(), nodes.end(), [&](const maia::NumaNode& n) { return n.number == pool.node(worker); });
+    bytes[static_cast<size_t>(node - nodes.begin())] += reader.worker_stats(worker).bytes;
+  }
+  return bytes;
+}
+
+// Runs `fn` `repeat` times and keeps the fastest run. `fn` reads through `reader` with the workers of `pool`.
+template <typename Fn>
+Measurement Best(size_t repeat, const maia::ThreadPool& pool, const maia::MemoryReader& reader, Fn&& fn) {
+  Measurement best;
+  for (size_t i = 0; i < std::max<size_t>(repeat, 1); ++i) {
+    const auto before = BytesPerNode(pool, reader);
+    const auto start = std::chrono::steady_clock::now();
+    Measurement run = fn();
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.node_bytes = BytesPerNode(pool, reader);
+    for (size_t node = 0; node < before.size(); ++node) {
+      run.node_bytes[node] -= before[node];
+    }
+    if (i == 0 || run.seconds < best.seconds) {
+      best = run;
+    }
+  }
+  return best;
+}
+
+void Report(std::string_view layout, std::string_view phase, const Measurement& m) {
+  std::cout << fmt::format("{:<11} {:<13} {:>10.1f} MiB {:>8.3f} s {:>8.2f} GB/s {:>10.1f} MiB  {}\n",
+                           layout,
+                           phase,
+                           static_cast<double>(m.bytes) / (1 << 20),
+                           m.seconds,
+                           m.seconds > 0 ? static_cast<double>(m.bytes) / 1e9 / m.seconds : 0.0,
+                           PeakRssMiB(),
+                           m.found ? "ok" : "MISSED");
+  const auto& nodes = maia::GetNumaNodes();
+  for (size_t node = 0; node < m.node_bytes.size(); ++node) {
+    std::cout << fmt::format("{:<11} {:<13} {:>10.1f} MiB {:>10} {:>8.2f} GB/s\n",
+                             "",
+                             fmt::format("  node {}", nodes[node].number),
+                             static_cast<double>(m.node_bytes[node]) / (1 << 20),
+                             "",
+                             m.seconds > 0 ? static_cast<double>(m.node_bytes[node]) / 1e9 / m.seconds : 0.0);
+  }
+}
+
+bool RunLayout(FixtureLayout layout, const cxxopts::ParseResult& result) {
+  const auto name = maia::bench::ToString(layout);
+  const size_t size = result["size"].as<size_t>() << 20;
+  const auto fixture = maia::bench::FixtureProcess::Spawn(layout, size);
+  if (!fixture) {
+    std::cout << fmt::format("{:<11} failed to start the fixture process\n", name);
+    return false;
+  }
+  auto process = maia::Process::Open(fixture->pid());
+  if (!process) {
+    std::cout << fmt::format("{:<11} failed to open fixture process {}\n", name, fixture->pid());
+    return false;
+  }
+  if (layout == FixtureLayout::kLargePage && !fixture->info().large_pages) {
+    std::cout << fmt::format("{:<11} large pages unavailable, measuring normal pages\n", name);
+  }
+
+  const auto mode = result["mode"].as<std::string>() == "mapped" ? maia::ReadMode::kMapped : maia::ReadMode::kCopy;
+  const size_t repeat = result["repeat"].as<size_t>();
+  const auto& info = fixture->info();
+  maia::ThreadPool pool(result["threads"].as<size_t>(), result["numa"].as<bool>());
+  // Snapshots are left out, so that the numbers measure reading and matching rather than the disk.
+  maia::ScanOptions options;
+  options.read_mode = mode;
+  options.read_ahead = result["read-ahead"].as<bool>();
+  options.large_pages = result["large-pages"].as<bool>();
+  maia::Scanner scanner(*process, pool, options);
+  const auto predicate =
+      maia::MakeExactPredicate(maia::ScanValue::From(maia::ValueType::kInt32, maia::bench::kNeedle), 0);
+
+  maia::ScanResult first;
+  bool ok = true;
+  const auto first_scan = Best(repeat, pool, scanner.reader(), [&] {
+    first = scanner.FirstScan(predicate);
+    return Measurement{.bytes = first.stats.bytes_scanned, .found = first.candidates.count() >= info.needle_count};
+  });
+  Report(name, "first-scan", first_scan);
+  ok = ok && first_scan.found;
+
+  const auto next_scan = Best(repeat, pool, scanner.reader(), [&] {
+    const auto next = scanner.NextScan(first, {.op = maia::NextScanOp::kMatch, .predicate = predicate});
+    return Measurement{.bytes = next.stats.bytes_scanned, .found = next.candidates.count() >= info.needle_count};
+  });
+  Report(name, "next-scan", next_scan);
+  ok = ok && next_scan.found;
+
+  // Resolving the planted chain covers both building the map and searching it.
+  maia::MemoryReader reader(
+      *process, pool.size(), mode, options.read_ahead, maia::WorkerPlacements(pool, options.large_pages));
+  const auto pointer_scan = Best(repeat, pool, reader, [&] {
+    const auto map = maia::PointerMap::Build(reader, pool);
+    maia::PointerScanner pointer_scanner(map, map.info().modules, pool);
+    const auto scan = pointer_scanner.Scan(info.pointer_target, {.max_depth = maia::bench::kChainOffsets.size()});
+    const auto& chain = maia::bench::kChainOffsets;
+    const bool found = std::any_of(scan.paths.begin(), scan.paths.end(), [&](const maia::PointerPath& path) {
+      return std::equal(path.offsets.begin(), path.offsets.end(), chain.begin(), chain.end());
+    });
+    return Measurement{.bytes = map.stats().bytes_scanned, .found = found};
+  });
+  Report(name, "pointer-scan", pointer_scan);
+  return ok && pointer_scan.found;
+}
+
+// Times launches of the command-line tool that exit right after parsing, which is what every scan pays before it
+// starts.
+bool RunColdStart(size_t runs) {
+  const auto cli = maia::bench::SiblingExecutable("maiascan");
+  if (!cli) {
+    std::cout << "cold-start  maiascan executable not found next to the benchmark\n";
+    return false;
+  }
+  const auto timing = maia::bench::MeasureColdStart(*cli, L"--help", runs);
+  if (!timing) {
+    std::cout << fmt::format("cold-start  failed to run {}\n", cli->string());
+    return false;
+  }
+  std::cout << fmt::format("cold-start  {} runs: first {:.1f} ms, median {:.1f} ms, binary {:.2f} MiB\n",
+                           runs,
+                           timing->first_ms,
+                           timing->median_ms,
+                           static_cast<double>(timing->binary_bytes) / (1 << 20));
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, const char* const* argv) {
+  cxxopts::Options opts("maiascan_bench", "Scan throughput on synthetic target processes");
+  opts.add_options()("h,help", "Show help", cxxopts::value<bool>()->default_value("false"))(
+      "layouts",
+      "Fixture layouts to measure: dense, sparse, fragmented, large-page",
+      cxxopts::value<std::vector<std::string>>()->default_value("dense,sparse,fragmented,large-page"))(
+      "size", "Fixture size in MiB", cxxopts::value<size_t>()->default_value("1024"))(
+      "j,threads",
+      "Number of scan threads, 0 for one per hardware thread",
+      cxxopts::value<size_t>()->default_value("0"))(
+      "mode", "How target memory is read: read or mapped", cxxopts::value<std::string>()->default_value("read"))(
+      "read-ahead", "Read the next shard on a helper thread while the current one is scanned")(
+      "numa", "Pin scan threads to NUMA nodes with node-local read buffers, and report bandwidth per node")(
+      "large-pages", "Back read buffers and candidate storage with large pages")(
+      "repeat", "Runs per measurement, the fastest is reported", cxxopts::value<size_t>()->default_value("3"))(
+      "cold-start-runs",
+      "Launches of the command-line tool timed for its startup cost, 0 to skip",
+      cxxopts::value<size_t>()->default_value("20"))(
+      maia::bench::FixtureProcess::kServeOption,
+      "Internal: build the named fixture and serve it until stdin is closed",
+      cxxopts::value<std::string>());
+
+  try {
+    auto result = opts.parse(argc, argv);
+    if (result["help"].as<bool>()) {
+      std::cout << opts.help();
+      return 0;
+    }
+    if (result.count(maia::bench::FixtureProcess::kServeOption) != 0) {
+      const auto layout =
+          maia::bench::ParseFixtureLayout(result[maia::bench::FixtureProcess::kServeOption].as<std::string>());
+      return layout ? maia::bench::ServeFixture(*layout, result["size"].as<size_t>() << 20) : 1;
+    }
+
+    std::vector<FixtureLayout> layouts;
+    for (const auto& name : result["layouts"].as<std::vector<std::string>>()) {
+      const auto layout = maia::bench::ParseFixtureLayout(name);
+      if (!layout) {
+        std::cout << fmt::format("Unknown layout: {}\n", name);
+        return 1;
+      }
+      layouts.push_back(*layout);
+    }
+
+    bool ok = true;
+    if (const size_t runs = result["cold-start-runs"].as<size_t>(); runs != 0) {
+      ok = RunColdStart(runs);
+    }
+    std::cout << fmt::format("{:<11} {:<13} {:>14} {:>10} {:>13} {:>14}\n",
+                             "layout",
+                             "phase",
+                             "read",
+                             "time",
+                             "throughput",
+                             "peak RSS");
+    for (const auto layout : layouts) {
+      ok = RunLayout(layout, result) && ok;
+    }
+    return ok ? 0 : 1;
+  } catch (cxxopts::exceptions::parsing& e) {
+    std::cout << fmt::format("Failed to parse: {}\n", e.what());
+    std::cout << opts.help();
+  }
+  return 1;
+}
@@ -0,0 +1,91 @@
+#include "maiascan/bench/cold_start.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace maia::bench {
+
+namespace {
+
+// Runs `command` to completion with its standard streams on the null device and returns how long it took.
+std::optional<double> TimeLaunch(std::wstring command, HANDLE null_device) {
+  STARTUPINFOW startup{};
+  startup.cb = sizeof(startup);
+  startup.dwFlags = STARTF_USESTDHANDLES;
+  startup.hStdInput = null_device;
+  startup.hStdOutput = null_device;
+  startup.hStdError = null_device;
+  PROCESS_INFORMATION info{};
+  const auto start = std::chrono::steady_clock::now();
+  if (!CreateProcessW(
+          nullptr, command.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &startup, &info)) {
+    return std::nullopt;
+  }
+  WaitForSingleObject(info.hProcess, INFINITE);
+  const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  DWORD exit_code = 1;
+  GetExitCodeProcess(info.hProcess, &exit_code);
+  CloseHandle(info.hThread);
+  CloseHandle(info.hProcess);
+  if (exit_code != 0) {
+    return std::nullopt;
+  }
+  return elapsed.count();
+}
+
+}  // namespace
+
+std::optional<std::filesystem::path> SiblingExecutable(std::string_view name) {
+  std::vector<WCHAR> own(32768);
+  if (GetModuleFileNameW(nullptr, own.data(), static_cast<DWORD>(own.size())) == 0) {
+    return std::nullopt;
+  }
+  auto path = std::filesystem::path(own.data()).parent_path() / name;
+  path.replace_extension(".exe");
+  std::error_code error;
+  if (!std::filesystem::is_regular_file(path, error)) {
+    return std::nullopt;
+  }
+  return path;
+}
+
+std::optional<ColdStartTiming> MeasureColdStart(const std::filesystem::path& executable,
+                                                std::wstring_view arguments,
+                                                size_t runs) {
+  std::error_code error;
+  const auto binary_bytes = std::filesystem::file_size(executable, error);
+  if (error || runs == 0) {
+    return std::nullopt;
+  }
+  SECURITY_ATTRIBUTES inherit{
+      .nLength = sizeof(SECURITY_ATTRIBUTES), .lpSecurityDescriptor = nullptr, .bInheritHandle = TRUE};
+  HANDLE null_device = CreateFileW(
+      L"NUL", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &inherit, OPEN_EXISTING, 0, nullptr);
+  if (null_device == INVALID_HANDLE_VALUE) {
+    return std::nullopt;
+  }
+  const std::wstring command = L"\"" + executable.wstring() + L"\" " + std::wstring(arguments);
+  std::vector<double> times;
+  for (size_t i = 0; i < runs; ++i) {
+    const auto time = TimeLaunch(command, null_device);
+    if (!time) {
+      break;
+    }
+    times.push_back(*time);
+  }
+  CloseHandle(null_device);
+  if (times.size() != runs) {
+    return std::nullopt;
+  }
+  ColdStartTiming timing{.first_ms = times.front(), .median_ms = 0, .binary_bytes = binary_bytes};
+  std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+  timing.median_ms = times[times.size() / 2];
+  return timing;
+}
+
+}  // namespace maia::bench
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace maia::bench {
+
+struct ColdStartTiming {
+  // The first launch, the one most likely to find the executable and its DLLs outside the file cache.
+  double first_ms{};
+  double median_ms{};
+  uint64_t binary_bytes{};
+};
+
+// The command-line tool built next to the benchmark executable.
+std::optional<std::filesystem::path> SiblingExecutable(std::string_view name);
+
+// Launches `executable` with `arguments` `runs` times, one after another with its output discarded, and times every
+// launch from CreateProcess() to the exit of the child. With arguments that make the tool exit right away this is the
+// cost of starting it at all: loading the image and its DLLs and running their initializers.
+std::optional<ColdStartTiming> MeasureColdStart(const std::filesystem::path& executable,
+                                                std::wstring_view arguments,
+                                                size_t runs);
+
+}  // namespace maia::bench
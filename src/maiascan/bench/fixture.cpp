@@ -0,0 +1,146 @@
+#include "maiascan/bench/fixture.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "maiascan/core/page_buffer.hpp"
+
+namespace maia::bench {
+
+// Root of the pointer chain. Lives in the image of the executable, so pointer scans see the chain as static; volatile
+// keeps the otherwise unread store.
+volatile uintptr_t g_fixture_chain_root = 0;
+
+namespace {
+
+constexpr std::array<std::string_view, 4> kLayoutNames{"dense", "sparse", "fragmented", "large-page"};
+
+// Granularity of the committed blocks of the fragmented layout. Equal to the allocation granularity, so the reserved
+// gaps really split the fixture into separate regions.
+constexpr size_t kFragmentBlock = size_t{64} << 10;
+
+// Logical offsets of the chain nodes. Stored pointers land at offsets that are neither needle nor noise slots.
+constexpr std::array<size_t, 3> kChainNodes{0x1200, 0x3200, 0x5200};
+
+struct LayoutParams {
+  size_t needle_step;
+  size_t pointer_step;
+  bool fragmented;
+};
+
+LayoutParams Params(FixtureLayout layout) {
+  switch (layout) {
+    case FixtureLayout::kSparse:
+      return {.needle_step = size_t{1} << 20, .pointer_step = size_t{64} << 10, .fragmented = false};
+    case FixtureLayout::kFragmented:
+      return {.needle_step = 4096, .pointer_step = 4096, .fragmented = true};
+    case FixtureLayout::kDense:
+    case FixtureLayout::kLargePage:
+      break;
+  }
+  return {.needle_step = 256, .pointer_step = 256, .fragmented = false};
+}
+
+uint64_t NextRandom(uint64_t& state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+// Maps logical fixture offsets to addresses, skipping the gaps of the fragmented layout.
+class FixtureMemory {
+ public:
+  FixtureMemory(std::byte* base, bool fragmented) : base_(base), fragmented_(fragmented) {}
+
+  std::byte* At(size_t offset) const {
+    if (!fragmented_) {
+      return base_ + offset;
+    }
+    return base_ + (offset / kFragmentBlock) * 2 * kFragmentBlock + offset % kFragmentBlock;
+  }
+
+  template <typename T>
+  void Store(size_t offset, T value) const {
+    std::memcpy(At(offset), &value, sizeof(T));
+  }
+
+ private:
+  std::byte* base_;
+  bool fragmented_;
+};
+
+}  // namespace
+
+std::string_view ToString(FixtureLayout layout) { return kLayoutNames[static_cast<size_t>(layout)]; }
+
+std::optional<FixtureLayout> ParseFixtureLayout(std::string_view name) {
+  const auto it = std::find(kLayoutNames.begin(), kLayoutNames.end(), name);
+  if (it == kLayoutNames.end()) {
+    return std::nullopt;
+  }
+  return static_cast<FixtureLayout>(it - kLayoutNames.begin());
+}
+
+std::optional<FixtureInfo> BuildFixture(FixtureLayout layout, size_t size) {
+  const LayoutParams params = Params(layout);
+  size = std::max((size + kFragmentBlock - 1) / kFragmentBlock * kFragmentBlock, 2 * kFragmentBlock);
+
+  FixtureInfo info;
+  void* base = nullptr;
+  if (const size_t large_page = layout == FixtureLayout::kLargePage ? LargePageSize() : 0; large_page != 0) {
+    const size_t large_size = (size + large_page - 1) / large_page * large_page;
+    base = VirtualAlloc(nullptr, large_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (base != nullptr) {
+      size = large_size;
+      info.large_pages = true;
+    }
+  }
+  if (params.fragmented) {
+    base = VirtualAlloc(nullptr, 2 * size, MEM_RESERVE, PAGE_NOACCESS);
+    for (size_t block = 0; base != nullptr && block < size / kFragmentBlock; ++block) {
+      if (VirtualAlloc(static_cast<std::byte*>(base) + 2 * block * kFragmentBlock,
+                       kFragmentBlock,
+                       MEM_COMMIT,
+                       PAGE_READWRITE) == nullptr) {
+        return std::nullopt;
+      }
+    }
+  } else if (base == nullptr) {
+    base = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  }
+  if (base == nullptr) {
+    return std::nullopt;
+  }
+
+  // Random background without the needle in either half of a word, then needles and pointers to random words of the
+  // fixture on their grids.
+  const FixtureMemory memory(static_cast<std::byte*>(base), params.fragmented);
+  uint64_t state = 0x9E3779B97F4A7C15;
+  for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+    uint64_t word = NextRandom(state);
+    if (static_cast<int32_t>(word) == kNeedle || static_cast<int32_t>(word >> 32) == kNeedle) {
+      word = ~word;
+    }
+    memory.Store(offset, word);
+  }
+  for (size_t offset = 0; offset < size; offset += params.needle_step) {
+    memory.Store(offset, kNeedle);
+    ++info.needle_count;
+  }
+  for (size_t offset = 128; offset < size; offset += params.pointer_step) {
+    const size_t pointee = NextRandom(state) % size & ~size_t{7};
+    memory.Store(offset, reinterpret_cast<uintptr_t>(memory.At(pointee)));
+  }
+
+  g_fixture_chain_root = reinterpret_cast<uintptr_t>(memory.At(kChainNodes[0]));
+  for (size_t i = 0; i + 1 < kChainNodes.size(); ++i) {
+    memory.Store(kChainNodes[i] + kChainOffsets[i], reinterpret_cast<uintptr_t>(memory.At(kChainNodes[i + 1])));
+  }
+  info.pointer_target = reinterpret_cast<uintptr_t>(memory.At(kChainNodes.back())) + kChainOffsets.back();
+  return info;
+}
+
+}  // namespace maia::bench
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace maia::bench {
+
+enum class FixtureLayout : uint8_t {
+  // One contiguous region with a needle every 256 bytes and pointers just as dense.
+  kDense,
+  // One contiguous region with a needle every MiB and a pointer every 64 KiB.
+  kSparse,
+  // 64 KiB committed blocks separated by 64 KiB of reserved address space, one region per block.
+  kFragmented,
+  // Dense contents on large pages. Falls back to normal pages without SeLockMemoryPrivilege.
+  kLargePage,
+};
+
+inline constexpr std::array kFixtureLayouts{
+    FixtureLayout::kDense, FixtureLayout::kSparse, FixtureLayout::kFragmented, FixtureLayout::kLargePage};
+
+std::string_view ToString(FixtureLayout layout);
+std::optional<FixtureLayout> ParseFixtureLayout(std::string_view name);
+
+// Value planted at aligned i32 slots. Background bytes never contain it at aligned positions, so a first scan for it
+// finds at least the planted slots; anything beyond them comes from outside the fixture.
+inline constexpr int32_t kNeedle = 0x5EED5EED;
+
+// Offsets of the pointer chain that leads from a global of the fixture executable to FixtureInfo::pointer_target.
+inline constexpr std::array<uint32_t, 3> kChainOffsets{0x10, 0x28, 0x8};
+
+// What a fixture planted, so that the benchmark can check what the scans found.
+struct FixtureInfo {
+  uint64_t needle_count{};
+  uint64_t pointer_target{};
+  // Whether the fixture actually lives on large pages.
+  bool large_pages{};
+};
+
+// Allocates and fills a fixture of about `size` bytes in the calling process. The memory stays allocated until the
+// process exits.
+std::optional<FixtureInfo> BuildFixture(FixtureLayout layout, size_t size);
+
+}  // namespace maia::bench
@@ -0,0 +1,114 @@
+#include "maiascan/bench/fixture_process.hpp"
+
+#include <windows.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace maia::bench {
+
+namespace {
+
+// How long a child gets to exit on its own before it is terminated.
+constexpr DWORD kExitTimeoutMs = 5000;
+
+std::wstring Widen(std::string_view text) { return {text.begin(), text.end()}; }
+
+// Reads one line from `pipe`, without the newline. Returns false if the pipe closed first.
+bool ReadLine(HANDLE pipe, std::string& line) {
+  char c;
+  DWORD read = 0;
+  while (ReadFile(pipe, &c, 1, &read, nullptr) && read == 1) {
+    if (c == '\n') {
+      return true;
+    }
+    if (c != '\r') {
+      line.push_back(c);
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+std::unique_ptr<FixtureProcess> FixtureProcess::Spawn(FixtureLayout layout, size_t size) {
+  std::vector<WCHAR> executable(32768);
+  if (GetModuleFileNameW(nullptr, executable.data(), static_cast<DWORD>(executable.size())) == 0) {
+    return nullptr;
+  }
+  std::wstring command = L"\"" + std::wstring(executable.data()) + L"\" --" + Widen(kServeOption) + L" " +
+                         Widen(ToString(layout)) + L" --size " + std::to_wstring(size >> 20);
+
+  // The child inherits only its ends of the two pipes.
+  SECURITY_ATTRIBUTES inherit{
+      .nLength = sizeof(SECURITY_ATTRIBUTES), .lpSecurityDescriptor = nullptr, .bInheritHandle = TRUE};
+  HANDLE input_read = nullptr;
+  HANDLE input_write = nullptr;
+  HANDLE output_read = nullptr;
+  HANDLE output_write = nullptr;
+  if (!CreatePipe(&input_read, &input_write, &inherit, 0)) {
+    return nullptr;
+  }
+  if (!CreatePipe(&output_read, &output_write, &inherit, 0)) {
+    CloseHandle(input_read);
+    CloseHandle(input_write);
+    return nullptr;
+  }
+  SetHandleInformation(input_write, HANDLE_FLAG_INHERIT, 0);
+  SetHandleInformation(output_read, HANDLE_FLAG_INHERIT, 0);
+
+  STARTUPINFOW startup{};
+  startup.cb = sizeof(startup);
+  startup.dwFlags = STARTF_USESTDHANDLES;
+  startup.hStdInput = input_read;
+  startup.hStdOutput = output_write;
+  startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+  PROCESS_INFORMATION info{};
+  const BOOL created = CreateProcessW(
+      nullptr, command.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &startup, &info);
+  CloseHandle(input_read);
+  CloseHandle(output_write);
+  if (!created) {
+    CloseHandle(input_write);
+    CloseHandle(output_read);
+    return nullptr;
+  }
+  CloseHandle(info.hThread);
+  std::unique_ptr<FixtureProcess> child(new FixtureProcess(info.hProcess, input_write, info.dwProcessId));
+
+  std::string line;
+  const bool reported = ReadLine(output_read, line);
+  CloseHandle(output_read);
+  std::istringstream report(line);
+  std::string ready;
+  report >> ready >> child->info_.needle_count >> child->info_.pointer_target >> child->info_.large_pages;
+  if (!reported || ready != "ready" || report.fail()) {
+    return nullptr;
+  }
+  return child;
+}
+
+FixtureProcess::~FixtureProcess() {
+  CloseHandle(input_);
+  if (WaitForSingleObject(process_, kExitTimeoutMs) != WAIT_OBJECT_0) {
+    TerminateProcess(process_, 1);
+  }
+  CloseHandle(process_);
+}
+
+int ServeFixture(FixtureLayout layout, size_t size) {
+  const auto info = BuildFixture(layout, size);
+  if (!info) {
+    std::cout << "failed\n" << std::flush;
+    return 1;
+  }
+  std::cout << "ready " << info->needle_count << ' ' << info->pointer_target << ' ' << info->large_pages << '\n'
+            << std::flush;
+  for (std::string line; std::getline(std::cin, line);) {
+  }
+  return 0;
+}
+
+}  // namespace maia::bench
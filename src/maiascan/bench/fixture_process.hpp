@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "maiascan/bench/fixture.hpp"
+
+namespace maia::bench {
+
+// A child copy of the benchmark executable that builds one fixture and keeps it alive, so that scans measure reading
+// another process exactly like the real tool does. The child exits when this object is destroyed.
+class FixtureProcess {
+ public:
+  // Command-line option that turns the benchmark executable into a fixture server. The child reports
+  // "ready <needle count> <pointer target> <large pages>" on stdout and exits once its stdin is closed.
+  static constexpr const char* kServeOption = "serve-fixture";
+
+  static std::unique_ptr<FixtureProcess> Spawn(FixtureLayout layout, size_t size);
+
+  FixtureProcess(const FixtureProcess&) = delete;
+  FixtureProcess& operator=(const FixtureProcess&) = delete;
+  ~FixtureProcess();
+
+  uint32_t pid() const { return pid_; }
+  const FixtureInfo& info() const { return info_; }
+
+ private:
+  FixtureProcess(void* process, void* input, uint32_t pid) : process_(process), input_(input), pid_(pid) {}
+
+  void* process_{};
+  // Write end of the child's stdin.
+  void* input_{};
+  uint32_t pid_{};
+  FixtureInfo info_;
+};
+
+// Body of the child: builds the fixture, reports it and serves it until stdin is closed.
+int ServeFixture(FixtureLayout layout, size_t size);
+
+}  // namespace maia::bench
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include <cxxopts.hpp>
+
+#include "maiascan/core/memory_reader.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/scan/value.hpp"
+
+namespace maia::cli {
+
+// Options shared by every command that attaches to a process: --pid or --dump, --threads, --mode, --read-ahead,
+// --numa, --large-pages, --max-results and --perf-log.
+void AddTargetOptions(cxxopts::Options& options);
+
+// Starts the log named by --perf-log, if any, printing an error when it cannot be created.
+bool OpenPerfLogOption(const cxxopts::ParseResult& result);
+
+// Opens the process named by --pid, or the dump named by --dump without one, printing an error when that fails.
+std::optional<Process> OpenTargetProcess(const cxxopts::ParseResult& result,
+                                         ProcessAccess access = ProcessAccess::kRead);
+
+// Parses --mode, printing an error for unknown modes.
+std::optional<ReadMode> ParseReadModeOption(const cxxopts::ParseResult& result);
+
+// Parses option `name` as a value of `type`, printing an error when it does not fit.
+std::optional<ScanValue> ParseValueOption(const cxxopts::ParseResult& result, const std::string& name, ValueType type);
+
+void AddScanOptions(cxxopts::Options& options);
+int RunScanCommand(const cxxopts::ParseResult& result);
+
+void AddPointerOptions(cxxopts::Options& options);
+int RunPointerCommand(const cxxopts::ParseResult& result);
+
+void AddWatchOptions(cxxopts::Options& options);
+int RunWatchCommand(const cxxopts::ParseResult& result);
+
+}  // namespace maia::cli
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "maiascan/cli/commands.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/pointer/pointer_map.hpp"
+#include "maiascan/pointer/pointer_scanner.hpp"
+
+namespace maia::cli {
+
+namespace {
+
+constexpr size_t kMaxPrintedPaths = 50;
+
+// Builds the map from the process named by --pid, or loads the one named by --load-map.
+std::optional<PointerMap> GetPointerMap(const cxxopts::ParseResult& result, ThreadPool& pool) {
+  const auto start = std::chrono::steady_clock::now();
+  if (result.count("load-map") != 0) {
+    const auto& path = result["load-map"].as<std::string>();
+    auto map = PointerMap::Load(path);
+    if (!map) {
+      std::cout << fmt::format("Failed to load pointer map {}\n", path);
+      return std::nullopt;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << fmt::format(
+        "Loaded {} pointers of process {} from {} in {:.3f} s\n", map->size(), map->info().pid, path, elapsed.count());
+    return map;
+  }
+
+  const auto pointer_size = result["pointer-size"].as<size_t>();
+  if (pointer_size != 4 && pointer_size != 8) {
+    std::cout << fmt::format("Unsupported pointer size: {}\n", pointer_size);
+    return std::nullopt;
+  }
+  const size_t memory_limit = result["mem-limit"].as<size_t>() << 20;
+  const auto& spill_dir = result["snapshot-dir"].as<std::string>();
+  if (memory_limit != 0 && spill_dir.empty()) {
+    std::cout << "--mem-limit needs a --snapshot-dir to spill to\n";
+    return std::nullopt;
+  }
+  auto process = OpenTargetProcess(result);
+  const auto mode = ParseReadModeOption(result);
+  if (!process || !mode) {
+    return std::nullopt;
+  }
+  MemoryReader reader(*process,
+                      pool.size(),
+                      *mode,
+                      result["read-ahead"].as<bool>(),
+                      WorkerPlacements(pool, result["large-pages"].as<bool>()));
+  auto map = PointerMap::Build(reader,
+                               pool,
+                               {.pointer_size = pointer_size, .memory_limit = memory_limit, .spill_dir = spill_dir});
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << fmt::format("Indexed {} pointers in {} regions ({:.1f} MiB, {} reads) in {:.3f} s, map {:.1f} MiB\n",
+                           map.size(),
+                           map.stats().regions,
+                           static_cast<double>(map.stats().bytes_scanned) / (1 << 20),
+                           map.stats().read_calls,
+                           elapsed.count(),
+                           static_cast<double>(map.memory_usage()) / (1 << 20));
+  if (map.stats().spilled_runs != 0) {
+    std::cout << fmt::format("Spilled {:.1f} MiB in {} sorted runs past the memory limit\n",
+                             static_cast<double>(map.stats().spilled_bytes) / (1 << 20),
+                             map.stats().spilled_runs);
+  }
+  if (map.stats().spill_failed) {
+    std::cout << fmt::format("Failed to spill to {}, the remaining pointers were kept in memory past --mem-limit\n",
+                             spill_dir);
+  }
+  return map;
+}
+
+}  // namespace
+
+void AddPointerOptions(cxxopts::Options& options) {
+  auto pointer_options = options.add_options("pointer");
+  pointer_options("address",
+                  "Address the pointer paths have to lead to. Defaults to the address saved with --load-map",
+                  cxxopts::value<std::string>());
+  pointer_options("depth", "Maximum number of dereferences in a path", cxxopts::value<size_t>()->default_value("4"));
+  pointer_options("max-offset",
+                  "Largest offset added after each dereference",
+                  cxxopts::value<std::string>()->default_value("0x1000"));
+  pointer_options("pointer-size",
+                  "Pointer width of the target in bytes: 8, or 4 for 32-bit processes",
+                  cxxopts::value<size_t>()->default_value("8"));
+  pointer_options("mem-limit",
+                  "Memory in MiB for the pointers collected while the map is built, 0 for no limit. Beyond it they are "
+                  "sorted in runs written to --snapshot-dir and merged into a file the search reads from",
+                  cxxopts::value<size_t>()->default_value("0"));
+  pointer_options("save-map", "Save the pointer map and the address to this file", cxxopts::value<std::string>());
+  pointer_options("load-map", "Search a saved pointer map instead of the process", cxxopts::value<std::string>());
+  pointer_options("intersect",
+                  "Keep only paths that also lead to the saved address in this saved map, e.g. one taken before a "
+                  "restart. Can be repeated",
+                  cxxopts::value<std::vector<std::string>>());
+}
+
+int RunPointerCommand(const cxxopts::ParseResult& result) {
+  const auto max_offset = ParseValueOption(result, "max-offset", ValueType::kUInt32);
+  if (!max_offset) {
+    return 1;
+  }
+  ThreadPool pool(result["threads"].as<size_t>(), result["numa"].as<bool>());
+  const auto map = GetPointerMap(result, pool);
+  if (!map) {
+    return 1;
+  }
+
+  std::optional<uint64_t> target = map->info().target;
+  if (result.count("address") != 0) {
+    const auto address = ParseValueOption(result, "address", ValueType::kUInt64);
+    if (!address) {
+      return 1;
+    }
+    target = address->As<uint64_t>();
+  }
+  if (!target) {
+    std::cout << "--address is required for a pointer scan\n";
+    return 1;
+  }
+
+  if (result.count("save-map") != 0) {
+    const auto& path = result["save-map"].as<std::string>();
+    if (!map->Save(path, target)) {
+      std::cout << fmt::format("Failed to save pointer map to {}\n", path);
+      return 1;
+    }
+    std::cout << fmt::format("Saved pointer map to {}\n", path);
+  }
+
+  PointerScanOptions scan_options{.max_depth = result["depth"].as<size_t>(), .max_offset = max_offset->As<uint32_t>()};
+  if (result.count("max-results") != 0) {
+    scan_options.max_results = result["max-results"].as<size_t>();
+  }
+  const auto& modules = map->info().modules;
+  PointerScanner scanner(*map, modules, pool);
+  const auto start = std::chrono::steady_clock::now();
+  auto scan = scanner.Scan(*target, scan_options);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << fmt::format("{} paths through {} addresses over {} levels{} in {:.3f} s\n",
+                           scan.paths.size(),
+                           scan.stats.nodes,
+                           scan.stats.levels,
+                           scan.stats.truncated ? " (truncated)" : "",
+                           elapsed.count());
+
+  if (result.count("intersect") != 0) {
+    for (const auto& path : result["intersect"].as<std::vector<std::string>>()) {
+      const auto other = PointerMap::Load(path);
+      if (!other || !other->info().target) {
+        std::cout << fmt::format("Failed to load pointer map {} or it has no saved address\n", path);
+        return 1;
+      }
+      const PointerScanner other_scanner(*other, other->info().modules, pool);
+      scan.paths = other_scanner.Filter(scan.paths, modules, *other->info().target);
+      std::cout << fmt::format("{} paths also lead to {:#x} in {}\n", scan.paths.size(), *other->info().target, path);
+    }
+  }
+
+  for (size_t i = 0; i < std::min(scan.paths.size(), kMaxPrintedPaths); ++i) {
+    std::cout << FormatPointerPath(scan.paths[i], modules) << '\n';
+  }
+  return 0;
+}
+
+}  // namespace maia::cli
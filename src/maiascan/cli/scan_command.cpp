@@ -0,0 +1,504 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "maiascan/cli/commands.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/scan/scan_history.hpp"
+#include "maiascan/scan/scanner.hpp"
+
+namespace maia::cli {
+
+namespace {
+
+constexpr size_t kMaxPrintedMatches = 20;
+
+// Prints candidates [first, first + kMaxPrintedMatches) in address order.
+void PrintCandidates(const CandidateSet& candidates, size_t first) {
+  std::vector<uintptr_t> addresses(kMaxPrintedMatches);
+  addresses.resize(CandidatePager(candidates).Read(first, addresses));
+  for (const uintptr_t address : addresses) {
+    std::cout << fmt::format("{:#018x}\n", address);
+  }
+}
+
+// Prints the first candidates delivered by `stream` as they arrive, then lets the scan finish without waiting on us.
+void PrintStreamed(ResultStream& stream, std::chrono::steady_clock::time_point start) {
+  size_t printed = 0;
+  CandidateBlock block;
+  while (printed < kMaxPrintedMatches && stream.Pop(block)) {
+    if (printed == 0) {
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << fmt::format("First candidates after {:.3f} s:\n", elapsed.count());
+    }
+    block.ForEachSlot([&](size_t slot) {
+      std::cout << fmt::format("{:#018x}\n", block.base() + slot * stream.stride());
+      return ++printed < kMaxPrintedMatches;
+    });
+  }
+  stream.Close();
+}
+
+void PrintSummary(const ScanResult& scan, std::chrono::duration<double> elapsed) {
+  std::cout << fmt::format("{}{} candidates ({:.1f} MiB, {} reads) in {:.3f} s, store {:.1f} KiB, "
+                           "snapshot {:.1f} MiB\n",
+                           scan.stats.truncated ? "Stopped at " : "",
+                           scan.candidates.count(),
+                           static_cast<double>(scan.stats.bytes_scanned) / (1 << 20),
+                           scan.stats.read_calls,
+                           elapsed.count(),
+                           static_cast<double>(scan.candidates.memory_usage()) / (1 << 10),
+                           scan.snapshot ? static_cast<double>(scan.snapshot->file_size()) / (1 << 20) : 0.0);
+}
+
+std::optional<NextScanOp> ParseNextScanOp(std::string_view command) {
+  if (command == "changed") {
+    return NextScanOp::kChanged;
+  }
+  if (command == "unchanged") {
+    return NextScanOp::kUnchanged;
+  }
+  if (command == "increased") {
+    return NextScanOp::kIncreased;
+  }
+  if (command == "decreased") {
+    return NextScanOp::kDecreased;
+  }
+  return std::nullopt;
+}
+
+void PrintHistory(const ScanHistory& history) {
+  for (size_t generation = 0; generation < history.size(); ++generation) {
+    const ScanCheckpoint& checkpoint = history.checkpoint(generation);
+    std::cout << fmt::format("{} {}: {} candidates, checkpoint {:.1f} KiB{}{}\n",
+                             history.current() == generation ? '*' : ' ',
+                             generation,
+                             checkpoint.count(),
+                             static_cast<double>(checkpoint.memory_usage() + checkpoint.file_size()) / (1 << 10),
+                             checkpoint.file_size() != 0 ? " on disk" : "",
+                             checkpoint.has_values() ? "" : ", without values");
+  }
+}
+
+// Reads next-scan commands from stdin until it is closed or "quit" is entered. Every generation is checkpointed in
+// `history`, if given, which lets "undo" go back to earlier ones.
+void RunNextScans(Scanner& scanner, ThreadPool& pool, ScanResult scan, double epsilon, ScanHistory* history) {
+  const ValueType type = scan.candidates.type;
+  const auto record = [&] {
+    if (history != nullptr && !history->Record(scan, pool)) {
+      std::cout << "Too many candidates to checkpoint within --checkpoint-limit, undo goes back to the previous scan\n";
+    }
+  };
+  record();
+  std::cout << "Next scan: changed, unchanged, increased, decreased, eq <value>, range <lower> <upper>, list [first], "
+            << (history != nullptr ? "undo [steps], history, " : "") << "quit\n";
+  std::string line;
+  while (std::cout << "> " << std::flush, std::getline(std::cin, line)) {
+    std::istringstream input(line);
+    std::string command;
+    input >> command;
+    if (command.empty()) {
+      continue;
+    }
+    if (command == "quit" || command == "exit") {
+      break;
+    }
+    if (command == "list") {
+      size_t first = 0;
+      input >> first;
+      PrintCandidates(scan.candidates, first);
+      continue;
+    }
+    if (history != nullptr && command == "history") {
+      PrintHistory(*history);
+      continue;
+    }
+    if (history != nullptr && command == "undo") {
+      size_t steps = 1;
+      input >> steps;
+      // A generation that could not be recorded sits right after the last one that was.
+      const size_t from = history->current().value_or(history->size());
+      if (steps == 0 || steps > from) {
+        std::cout << "No earlier generation to go back to\n";
+        continue;
+      }
+      const auto start = std::chrono::steady_clock::now();
+      scan = scanner.Restore(*history->GoTo(from - steps));
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << fmt::format("Back to generation {}: {} candidates in {:.3f} s{}\n",
+                               from - steps,
+                               scan.candidates.count(),
+                               elapsed.count(),
+                               scan.snapshot ? "" : ", no snapshot so only eq and range are available");
+      continue;
+    }
+
+    NextScanQuery query;
+    if (const auto op = ParseNextScanOp(command)) {
+      if (!scan.snapshot) {
+        std::cout << "No snapshot of the previous scan, only eq and range are available\n";
+        continue;
+      }
+      query.op = *op;
+    } else if (command == "eq" || command == "range") {
+      std::string lower_text;
+      std::string upper_text;
+      input >> lower_text >> upper_text;
+      const auto lower = ParseScanValue(type, lower_text);
+      const auto upper = command == "range" ? ParseScanValue(type, upper_text) : lower;
+      if (!lower || !upper) {
+        std::cout << fmt::format("Invalid {} value\n", ToString(type));
+        continue;
+      }
+      query.predicate = command == "eq" ? MakeExactPredicate(*lower, epsilon) : MakeRangePredicate(*lower, *upper);
+    } else {
+      std::cout << fmt::format("Unknown command: {}\n", command);
+      continue;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    scan = scanner.NextScan(scan, query);
+    PrintSummary(scan, std::chrono::steady_clock::now() - start);
+    record();
+  }
+}
+
+bool EqualsIgnoringCase(std::string_view a, std::string_view b) {
+  return std::ranges::equal(a, b, [](char x, char y) {
+    return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+  });
+}
+
+// Formats `address` relative to the module containing it, if any, since module bases move between runs.
+std::string FormatCodeAddress(uintptr_t address, const std::vector<Module>& modules) {
+  const auto module = std::ranges::upper_bound(modules, address, {}, &Module::base);
+  if (module != modules.begin() && address < std::prev(module)->end()) {
+    return fmt::format("{:#018x} {}+{:#x}", address, std::prev(module)->name, address - std::prev(module)->base);
+  }
+  return fmt::format("{:#018x}", address);
+}
+
+// Narrows `signature_options` to the --module given, if any. Fails when the target has no such module loaded.
+bool RestrictToModule(const cxxopts::ParseResult& result,
+                      const Process& process,
+                      const std::vector<Module>& modules,
+                      SignatureScanOptions& signature_options) {
+  if (result.count("module") == 0) {
+    return true;
+  }
+  const auto& name = result["module"].as<std::string>();
+  const auto module =
+      std::ranges::find_if(modules, [&](const Module& module) { return EqualsIgnoringCase(module.name, name); });
+  if (module == modules.end()) {
+    std::cout << fmt::format("Module {} is not loaded in process {}\n", name, process.pid());
+    return false;
+  }
+  signature_options.begin = module->base;
+  signature_options.end = module->end();
+  return true;
+}
+
+// Scanner options of the byte pattern and string searches, which ignore the value scan options.
+ScanOptions MakeSearchScanOptions(const cxxopts::ParseResult& result, ReadMode mode) {
+  ScanOptions scan_options;
+  scan_options.read_mode = mode;
+  scan_options.read_ahead = result["read-ahead"].as<bool>();
+  scan_options.large_pages = result["large-pages"].as<bool>();
+  if (result.count("max-results") != 0) {
+    scan_options.max_results = result["max-results"].as<size_t>();
+  }
+  return scan_options;
+}
+
+// Prints the closing line of a byte pattern or string search.
+void PrintSearchSummary(std::string_view summary, const ScanStats& stats, std::chrono::duration<double> elapsed) {
+  std::cout << fmt::format("{}{} in {} regions ({:.1f} MiB, {} reads) in {:.3f} s\n",
+                           stats.truncated ? "Stopped at " : "",
+                           summary,
+                           stats.regions,
+                           static_cast<double>(stats.bytes_scanned) / (1 << 20),
+                           stats.read_calls,
+                           elapsed.count());
+}
+
+// Prints the matches of every signature of a --aob-file and returns how many were found at all.
+size_t PrintSignatureFileMatches(const std::vector<NamedSignature>& signatures,
+                                 const SignatureSetScanResult& scan,
+                                 const std::vector<Module>& modules) {
+  size_t resolved = 0;
+  for (size_t i = 0; i < signatures.size(); ++i) {
+    const auto& addresses = scan.addresses[i];
+    if (addresses.empty()) {
+      std::cout << fmt::format("{}: not found\n", signatures[i].name);
+      continue;
+    }
+    ++resolved;
+    std::cout << fmt::format("{}: {}{}\n",
+                             signatures[i].name,
+                             FormatCodeAddress(addresses.front(), modules),
+                             addresses.size() > 1 ? fmt::format(" and {} more", addresses.size() - 1) : "");
+  }
+  return resolved;
+}
+
+// Runs the --aob and --aob-file searches: compiles the patterns once and prints the addresses of the target they
+// match.
+int RunSignatureScan(const cxxopts::ParseResult& result) {
+  std::optional<Signature> signature;
+  std::optional<std::vector<NamedSignature>> signature_file;
+  if (result.count("aob-file") != 0) {
+    const auto& path = result["aob-file"].as<std::string>();
+    signature_file = LoadSignatureFile(path);
+    if (!signature_file) {
+      std::cout << fmt::format("Failed to load signatures from {}\n", path);
+      return 1;
+    }
+  } else {
+    const auto& pattern = result["aob"].as<std::string>();
+    signature = Signature::Parse(pattern);
+    if (!signature) {
+      std::cout << fmt::format("Invalid byte pattern: {}\n", pattern);
+      return 1;
+    }
+  }
+  auto process = OpenTargetProcess(result);
+  const auto mode = ParseReadModeOption(result);
+  if (!process || !mode) {
+    return 1;
+  }
+
+  const auto modules = process->QueryModules();
+  SignatureScanOptions signature_options{.code_only = !result["all-memory"].as<bool>()};
+  if (!RestrictToModule(result, *process, modules, signature_options)) {
+    return 1;
+  }
+
+  ThreadPool pool(result["threads"].as<size_t>(), result["numa"].as<bool>());
+  Scanner scanner(*process, pool, MakeSearchScanOptions(result, *mode));
+  const auto start = std::chrono::steady_clock::now();
+  ScanStats stats;
+  std::string summary;
+  if (signature_file) {
+    std::vector<Signature> signatures;
+    for (const auto& named : *signature_file) {
+      signatures.push_back(named.signature);
+    }
+    const auto scan = scanner.SignatureScan(SignatureSet(std::move(signatures)), signature_options);
+    stats = scan.stats;
+    const size_t resolved = PrintSignatureFileMatches(*signature_file, scan, modules);
+    summary = fmt::format("{} of {} signatures", resolved, signature_file->size());
+  } else {
+    const auto scan = scanner.SignatureScan(*signature, signature_options);
+    stats = scan.stats;
+    for (size_t i = 0; i < std::min(scan.addresses.size(), kMaxPrintedMatches); ++i) {
+      std::cout << FormatCodeAddress(scan.addresses[i], modules) << '\n';
+    }
+    summary = fmt::format("{} matches of {}", scan.addresses.size(), signature->ToString());
+  }
+  PrintSearchSummary(summary, stats, std::chrono::steady_clock::now() - start);
+  return 0;
+}
+
+// Runs the --string search over every readable region, or a single --module, in all requested encodings at once.
+int RunStringScan(const cxxopts::ParseResult& result) {
+  const auto& text = result["string"].as<std::string>();
+  const auto& encoding = result["encoding"].as<std::string>();
+  if (encoding != "utf8" && encoding != "utf16" && encoding != "both") {
+    std::cout << fmt::format("Unknown string encoding: {}\n", encoding);
+    return 1;
+  }
+  const auto pattern =
+      StringPattern::Create(text, encoding != "utf16", encoding != "utf8", result["ignore-case"].as<bool>());
+  if (!pattern) {
+    std::cout << fmt::format("Invalid string: {}\n", text);
+    return 1;
+  }
+  auto process = OpenTargetProcess(result);
+  const auto mode = ParseReadModeOption(result);
+  if (!process || !mode) {
+    return 1;
+  }
+
+  const auto modules = process->QueryModules();
+  SignatureScanOptions signature_options{.code_only = false};
+  if (!RestrictToModule(result, *process, modules, signature_options)) {
+    return 1;
+  }
+
+  ThreadPool pool(result["threads"].as<size_t>(), result["numa"].as<bool>());
+  Scanner scanner(*process, pool, MakeSearchScanOptions(result, *mode));
+  const auto start = std::chrono::steady_clock::now();
+  const auto scan = scanner.StringScan(*pattern, signature_options);
+  for (size_t i = 0; i < std::min(scan.matches.size(), kMaxPrintedMatches); ++i) {
+    const StringMatch& match = scan.matches[i];
+    std::cout << fmt::format("{} {}\n", FormatCodeAddress(match.address, modules), ToString(match.encoding));
+  }
+  PrintSearchSummary(fmt::format("{} matches of \"{}\"", scan.matches.size(), text),
+                     scan.stats,
+                     std::chrono::steady_clock::now() - start);
+  return 0;
+}
+
+}  // namespace
+
+void AddScanOptions(cxxopts::Options& options) {
+  auto scan_options = options.add_options("scan");
+  scan_options("t,type",
+               "Value type: i8, u8, i16, u16, i32, u32, i64, u64, f32, f64",
+               cxxopts::value<std::string>()->default_value("i32"));
+  scan_options("v,value",
+               "Value to search for, or the lower bound with --upper. Omit for an unknown initial value scan",
+               cxxopts::value<std::string>());
+  scan_options("u,upper", "Inclusive upper bound, turns the scan into a range scan", cxxopts::value<std::string>());
+  scan_options("group",
+               "Search for a group of values in one pass instead of a single value: type:value or "
+               "type:lower..upper fields, each after the previous one unless +offset places it, "
+               "e.g. \"f32:100 f32:100 +0x10 i32:42\"",
+               cxxopts::value<std::string>());
+  scan_options("e,epsilon",
+               "Tolerance when matching f32 and f64 values",
+               cxxopts::value<double>()->default_value("0"));
+  scan_options("a,alignment",
+               "Candidate alignment in bytes, a power of two or 0 for the natural alignment of the type",
+               cxxopts::value<size_t>()->default_value("0"));
+  scan_options("snapshot-dir",
+               "Directory for the memory-mapped snapshot files used by next scans, empty to disable snapshots",
+               cxxopts::value<std::string>()->default_value(std::filesystem::temp_directory_path().string()));
+  scan_options("i,interactive", "Read next-scan commands from stdin after the first scan");
+  scan_options("checkpoint-limit",
+               "Memory in MiB the compressed undo checkpoint of each interactive scan generation may use, beyond it "
+               "the rest of the checkpoint goes to --snapshot-dir. 0 disables undo",
+               cxxopts::value<size_t>()->default_value("64"));
+  scan_options("aob",
+               "Search for a byte pattern instead of a value, with ?? for wildcards, e.g. \"48 8B 05 ?? ?? ?? ?? 89\"",
+               cxxopts::value<std::string>());
+  scan_options("aob-file",
+               "Resolve every signature of this JSON file in one pass, an array of {\"name\": ..., \"pattern\": ...}",
+               cxxopts::value<std::string>());
+  scan_options("string",
+               "Search for a string instead of a value, in UTF-8 and UTF-16LE unless --encoding says otherwise",
+               cxxopts::value<std::string>());
+  scan_options("encoding",
+               "Encodings searched by --string: utf8, utf16 or both",
+               cxxopts::value<std::string>()->default_value("both"));
+  scan_options("ignore-case", "Match ASCII letters of --string in either case");
+  scan_options("module",
+               "Only search this module for --aob, --aob-file and --string",
+               cxxopts::value<std::string>());
+  scan_options("all-memory", "Search every readable region for signatures instead of only executable module code");
+}
+
+int RunScanCommand(const cxxopts::ParseResult& result) {
+  if (result.count("aob") != 0 || result.count("aob-file") != 0) {
+    return RunSignatureScan(result);
+  }
+  if (result.count("string") != 0) {
+    return RunStringScan(result);
+  }
+  if (result.count("upper") != 0 && result.count("value") == 0) {
+    std::cout << "--upper needs a --value for the lower bound\n";
+    return 1;
+  }
+  // A group scan takes its types from the pattern; later next scans refine its first field.
+  std::optional<GroupPattern> group;
+  if (result.count("group") != 0) {
+    if (result.count("value") != 0) {
+      std::cout << "--group takes its values from the pattern and cannot be combined with --value or --upper\n";
+      return 1;
+    }
+    const auto& text = result["group"].as<std::string>();
+    group = GroupPattern::Parse(text, result["epsilon"].as<double>());
+    if (!group) {
+      std::cout << fmt::format("Invalid group pattern: {}\n", text);
+      return 1;
+    }
+  }
+  const auto type = group ? std::optional(group->first().type) : ParseValueType(result["type"].as<std::string>());
+  if (!type) {
+    std::cout << fmt::format("Unknown value type: {}\n", result["type"].as<std::string>());
+    return 1;
+  }
+
+  // Without --value every aligned address is kept as a candidate for later comparisons.
+  std::optional<MatchPredicate> predicate;
+  if (result.count("value") != 0) {
+    const auto value = ParseValueOption(result, "value", *type);
+    if (!value) {
+      return 1;
+    }
+    predicate = MakeExactPredicate(*value, result["epsilon"].as<double>());
+    if (result.count("upper") != 0) {
+      const auto upper = ParseValueOption(result, "upper", *type);
+      if (!upper) {
+        return 1;
+      }
+      predicate = MakeRangePredicate(*value, *upper);
+    }
+  }
+
+  const size_t alignment = result["alignment"].as<size_t>();
+  if (!IsValidAlignment(alignment)) {
+    std::cout << fmt::format("Alignment must be 0 or a power of two: {}\n", alignment);
+    return 1;
+  }
+
+  auto process = OpenTargetProcess(result);
+  const auto mode = ParseReadModeOption(result);
+  if (!process || !mode) {
+    return 1;
+  }
+
+  ThreadPool pool(result["threads"].as<size_t>(), result["numa"].as<bool>());
+  Scanner scanner(*process,
+                  pool,
+                  {.alignment = alignment,
+                   .read_mode = *mode,
+                   .read_ahead = result["read-ahead"].as<bool>(),
+                   .large_pages = result["large-pages"].as<bool>(),
+                   .snapshot_dir = result["snapshot-dir"].as<std::string>(),
+                   .max_results = result.count("max-results") != 0 ? result["max-results"].as<size_t>() : 0});
+
+  const auto start = std::chrono::steady_clock::now();
+  ResultStream stream;
+  ScanResult scan;
+  std::thread scan_thread([&] {
+    if (group) {
+      scan = scanner.GroupScan(*group, &stream);
+    } else {
+      scan = predicate ? scanner.FirstScan(*predicate, &stream) : scanner.UnknownScan(*type, &stream);
+    }
+  });
+  PrintStreamed(stream, start);
+  scan_thread.join();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << fmt::format("Scanned {} regions ({} queries, {:.1f} MiB in place) with {} threads and {} kernels\n",
+                           scan.stats.regions,
+                           scan.stats.region_queries,
+                           static_cast<double>(scan.stats.bytes_mapped) / (1 << 20),
+                           pool.size(),
+                           ToString(ActiveKernelIsa()));
+  PrintSummary(scan, elapsed);
+  if (result["interactive"].as<bool>()) {
+    const size_t checkpoint_limit = result["checkpoint-limit"].as<size_t>();
+    std::optional<ScanHistory> history;
+    if (checkpoint_limit != 0) {
+      history.emplace(CheckpointOptions{.max_memory = checkpoint_limit << 20,
+                                        .spill_dir = result["snapshot-dir"].as<std::string>()});
+    }
+    RunNextScans(scanner, pool, std::move(scan), result["epsilon"].as<double>(), history ? &*history : nullptr);
+  }
+  return 0;
+}
+
+}  // namespace maia::cli
@@ -0,0 +1,95 @@
+#include <iostream>
+
+#include <fmt/core.h>
+
+#include "maiascan/cli/commands.hpp"
+#include "maiascan/core/perf.hpp"
+
+namespace maia::cli {
+
+void AddTargetOptions(cxxopts::Options& options) {
+  auto target_options = options.add_options("target");
+  target_options("p,pid", "Target process id", cxxopts::value<uint32_t>());
+  target_options("dump",
+                 "Scan or search pointers in a minidump or raw region dump instead of a running process",
+                 cxxopts::value<std::string>());
+  target_options("dump-base",
+                 "Address of the first byte of a raw region dump",
+                 cxxopts::value<std::string>()->default_value("0x10000"));
+  target_options("j,threads",
+                 "Number of scan threads, 0 for one per hardware thread",
+                 cxxopts::value<size_t>()->default_value("0"));
+  target_options("mode",
+                 "How target memory is read: read (ReadProcessMemory) or mapped (scan section-backed regions in place)",
+                 cxxopts::value<std::string>()->default_value("read"));
+  target_options("read-ahead",
+                 "Read the next shard of every scan thread on a helper thread while the current one is scanned");
+  target_options("numa",
+                 "Pin scan threads to NUMA nodes and allocate their read buffers on the node they run on");
+  target_options("large-pages",
+                 "Back read buffers and candidate storage with large pages. Needs SeLockMemoryPrivilege, falls back to "
+                 "normal pages without it");
+  target_options("max-results",
+                 "Stop after this many results: candidates of a scan (default unlimited) or pointer paths (default "
+                 "10000)",
+                 cxxopts::value<size_t>());
+  target_options("perf-log",
+                 "Write per-phase timings and counters of every scan to this file as JSON lines",
+                 cxxopts::value<std::string>());
+}
+
+bool OpenPerfLogOption(const cxxopts::ParseResult& result) {
+  if (result.count("perf-log") == 0) {
+    return true;
+  }
+  const auto& path = result["perf-log"].as<std::string>();
+  if (!OpenPerfLog(path)) {
+    std::cout << fmt::format("Failed to create performance log {}\n", path);
+    return false;
+  }
+  return true;
+}
+
+std::optional<Process> OpenTargetProcess(const cxxopts::ParseResult& result, ProcessAccess access) {
+  if (result.count("pid") == 0 && result.count("dump") != 0) {
+    const auto base = ParseValueOption(result, "dump-base", ValueType::kUInt64);
+    if (!base) {
+      return std::nullopt;
+    }
+    const auto& path = result["dump"].as<std::string>();
+    auto dump = Process::OpenDump(path, static_cast<uintptr_t>(base->As<uint64_t>()));
+    if (!dump) {
+      std::cout << fmt::format("Failed to open dump {}\n", path);
+    }
+    return dump;
+  }
+  const auto pid = result["pid"].as<uint32_t>();
+  auto process = Process::Open(pid, access);
+  if (!process) {
+    std::cout << fmt::format("Failed to open process {}\n", pid);
+  }
+  return process;
+}
+
+std::optional<ReadMode> ParseReadModeOption(const cxxopts::ParseResult& result) {
+  const auto& mode = result["mode"].as<std::string>();
+  if (mode == "read") {
+    return ReadMode::kCopy;
+  }
+  if (mode == "mapped") {
+    return ReadMode::kMapped;
+  }
+  std::cout << fmt::format("Unknown read mode: {}\n", mode);
+  return std::nullopt;
+}
+
+std::optional<ScanValue> ParseValueOption(const cxxopts::ParseResult& result, const std::string& name, ValueType type) {
+  const auto& text = result[name].as<std::string>();
+  auto value = ParseScanValue(type, text);
+  if (!value) {
+    std::cout << fmt::format("Invalid {} value: {}\n", ToString(type), text);
+  }
+  return value;
+}
+
+}  // namespace maia::cli
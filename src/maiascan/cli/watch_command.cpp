@@ -0,0 +1,166 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "maiascan/cli/commands.hpp"
+#include "maiascan/watch/freezer.hpp"
+#include "maiascan/watch/watcher.hpp"
+
+namespace maia::cli {
+
+namespace {
+
+struct WatchSpec {
+  uintptr_t address{};
+  ValueType type{};
+};
+
+// Parses ADDRESS[:TYPE], falling back to `default_type`.
+std::optional<WatchSpec> ParseWatchSpec(std::string_view text, ValueType default_type) {
+  const size_t colon = text.find(':');
+  const auto address = ParseScanValue(ValueType::kUInt64, text.substr(0, colon));
+  const auto type = colon == std::string_view::npos ? default_type : ParseValueType(text.substr(colon + 1));
+  if (!address || !type) {
+    return std::nullopt;
+  }
+  return WatchSpec{.address = static_cast<uintptr_t>(address->As<uint64_t>()), .type = *type};
+}
+
+struct FreezeSpec {
+  uintptr_t address{};
+  ScanValue value;
+};
+
+// Parses ADDRESS[:TYPE]=VALUE, falling back to `default_type`.
+std::optional<FreezeSpec> ParseFreezeSpec(std::string_view text, ValueType default_type) {
+  const size_t equals = text.find('=');
+  if (equals == std::string_view::npos) {
+    return std::nullopt;
+  }
+  const auto spec = ParseWatchSpec(text.substr(0, equals), default_type);
+  const auto value = spec ? ParseScanValue(spec->type, text.substr(equals + 1)) : std::nullopt;
+  if (!value) {
+    return std::nullopt;
+  }
+  return FreezeSpec{.address = spec->address, .value = *value};
+}
+
+void PrintFreezeStats(const FreezeStats& stats) {
+  std::cout << fmt::format("Froze for {} ticks with {} writes each, {} failed, latency {:.1f} us last, {:.1f} us mean, "
+                           "{:.1f} us max\n",
+                           stats.ticks,
+                           stats.write_calls,
+                           stats.failed_writes,
+                           static_cast<double>(stats.last_latency.count()) / 1000,
+                           static_cast<double>(stats.mean_latency.count()) / 1000,
+                           static_cast<double>(stats.max_latency.count()) / 1000);
+}
+
+}  // namespace
+
+void AddWatchOptions(cxxopts::Options& options) {
+  auto watch_options = options.add_options("watch");
+  watch_options("w,watch",
+                "Address to watch as ADDRESS[:TYPE], with the type defaulting to --type. Can be repeated",
+                cxxopts::value<std::vector<std::string>>());
+  watch_options("period", "Refresh period in milliseconds", cxxopts::value<uint32_t>()->default_value("16"));
+  watch_options("freeze",
+                "Keep writing a value as ADDRESS[:TYPE]=VALUE, with the type defaulting to --type. Can be repeated",
+                cxxopts::value<std::vector<std::string>>());
+  watch_options("freeze-period",
+                "Milliseconds between rewrites of frozen values",
+                cxxopts::value<uint32_t>()->default_value("10"));
+  watch_options("duration",
+                "Seconds to keep watching, 0 to watch until interrupted",
+                cxxopts::value<double>()->default_value("0"));
+}
+
+int RunWatchCommand(const cxxopts::ParseResult& result) {
+  const auto default_type = ParseValueType(result["type"].as<std::string>());
+  if (!default_type) {
+    std::cout << fmt::format("Unknown value type: {}\n", result["type"].as<std::string>());
+    return 1;
+  }
+  std::vector<WatchSpec> specs;
+  if (result.count("watch") != 0) {
+    for (const auto& text : result["watch"].as<std::vector<std::string>>()) {
+      const auto spec = ParseWatchSpec(text, *default_type);
+      if (!spec) {
+        std::cout << fmt::format("Invalid watch: {}, expected ADDRESS[:TYPE]\n", text);
+        return 1;
+      }
+      specs.push_back(*spec);
+    }
+  }
+  std::vector<FreezeSpec> frozen;
+  if (result.count("freeze") != 0) {
+    for (const auto& text : result["freeze"].as<std::vector<std::string>>()) {
+      const auto spec = ParseFreezeSpec(text, *default_type);
+      if (!spec) {
+        std::cout << fmt::format("Invalid freeze: {}, expected ADDRESS[:TYPE]=VALUE\n", text);
+        return 1;
+      }
+      frozen.push_back(*spec);
+    }
+  }
+  if (specs.empty() && frozen.empty()) {
+    std::cout << "--watch or --freeze is required to watch values\n";
+    return 1;
+  }
+  auto process = OpenTargetProcess(result, frozen.empty() ? ProcessAccess::kRead : ProcessAccess::kReadWrite);
+  if (!process) {
+    return 1;
+  }
+
+  Freezer freezer(*process);
+  for (const auto& spec : frozen) {
+    freezer.Freeze(spec.address, spec.value);
+  }
+  if (!frozen.empty()) {
+    freezer.Start(std::chrono::milliseconds(result["freeze-period"].as<uint32_t>()));
+  }
+
+  // Ids are handed out in order, so they index `specs`.
+  Watcher watcher(*process);
+  for (const auto& spec : specs) {
+    watcher.Add(spec.address, spec.type);
+  }
+  const std::chrono::milliseconds period(result["period"].as<uint32_t>());
+  const std::chrono::duration<double> duration(result["duration"].as<double>());
+  watcher.Start(period);
+
+  std::vector<WatchUpdate> updates(1024);
+  const auto start = std::chrono::steady_clock::now();
+  while (duration.count() <= 0 || std::chrono::steady_clock::now() - start < duration) {
+    std::this_thread::sleep_for(period);
+    for (size_t count = watcher.Poll(updates); count != 0; count = watcher.Poll(updates)) {
+      for (const auto& update : std::span(updates).first(count)) {
+        const auto& spec = specs[update.id];
+        std::cout << fmt::format("{:>8} {:#018x} {}\n",
+                                 update.tick,
+                                 spec.address,
+                                 update.readable ? FormatValue(spec.type, update.value.bytes.data()) : "unreadable");
+      }
+    }
+    std::cout << std::flush;
+  }
+  watcher.Stop();
+  freezer.Stop();
+
+  if (!frozen.empty()) {
+    PrintFreezeStats(freezer.stats());
+  }
+  const WatchStats stats = watcher.stats();
+  std::cout << fmt::format("{} ticks, {} updates, last tick {:.1f} us with {} reads\n",
+                           stats.ticks,
+                           stats.published,
+                           static_cast<double>(stats.last_tick.count()) / 1000,
+                           stats.read_calls);
+  return 0;
+}
+
+}  // namespace maia::cli
@@ -0,0 +1,91 @@
+#include "maiascan/core/arena.hpp"
+
+#include <algorithm>
+
+namespace maia {
+
+Arena::Arena(size_t worker_count, ChunkAllocator* allocator)
+    : allocator_(allocator != nullptr ? *allocator : OsChunkAllocator()), workers_(std::max<size_t>(worker_count, 1)) {}
+
+Arena::~Arena() {
+  for (const auto& worker : workers_) {
+    for (const auto chunk : worker.chunks) {
+      allocator_.FreeChunk(chunk);
+    }
+  }
+}
+
+std::span<std::byte> Arena::Allocate(size_t worker_index, size_t size, size_t alignment) {
+  Worker& worker = workers_[worker_index];
+  while (worker.current < worker.chunks.size()) {
+    const std::span<std::byte> chunk = worker.chunks[worker.current];
+    // Chunks are page-aligned, so aligning the offset aligns the address.
+    const size_t offset = (worker.used + alignment - 1) & ~(alignment - 1);
+    if (offset <= chunk.size() && size <= chunk.size() - offset) {
+      worker.used = offset + size;
+      return chunk.subspan(offset, size);
+    }
+    // Chunks dedicated to earlier large allocations are reused once they are reached again after a reset.
+    worker.used_before += chunk.size();
+    worker.used = 0;
+    ++worker.current;
+  }
+
+  const auto chunk = allocator_.AllocateChunk(std::max(size, kChunkSize));
+  if (chunk.size() < size) {
+    if (!chunk.empty()) {
+      allocator_.FreeChunk(chunk);
+    }
+    return {};
+  }
+  worker.chunks.push_back(chunk);
+  worker.used = size;
+  return chunk.first(size);
+}
+
+void Arena::Shrink(size_t worker_index, std::span<std::byte> allocation, size_t new_size) {
+  Worker& worker = workers_[worker_index];
+  if (new_size < allocation.size() && worker.current < worker.chunks.size() &&
+      allocation.data() + allocation.size() == worker.chunks[worker.current].data() + worker.used) {
+    worker.used -= allocation.size() - new_size;
+  }
+}
+
+void Arena::Reset() {
+  for (auto& worker : workers_) {
+    worker.current = 0;
+    worker.used = 0;
+    worker.used_before = 0;
+  }
+}
+
+size_t Arena::bytes_used() const {
+  size_t total = 0;
+  for (const auto& worker : workers_) {
+    total += worker.used_before + worker.used;
+  }
+  return total;
+}
+
+size_t Arena::bytes_reserved() const {
+  size_t total = 0;
+  for (const auto& worker : workers_) {
+    for (const auto chunk : worker.chunks) {
+      total += chunk.size();
+    }
+  }
+  return total;
+}
+
+std::shared_ptr<Arena> ArenaPool::Acquire() {
+  for (auto& arena : arenas_) {
+    if (arena.use_count() == 1) {
+      arena->Reset();
+      return arena;
+    }
+  }
+  arenas_.push_back(std::make_shared<Arena>(worker_count_, allocator_));
+  return arenas_.back();
+}
+
+}  // namespace maia
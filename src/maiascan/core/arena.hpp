@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "maiascan/core/page_buffer.hpp"
+
+namespace maia {
+
+// Monotonic allocator for data that dies all at once, such as everything one scan produces. Every worker bumps a
+// cursor through chunks of its own, so allocating needs no locking, and Reset() rewinds the cursors while keeping the
+// chunks, so long sessions reuse the same memory instead of fragmenting the heap. Chunks come from a ChunkAllocator,
+// straight from the OS unless the embedder provides its own.
+//
+// Memory is never freed individually and destructors are never run, so only trivially destructible data belongs here.
+class Arena {
+ public:
+  static constexpr size_t kChunkSize = size_t{1} << 20;
+
+  // `allocator`, when given, must outlive the arena.
+  explicit Arena(size_t worker_count, ChunkAllocator* allocator = nullptr);
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena();
+
+  // Returns `size` bytes aligned to `alignment` (a power of two no larger than a page) from the chunks of `worker`, or
+  // an empty span if the OS is out of memory. Distinct workers may allocate concurrently.
+  std::span<std::byte> Allocate(size_t worker, size_t size, size_t alignment = alignof(std::max_align_t));
+
+  // Gives back the tail of `allocation` beyond `new_size` bytes if it is the latest allocation of `worker`, which lets
+  // callers allocate for the worst case and keep only what they used. Does nothing otherwise.
+  void Shrink(size_t worker, std::span<std::byte> allocation, size_t new_size);
+
+  // Uninitialized storage for `count` objects of `T`, to be filled by assignment or copying. Empty if the OS is
+  // out of memory.
+  template <typename T>
+  std::span<T> AllocateArray(size_t worker, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+    const auto bytes = Allocate(worker, count * sizeof(T), alignof(T));
+    return {reinterpret_cast<T*>(bytes.data()), bytes.size() / sizeof(T)};
+  }
+
+  // Shrinks an array returned by AllocateArray() to its first `count` elements.
+  template <typename T>
+  std::span<T> ShrinkArray(size_t worker, std::span<T> array, size_t count) {
+    Shrink(worker, std::as_writable_bytes(array), count * sizeof(T));
+    return array.first(count);
+  }
+
+  // Makes all memory available again without returning it to the OS. Everything allocated before is invalidated.
+  void Reset();
+
+  size_t worker_count() const { return workers_.size(); }
+
+  // Bytes handed out since the last reset, and bytes held in chunks. Only meaningful while no allocation is in flight.
+  size_t bytes_used() const;
+  size_t bytes_reserved() const;
+
+ private:
+  // Padded so that workers bumping their own cursors do not share cache lines.
+  struct alignas(64) Worker {
+    std::vector<std::span<std::byte>> chunks;
+    size_t current{};
+    size_t used{};
+    // Bytes used in the chunks before `current`, including what alignment and chunk switches skipped.
+    size_t used_before{};
+  };
+
+  ChunkAllocator& allocator_;
+  std::vector<Worker> workers_;
+};
+
+// Hands out arenas for successive scan generations. Results keep the arena of their generation alive through a
+// shared_ptr; Acquire() resets and reuses any arena no result references anymore and only creates a new one when every
+// arena is still in use. Not thread-safe.
+class ArenaPool {
+ public:
+  explicit ArenaPool(size_t worker_count, ChunkAllocator* allocator = nullptr)
+      : worker_count_(worker_count), allocator_(allocator) {}
+
+  std::shared_ptr<Arena> Acquire();
+
+ private:
+  size_t worker_count_;
+  ChunkAllocator* allocator_;
+  std::vector<std::shared_ptr<Arena>> arenas_;
+};
+
+}  // namespace maia
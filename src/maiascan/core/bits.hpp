@@ -0,0 +1,45 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace maia {
+
+// Helpers for bitmaps stored as little-endian arrays of 64-bit words, where bit `i` lives in word `i / 64`.
+
+constexpr size_t WordCount(size_t bit_count) { return (bit_count + 63) / 64; }
+
+inline void SetBit(uint64_t* words, size_t bit) { words[bit / 64] |= uint64_t{1} << (bit % 64); }
+
+inline void ClearBit(uint64_t* words, size_t bit) { words[bit / 64] &= ~(uint64_t{1} << (bit % 64)); }
+
+inline bool TestBit(const uint64_t* words, size_t bit) { return ((words[bit / 64] >> (bit % 64)) & 1) != 0; }
+
+// Calls `fn(bit)` for every set bit below `bit_count` in ascending order. If `fn` returns bool, returning false stops
+// the walk and makes ForEachSetBit() return false.
+template <typename Fn>
+bool ForEachSetBit(const uint64_t* words, size_t bit_count, Fn&& fn) {
+  const size_t word_count = WordCount(bit_count);
+  for (size_t i = 0; i < word_count; ++i) {
+    uint64_t word = words[i];
+    if (i + 1 == word_count && bit_count % 64 != 0) {
+      word &= (uint64_t{1} << (bit_count % 64)) - 1;
+    }
+    while (word != 0) {
+      const size_t bit = i * 64 + static_cast<size_t>(std::countr_zero(word));
+      if constexpr (std::is_same_v<std::invoke_result_t<Fn&, size_t>, bool>) {
+        if (!fn(bit)) {
+          return false;
+        }
+      } else {
+        fn(bit);
+      }
+      word &= word - 1;
+    }
+  }
+  return true;
+}
+
+}  // namespace maia
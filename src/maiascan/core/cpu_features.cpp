@@ -0,0 +1,76 @@
+#include "maiascan/core/cpu_features.hpp"
+
+#include <array>
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace maia {
+
+namespace {
+
+struct CpuidRegisters {
+  uint32_t eax;
+  uint32_t ebx;
+  uint32_t ecx;
+  uint32_t edx;
+};
+
+CpuidRegisters Cpuid(uint32_t leaf, uint32_t subleaf) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  std::array<int, 4> regs{};
+  __cpuidex(regs.data(), static_cast<int>(leaf), static_cast<int>(subleaf));
+  return {static_cast<uint32_t>(regs[0]),
+          static_cast<uint32_t>(regs[1]),
+          static_cast<uint32_t>(regs[2]),
+          static_cast<uint32_t>(regs[3])};
+#else
+  CpuidRegisters regs{};
+  __cpuid_count(leaf, subleaf, regs.eax, regs.ebx, regs.ecx, regs.edx);
+  return regs;
+#endif
+}
+
+uint64_t ReadXcr0() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return _xgetbv(0);
+#else
+  // Issued as raw asm so that this translation unit does not have to be compiled with -mxsave.
+  uint32_t eax = 0;
+  uint32_t edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (uint64_t{edx} << 32) | eax;
+#endif
+}
+
+CpuFeatures Detect() {
+  CpuFeatures features;
+  const uint32_t max_leaf = Cpuid(0, 0).eax;
+  if (max_leaf < 1) {
+    return features;
+  }
+  const auto leaf1 = Cpuid(1, 0);
+  features.sse41 = (leaf1.ecx & (1U << 19)) != 0;
+
+  const bool osxsave = (leaf1.ecx & (1U << 27)) != 0;
+  const bool avx = (leaf1.ecx & (1U << 28)) != 0;
+  // XCR0 bits 1 and 2: the OS preserves XMM and YMM registers.
+  const bool ymm_enabled = osxsave && (ReadXcr0() & 0x6) == 0x6;
+  if (max_leaf >= 7 && avx && ymm_enabled) {
+    features.avx2 = (Cpuid(7, 0).ebx & (1U << 5)) != 0;
+  }
+  return features;
+}
+
+}  // namespace
+
+const CpuFeatures& GetCpuFeatures() {
+  static const CpuFeatures features = Detect();
+  return features;
+}
+
+}  // namespace maia
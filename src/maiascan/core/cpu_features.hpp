@@ -0,0 +1,14 @@
+#pragma once
+
+namespace maia {
+
+struct CpuFeatures {
+  bool sse41{};
+  // Only reported when the OS also saves the upper YMM state across context switches.
+  bool avx2{};
+};
+
+// Queried once with CPUID on first use.
+const CpuFeatures& GetCpuFeatures();
+
+}  // namespace maia
@@ -0,0 +1,361 @@
+#include "maiascan/core/dump_file.hpp"
+
+#include <windows.h>
+
+#include <dbghelp.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace maia {
+
+namespace {
+
+// Upper bounds on counts read from the file, so that a corrupt dump fails instead of allocating without limit.
+constexpr size_t kMaxStreams = 1 << 16;
+constexpr size_t kMaxEntries = size_t{1} << 24;
+
+size_t AllocationGranularity() {
+  static const size_t granularity = [] {
+    SYSTEM_INFO info{};
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwAllocationGranularity);
+  }();
+  return granularity;
+}
+
+// Memory captured at `base` whose bytes start at `file_offset`.
+struct CapturedRange {
+  uintptr_t base;
+  size_t size;
+  uint64_t file_offset;
+};
+
+// The file name part of a module path, which is how live processes name their modules too.
+std::string ModuleName(std::span<const wchar_t> path) {
+  const auto separator = std::find_if(path.rbegin(), path.rend(), [](wchar_t c) { return c == L'\\' || c == L'/'; });
+  const std::span<const wchar_t> name = path.subspan(static_cast<size_t>(path.rend() - separator));
+  if (name.empty()) {
+    return {};
+  }
+  const int wide_size = static_cast<int>(name.size());
+  const int size = WideCharToMultiByte(CP_UTF8, 0, name.data(), wide_size, nullptr, 0, nullptr, nullptr);
+  std::string result(static_cast<size_t>(std::max(size, 0)), '\0');
+  WideCharToMultiByte(CP_UTF8, 0, name.data(), wide_size, result.data(), size, nullptr, nullptr);
+  return result;
+}
+
+}  // namespace
+
+DumpView::DumpView(DumpView&& other) noexcept
+    : view_(std::exchange(other.view_, nullptr)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+DumpView& DumpView::operator=(DumpView&& other) noexcept {
+  if (this != &other) {
+    if (view_ != nullptr) {
+      UnmapViewOfFile(view_);
+    }
+    view_ = std::exchange(other.view_, nullptr);
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+DumpView::~DumpView() {
+  if (view_ != nullptr) {
+    UnmapViewOfFile(view_);
+  }
+}
+
+std::unique_ptr<DumpFile> DumpFile::Open(const std::filesystem::path& path, uintptr_t raw_base) {
+  HANDLE file = CreateFileW(path.wstring().c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return nullptr;
+  }
+  // Views of the mapping keep the file open, so its handle is not needed past this point.
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return nullptr;
+  }
+  auto dump = std::unique_ptr<DumpFile>(new DumpFile(mapping, static_cast<uint64_t>(size.QuadPart)));
+
+  uint32_t signature = 0;
+  if (dump->ReadAt(0, std::as_writable_bytes(std::span(&signature, 1))) && signature == MINIDUMP_SIGNATURE) {
+    if (!dump->ParseMinidump() || dump->regions_.empty()) {
+      return nullptr;
+    }
+    return dump;
+  }
+  dump->regions_.push_back({.base = raw_base,
+                            .size = static_cast<size_t>(dump->file_size_),
+                            .allocation_base = raw_base,
+                            .protect = PAGE_READWRITE,
+                            .type = MEM_PRIVATE,
+                            .state = MEM_COMMIT});
+  dump->file_offsets_.push_back(0);
+  return dump;
+}
+
+DumpFile::~DumpFile() { CloseHandle(mapping_); }
+
+bool DumpFile::ParseMinidump() {
+  MINIDUMP_HEADER header{};
+  if (!ReadAt(0, std::as_writable_bytes(std::span(&header, 1))) || header.NumberOfStreams > kMaxStreams) {
+    return false;
+  }
+  std::vector<MINIDUMP_DIRECTORY> directory(header.NumberOfStreams);
+  if (!ReadAt(header.StreamDirectoryRva, std::as_writable_bytes(std::span(directory)))) {
+    return false;
+  }
+
+  std::vector<CapturedRange> ranges;
+  std::vector<MINIDUMP_MEMORY_INFO> infos;
+  for (const MINIDUMP_DIRECTORY& stream : directory) {
+    const RVA rva = stream.Location.Rva;
+    switch (stream.StreamType) {
+      case Memory64ListStream: {
+        MINIDUMP_MEMORY64_LIST list{};
+        if (!ReadAt(rva, std::as_writable_bytes(std::span(&list, 1))) || list.NumberOfMemoryRanges > kMaxEntries) {
+          return false;
+        }
+        // Full dumps store the bytes of all ranges back to back from BaseRva on.
+        std::vector<MINIDUMP_MEMORY_DESCRIPTOR64> descriptors(static_cast<size_t>(list.NumberOfMemoryRanges));
+        if (!ReadAt(rva + sizeof(list), std::as_writable_bytes(std::span(descriptors)))) {
+          return false;
+        }
+        uint64_t offset = list.BaseRva;
+        for (const auto& descriptor : descriptors) {
+          ranges.push_back({.base = static_cast<uintptr_t>(descriptor.StartOfMemoryRange),
+                            .size = static_cast<size_t>(descriptor.DataSize),
+                            .file_offset = offset});
+          offset += descriptor.DataSize;
+        }
+        break;
+      }
+      case MemoryListStream: {
+        ULONG32 count = 0;
+        if (!ReadAt(rva, std::as_writable_bytes(std::span(&count, 1))) || count > kMaxEntries) {
+          return false;
+        }
+        std::vector<MINIDUMP_MEMORY_DESCRIPTOR> descriptors(count);
+        if (!ReadAt(rva + sizeof(count), std::as_writable_bytes(std::span(descriptors)))) {
+          return false;
+        }
+        for (const auto& descriptor : descriptors) {
+          ranges.push_back({.base = static_cast<uintptr_t>(descriptor.StartOfMemoryRange),
+                            .size = descriptor.Memory.DataSize,
+                            .file_offset = descriptor.Memory.Rva});
+        }
+        break;
+      }
+      case MemoryInfoListStream: {
+        MINIDUMP_MEMORY_INFO_LIST list{};
+        if (!ReadAt(rva, std::as_writable_bytes(std::span(&list, 1))) || list.NumberOfEntries > kMaxEntries ||
+            list.SizeOfEntry == 0) {
+          return false;
+        }
+        // Entries may grow in later versions of the format, so they are stepped through by their declared size.
+        std::vector<std::byte> entries(static_cast<size_t>(list.NumberOfEntries) * list.SizeOfEntry);
+        if (!ReadAt(uint64_t{rva} + list.SizeOfHeader, entries)) {
+          return false;
+        }
+        infos.resize(static_cast<size_t>(list.NumberOfEntries));
+        const size_t entry_size = std::min<size_t>(list.SizeOfEntry, sizeof(MINIDUMP_MEMORY_INFO));
+        for (size_t i = 0; i < infos.size(); ++i) {
+          std::memcpy(&infos[i], entries.data() + i * list.SizeOfEntry, entry_size);
+        }
+        break;
+      }
+      case ModuleListStream: {
+        ULONG32 count = 0;
+        if (!ReadAt(rva, std::as_writable_bytes(std::span(&count, 1))) || count > kMaxEntries) {
+          return false;
+        }
+        std::vector<MINIDUMP_MODULE> modules(count);
+        if (!ReadAt(rva + sizeof(count), std::as_writable_bytes(std::span(modules)))) {
+          return false;
+        }
+        for (const MINIDUMP_MODULE& module : modules) {
+          ULONG32 name_size = 0;
+          std::wstring path;
+          if (ReadAt(module.ModuleNameRva, std::as_writable_bytes(std::span(&name_size, 1)))) {
+            path.resize(name_size / sizeof(wchar_t));
+            if (!ReadAt(uint64_t{module.ModuleNameRva} + sizeof(name_size), std::as_writable_bytes(std::span(path)))) {
+              path.clear();
+            }
+          }
+          modules_.push_back({.name = ModuleName(path),
+                              .base = static_cast<uintptr_t>(module.BaseOfImage),
+                              .size = module.SizeOfImage});
+        }
+        break;
+      }
+      case MiscInfoStream: {
+        MINIDUMP_MISC_INFO info{};
+        const bool read = ReadAt(rva, std::as_writable_bytes(std::span(&info, 1)));
+        if (read && (info.Flags1 & MINIDUMP_MISC1_PROCESS_ID) != 0) {
+          pid_ = info.ProcessId;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  std::ranges::sort(ranges, {}, &CapturedRange::base);
+  std::ranges::sort(infos, {}, &MINIDUMP_MEMORY_INFO::BaseAddress);
+  std::ranges::sort(modules_, {}, &Module::base);
+
+  // Captured ranges are split where the reported protection changes. Without memory info, ranges inside a module are
+  // taken for its code, so that signature scans limited to code still find something.
+  const auto describe = [&](uintptr_t address, uintptr_t end) {
+    MemoryRegion region{.base = address,
+                        .size = end - address,
+                        .allocation_base = address,
+                        .protect = PAGE_READWRITE,
+                        .type = MEM_PRIVATE,
+                        .state = MEM_COMMIT};
+    const auto next_info = std::ranges::upper_bound(infos, address, {}, &MINIDUMP_MEMORY_INFO::BaseAddress);
+    if (next_info != infos.begin() && std::prev(next_info)->BaseAddress + std::prev(next_info)->RegionSize > address) {
+      const MINIDUMP_MEMORY_INFO& info = *std::prev(next_info);
+      region.size = std::min<uintptr_t>(end, info.BaseAddress + info.RegionSize) - address;
+      region.allocation_base = static_cast<uintptr_t>(info.AllocationBase);
+      region.protect = info.Protect;
+      region.type = info.Type;
+      region.state = info.State;
+    } else if (next_info != infos.end()) {
+      region.size = std::min<uintptr_t>(end, next_info->BaseAddress) - address;
+    } else if (infos.empty()) {
+      const auto module =
+          std::ranges::find_if(modules_, [&](const Module& module) { return module.end() > address; });
+      if (module != modules_.end() && module->base <= address) {
+        region.size = std::min(end, module->end()) - address;
+        region.allocation_base = module->base;
+        region.protect = PAGE_EXECUTE_READ;
+        region.type = MEM_IMAGE;
+      } else if (module != modules_.end()) {
+        region.size = std::min(end, module->base) - address;
+      }
+    }
+    return region;
+  };
+
+  for (const CapturedRange& range : ranges) {
+    // Truncated dumps lose the end of their memory.
+    if (range.file_offset >= file_size_) {
+      continue;
+    }
+    const uintptr_t end = range.base + std::min<uint64_t>(range.size, file_size_ - range.file_offset);
+    for (uintptr_t address = range.base; address < end;) {
+      const MemoryRegion region = describe(address, end);
+      if (IsReadable(region) && (regions_.empty() || regions_.back().end() <= region.base)) {
+        regions_.push_back(region);
+        file_offsets_.push_back(range.file_offset + (address - range.base));
+      }
+      address = region.end();
+    }
+  }
+  return true;
+}
+
+DumpView DumpFile::MapFile(uint64_t offset, size_t size) const {
+  const uint64_t view_offset = offset / AllocationGranularity() * AllocationGranularity();
+  const size_t lead = static_cast<size_t>(offset - view_offset);
+  void* view = MapViewOfFile(mapping_,
+                             FILE_MAP_READ,
+                             static_cast<DWORD>(view_offset >> 32),
+                             static_cast<DWORD>(view_offset),
+                             lead + size);
+  if (view == nullptr) {
+    return {};
+  }
+  return DumpView(view, static_cast<const std::byte*>(view) + lead, size);
+}
+
+bool DumpFile::ReadAt(uint64_t offset, std::span<std::byte> out) const {
+  if (offset > file_size_ || out.size() > file_size_ - offset) {
+    return false;
+  }
+  if (out.empty()) {
+    return true;
+  }
+  const DumpView view = MapFile(offset, out.size());
+  if (view.data().empty()) {
+    return false;
+  }
+  std::memcpy(out.data(), view.data().data(), out.size());
+  return true;
+}
+
+size_t DumpFile::FindRegion(uintptr_t address) const {
+  const auto region =
+      std::ranges::partition_point(regions_, [&](const MemoryRegion& region) { return region.end() <= address; });
+  return static_cast<size_t>(region - regions_.begin());
+}
+
+std::optional<MemoryRegion> DumpFile::Query(uintptr_t address) const {
+  const size_t index = FindRegion(address);
+  if (index == regions_.size()) {
+    return std::nullopt;
+  }
+  MemoryRegion region = regions_[index];
+  if (region.base > address) {
+    return MemoryRegion{.base = address, .size = region.base - address, .state = MEM_FREE};
+  }
+  region.size = region.end() - address;
+  region.base = address;
+  return region;
+}
+
+size_t DumpFile::Read(uintptr_t address, std::span<std::byte> out) const {
+  size_t copied = 0;
+  for (size_t index = FindRegion(address); copied < out.size() && index < regions_.size(); ++index) {
+    const MemoryRegion& region = regions_[index];
+    const uintptr_t at = address + copied;
+    if (region.base > at) {
+      break;
+    }
+    const size_t size = std::min<size_t>(out.size() - copied, region.end() - at);
+    if (!ReadAt(file_offsets_[index] + (at - region.base), out.subspan(copied, size))) {
+      break;
+    }
+    copied += size;
+  }
+  return copied;
+}
+
+DumpView DumpFile::Map(uintptr_t address, size_t size) const {
+  size_t index = FindRegion(address);
+  if (index == regions_.size() || regions_[index].base > address) {
+    return {};
+  }
+  const uint64_t offset = file_offsets_[index] + (address - regions_[index].base);
+  // Extend over following regions for as long as they continue both the address range and the file.
+  uintptr_t end = regions_[index].end();
+  while (end < address + size && index + 1 < regions_.size() && regions_[index + 1].base == end &&
+         file_offsets_[index + 1] == offset + (end - address)) {
+    ++index;
+    end = regions_[index].end();
+  }
+  return MapFile(offset, std::min<size_t>(size, end - address));
+}
+
+}  // namespace maia
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/process.hpp"
+
+namespace maia {
+
+// Window of a dump file mapped read-only into our address space, unmapped on destruction.
+class DumpView {
+ public:
+  DumpView() = default;
+  DumpView(const DumpView&) = delete;
+  DumpView& operator=(const DumpView&) = delete;
+  DumpView(DumpView&& other) noexcept;
+  DumpView& operator=(DumpView&& other) noexcept;
+  ~DumpView();
+
+  std::span<const std::byte> data() const { return {data_, size_}; }
+
+ private:
+  friend class DumpFile;
+
+  DumpView(void* view, const std::byte* data, size_t size) : view_(view), data_(data), size_(size) {}
+
+  void* view_{};
+  const std::byte* data_{};
+  size_t size_{};
+};
+
+// Captured memory of a process that is no longer around, scanned offline through Process::OpenDump(). Two formats are
+// understood:
+//  * Minidumps written by MiniDumpWriteDump. Memory comes from the Memory64List of full dumps or the MemoryList of
+//    smaller ones, protections and types from the MemoryInfoList when the dump has one, and modules from the
+//    ModuleList. Without memory info, captured ranges inside a module count as its code.
+//  * Raw region dumps, the bytes of a single region as debuggers save them, placed at a base address given when the
+//    dump is opened.
+// Only the file header and stream directory are read at open time; memory is mapped in windows of a shard or so as it
+// is scanned and unmapped again when the next one is needed, so dumps far larger than RAM scan with bounded RSS.
+class DumpFile {
+ public:
+  // Fails for missing or empty files and for minidumps without captured memory. `raw_base` only applies to files that
+  // are not minidumps.
+  static std::unique_ptr<DumpFile> Open(const std::filesystem::path& path, uintptr_t raw_base);
+
+  DumpFile(const DumpFile&) = delete;
+  DumpFile& operator=(const DumpFile&) = delete;
+  ~DumpFile();
+
+  // Process id recorded in the dump, zero when it has none.
+  uint32_t pid() const { return pid_; }
+
+  // Captured regions in ascending address order, all readable.
+  const std::vector<MemoryRegion>& regions() const { return regions_; }
+
+  // Modules of the dumped process, sorted by base address.
+  const std::vector<Module>& modules() const { return modules_; }
+
+  // Like Process::Query(): the captured region around `address`, or the gap up to the next one reported as a free
+  // range. Fails past the last region.
+  std::optional<MemoryRegion> Query(uintptr_t address) const;
+
+  // Like Process::Read(): copies the captured bytes at `address` up to the first byte that was not captured.
+  size_t Read(uintptr_t address, std::span<std::byte> out) const;
+
+  // Maps at most `size` captured bytes at `address` in place, up to the first byte that was not captured or is not
+  // stored right after the previous one in the file. The latter only happens between regions.
+  DumpView Map(uintptr_t address, size_t size) const;
+
+ private:
+  DumpFile(void* mapping, uint64_t file_size) : mapping_(mapping), file_size_(file_size) {}
+
+  bool ParseMinidump();
+  DumpView MapFile(uint64_t offset, size_t size) const;
+  bool ReadAt(uint64_t offset, std::span<std::byte> out) const;
+  // Index of the region containing `address`, or of the first one after it.
+  size_t FindRegion(uintptr_t address) const;
+
+  void* mapping_{};
+  uint64_t file_size_{};
+  uint32_t pid_{};
+  std::vector<MemoryRegion> regions_;
+  // Where the bytes of every region start in the file, parallel to `regions_`.
+  std::vector<uint64_t> file_offsets_;
+  std::vector<Module> modules_;
+};
+
+}  // namespace maia
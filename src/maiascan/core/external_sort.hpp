@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "maiascan/core/mapped_file.hpp"
+#include "maiascan/core/parallel_sort.hpp"
+#include "maiascan/core/thread_pool.hpp"
+
+namespace maia {
+
+// Sorts more items than fit in a memory budget. Every worker collects into a buffer of its own; a buffer that reaches
+// its share of the budget is sorted by the worker that filled it and written as a run to a temporary memory-mapped
+// file, so runs are produced in parallel with the work that yields the items. Merge() streams all items in order
+// through a k-way merge of the mapped runs, which the OS pages in as the merge reaches them and drops again under
+// memory pressure. Items that fit the budget never touch the disk and come back from memory through TakeSorted().
+template <typename T, typename Compare = std::less<>>
+class ExternalSorter {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+ public:
+  // Runs go to a new file in `directory`, created on the first spill. A `memory_limit` of zero never spills.
+  ExternalSorter(size_t worker_count, std::filesystem::path directory, size_t memory_limit, Compare compare = {})
+      : directory_(std::move(directory)), buffers_(worker_count), compare_(compare) {
+    if (memory_limit != 0) {
+      buffer_capacity_ = std::max(memory_limit / worker_count / sizeof(T), kMinBufferSize);
+    }
+  }
+
+  ExternalSorter(const ExternalSorter&) = delete;
+  ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+  // Adds `items` to the buffer of `worker`, spilling the buffer first when they would overflow it. Distinct workers
+  // may call this concurrently.
+  void Push(size_t worker, std::span<const T> items) {
+    auto& buffer = buffers_[worker].items;
+    if (buffer_capacity_ != 0) {
+      if (!buffer.empty() && buffer.size() + items.size() > buffer_capacity_ && !failed()) {
+        Spill(worker);
+      }
+      // Reserving commits the worker's whole share up front, so it counts against the commit limit from the start;
+      // physical pages are only touched as the buffer fills.
+      buffer.reserve(buffer_capacity_);
+    }
+    buffer.insert(buffer.end(), items.begin(), items.end());
+  }
+
+  // Number of items pushed so far.
+  uint64_t size() const {
+    uint64_t total = spilled_items_;
+    for (const auto& buffer : buffers_) {
+      total += buffer.items.size();
+    }
+    return total;
+  }
+
+  bool spilled() const { return !runs_.empty(); }
+  size_t run_count() const { return runs_.size(); }
+  uint64_t spilled_bytes() const { return spilled_items_ * sizeof(T); }
+
+  // True when a run could not be written. The items stay buffered in memory instead, past the budget.
+  bool failed() const { return failed_.load(std::memory_order_relaxed); }
+
+  // Returns all items in order and empties the buffers. Only valid while nothing has spilled.
+  std::vector<T> TakeSorted(ThreadPool& pool) {
+    std::vector<size_t> offsets(buffers_.size() + 1);
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      offsets[i + 1] = offsets[i] + buffers_[i].items.size();
+    }
+    std::vector<T> items(offsets.back());
+    pool.ParallelFor(buffers_.size(), [&](size_t index, size_t) {
+      std::copy(buffers_[index].items.begin(), buffers_[index].items.end(), items.begin() + offsets[index]);
+      buffers_[index].items = {};
+    });
+    ParallelSort(pool, std::span(items), compare_);
+    return items;
+  }
+
+  // Sorts what is still buffered and calls `sink(std::span<const T>)` with consecutive batches of all items in order.
+  // Runs and buffers are left in place, so the merge can be repeated.
+  template <typename Sink>
+  void Merge(ThreadPool& pool, Sink&& sink) {
+    pool.ParallelFor(buffers_.size(), [&](size_t index, size_t) {
+      std::sort(buffers_[index].items.begin(), buffers_[index].items.end(), compare_);
+    });
+    std::vector<std::span<const T>> runs = runs_;
+    for (const auto& buffer : buffers_) {
+      runs.emplace_back(buffer.items);
+    }
+
+    // A heap of run indices ordered by the next item of each run, smallest on top.
+    const auto later = [&](size_t a, size_t b) { return compare_(runs[b].front(), runs[a].front()); };
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < runs.size(); ++i) {
+      if (!runs[i].empty()) {
+        heap.push_back(i);
+      }
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+    std::vector<T> batch;
+    batch.reserve(kMergeBatchSize);
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), later);
+      auto& run = runs[heap.back()];
+      batch.push_back(run.front());
+      run = run.subspan(1);
+      if (run.empty()) {
+        heap.pop_back();
+      } else {
+        std::push_heap(heap.begin(), heap.end(), later);
+      }
+      if (batch.size() == kMergeBatchSize) {
+        sink(std::span<const T>(batch));
+        batch.clear();
+      }
+    }
+    if (!batch.empty()) {
+      sink(std::span<const T>(batch));
+    }
+  }
+
+ private:
+  // Budgets too small for a useful buffer per worker still spill in runs of this many items.
+  static constexpr size_t kMinBufferSize = size_t{1} << 14;
+  static constexpr size_t kMergeBatchSize = size_t{1} << 12;
+
+  // Padded so that workers filling their own buffers do not share cache lines.
+  struct alignas(64) Buffer {
+    std::vector<T> items;
+    std::span<std::byte> segment;
+    size_t used{};
+  };
+
+  void Spill(size_t worker) {
+    Buffer& buffer = buffers_[worker];
+    const size_t bytes = buffer.items.size() * sizeof(T);
+    if (buffer.segment.size() - buffer.used < bytes) {
+      // Each worker fills a segment of its own. A segment is the run rounded up to the file's 64 MiB granularity, so
+      // the file grows under its lock once per spill unless a worker's runs are small enough to share a segment.
+      SegmentedFile* file = RunFile();
+      buffer.segment = file != nullptr ? file->AddSegment(bytes) : std::span<std::byte>();
+      buffer.used = 0;
+      if (buffer.segment.empty()) {
+        failed_.store(true, std::memory_order_relaxed);
+        return;
+      }
+    }
+    std::sort(buffer.items.begin(), buffer.items.end(), compare_);
+    auto* run = buffer.segment.data() + buffer.used;
+    std::memcpy(run, buffer.items.data(), bytes);
+    buffer.used += bytes;
+    {
+      std::lock_guard lock(mutex_);
+      runs_.emplace_back(reinterpret_cast<const T*>(run), buffer.items.size());
+      spilled_items_ += buffer.items.size();
+    }
+    buffer.items.clear();
+  }
+
+  SegmentedFile* RunFile() {
+    std::lock_guard lock(mutex_);
+    if (!file_) {
+      file_ = SegmentedFile::CreateTemporary(directory_, "maiascan-sort");
+    }
+    return file_.get();
+  }
+
+  std::filesystem::path directory_;
+  std::vector<Buffer> buffers_;
+  Compare compare_;
+  size_t buffer_capacity_{};
+  std::mutex mutex_;
+  std::unique_ptr<SegmentedFile> file_;
+  std::vector<std::span<const T>> runs_;
+  uint64_t spilled_items_{};
+  std::atomic<bool> failed_{false};
+};
+
+}  // namespace maia
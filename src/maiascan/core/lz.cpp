@@ -0,0 +1,146 @@
+#include "maiascan/core/lz.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
+namespace maia {
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxDistance = 0xFFFF;
+constexpr size_t kHashBits = 14;
+// Every run of this many failed lookups since the last match widens the step by one byte, so incompressible input is
+// skipped over quickly.
+constexpr size_t kSkipShift = 6;
+
+uint32_t Load32(const uint8_t* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t value) { return (value * 2654435761U) >> (32 - kHashBits); }
+
+// Appends what is left of a length after the 15 its nibble holds.
+void AppendLength(std::vector<uint8_t>& out, size_t length) {
+  for (; length >= 255; length -= 255) {
+    out.push_back(255);
+  }
+  out.push_back(static_cast<uint8_t>(length));
+}
+
+// Appends a sequence of `literals` followed by a match of `match_length` bytes at `distance`, or by nothing when
+// `match_length` is zero.
+void AppendSequence(std::vector<uint8_t>& out,
+                    std::span<const uint8_t> literals,
+                    size_t distance,
+                    size_t match_length) {
+  const size_t match_code = match_length == 0 ? 0 : match_length - kMinMatch;
+  out.push_back(static_cast<uint8_t>(std::min<size_t>(literals.size(), 15) << 4 | std::min<size_t>(match_code, 15)));
+  if (literals.size() >= 15) {
+    AppendLength(out, literals.size() - 15);
+  }
+  out.insert(out.end(), literals.begin(), literals.end());
+  if (match_length != 0) {
+    out.push_back(static_cast<uint8_t>(distance));
+    out.push_back(static_cast<uint8_t>(distance >> 8));
+    if (match_code >= 15) {
+      AppendLength(out, match_code - 15);
+    }
+  }
+}
+
+// Continues a length whose nibble was 15 from `data`. Returns false when the input ends first.
+bool ReadLength(const uint8_t*& data, const uint8_t* end, size_t& length) {
+  uint8_t byte = 255;
+  while (byte == 255) {
+    if (data == end) {
+      return false;
+    }
+    byte = *data++;
+    length += byte;
+  }
+  return true;
+}
+
+}  // namespace
+
+void LzCompress(std::span<const uint8_t> input, std::vector<uint8_t>& out) {
+  const uint8_t* data = input.data();
+  const size_t size = input.size();
+  // Positions of the last occurrence of each hashed four-byte prefix. Zero doubles as empty, since a candidate is
+  // always compared before it is used.
+  auto table = std::make_unique<std::array<uint32_t, size_t{1} << kHashBits>>();
+  table->fill(0);
+  size_t anchor = 0;
+  size_t position = 0;
+  while (size >= kMinMatch && position <= size - kMinMatch) {
+    const uint32_t value = Load32(data + position);
+    uint32_t& slot = (*table)[Hash(value)];
+    const size_t candidate = slot;
+    slot = static_cast<uint32_t>(position);
+    if (candidate >= position || position - candidate > kMaxDistance || Load32(data + candidate) != value) {
+      position += 1 + ((position - anchor) >> kSkipShift);
+      continue;
+    }
+    size_t length = kMinMatch;
+    while (position + length < size && data[candidate + length] == data[position + length]) {
+      ++length;
+    }
+    AppendSequence(out, input.subspan(anchor, position - anchor), position - candidate, length);
+    position += length;
+    anchor = position;
+  }
+  AppendSequence(out, input.subspan(anchor), 0, 0);
+}
+
+bool LzDecompress(std::span<const uint8_t> input, std::span<uint8_t> out) {
+  const uint8_t* data = input.data();
+  const uint8_t* const end = data + input.size();
+  size_t written = 0;
+  while (data < end) {
+    const uint8_t token = *data++;
+    size_t literals = token >> 4;
+    if ((literals == 15 && !ReadLength(data, end, literals)) || literals > static_cast<size_t>(end - data) ||
+        literals > out.size() - written) {
+      return false;
+    }
+    if (literals != 0) {
+      std::memcpy(out.data() + written, data, literals);
+    }
+    data += literals;
+    written += literals;
+    if (data == end) {
+      break;
+    }
+
+    if (end - data < 2) {
+      return false;
+    }
+    const size_t distance = data[0] | size_t{data[1]} << 8;
+    data += 2;
+    size_t length = token & 0x0FU;
+    if ((length == 15 && !ReadLength(data, end, length)) || distance == 0 || distance > written) {
+      return false;
+    }
+    length += kMinMatch;
+    if (length > out.size() - written) {
+      return false;
+    }
+    if (distance >= length) {
+      std::memcpy(out.data() + written, out.data() + written - distance, length);
+      written += length;
+    } else {
+      // Overlapping matches repeat the last `distance` bytes, which has to go byte by byte.
+      for (const size_t stop = written + length; written < stop; ++written) {
+        out[written] = out[written - distance];
+      }
+    }
+  }
+  return written == out.size();
+}
+
+}  // namespace maia
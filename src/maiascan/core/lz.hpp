@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace maia {
+
+// Byte-oriented LZ77 in the LZ4 block layout, for data that is compressed once and decoded rarely. Every sequence is a
+// token whose high nibble holds the literal length and whose low nibble holds the match length minus four, both
+// continued in bytes of 255 once they reach 15, followed by the literals, a two-byte little-endian distance back into
+// the output and the continuation of the match length. The final sequence carries literals only. A single pass with a
+// small hash table keeps compression close to memory speed and still turns the zero runs and repeated values of scan
+// data into a few bytes.
+
+// Appends the compressed form of `input` to `out`.
+void LzCompress(std::span<const uint8_t> input, std::vector<uint8_t>& out);
+
+// Decodes `input` into exactly `out.size()` bytes. Returns false on malformed input or when the sizes do not match.
+bool LzDecompress(std::span<const uint8_t> input, std::span<uint8_t> out);
+
+}  // namespace maia
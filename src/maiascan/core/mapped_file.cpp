@@ -0,0 +1,124 @@
+#include "maiascan/core/mapped_file.hpp"
+
+#include <windows.h>
+
+#include <atomic>
+
+#include <fmt/format.h>
+
+namespace maia {
+
+std::filesystem::path TemporaryPath(const std::filesystem::path& directory, std::string_view prefix) {
+  static std::atomic<uint32_t> counter{0};
+  return directory / fmt::format("{}-{}-{}.tmp", prefix, GetCurrentProcessId(), counter.fetch_add(1));
+}
+
+std::unique_ptr<SegmentedFile> SegmentedFile::CreateTemporary(const std::filesystem::path& directory,
+                                                              std::string_view prefix) {
+  auto path = TemporaryPath(directory, prefix);
+  // FILE_ATTRIBUTE_TEMPORARY asks the cache manager to avoid flushing pages that are still resident.
+  HANDLE file = CreateFileW(path.wstring().c_str(),
+                            GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_DELETE,
+                            nullptr,
+                            CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  return std::unique_ptr<SegmentedFile>(new SegmentedFile(std::move(path), file));
+}
+
+SegmentedFile::~SegmentedFile() {
+  for (void* view : views_) {
+    UnmapViewOfFile(view);
+  }
+  CloseHandle(file_);
+}
+
+uint64_t SegmentedFile::size() const {
+  std::lock_guard lock(mutex_);
+  return size_;
+}
+
+std::span<std::byte> SegmentedFile::AddSegment(size_t min_size) {
+  const size_t segment_size = (min_size + kSegmentGranularity - 1) / kSegmentGranularity * kSegmentGranularity;
+  std::lock_guard lock(mutex_);
+  const uint64_t offset = size_;
+  const uint64_t new_size = size_ + segment_size;
+  // Creating a larger mapping extends the file. Existing views keep their own mapping objects alive.
+  HANDLE mapping = CreateFileMappingW(file_,
+                                      nullptr,
+                                      PAGE_READWRITE,
+                                      static_cast<DWORD>(new_size >> 32),
+                                      static_cast<DWORD>(new_size),
+                                      nullptr);
+  if (mapping == nullptr) {
+    return {};
+  }
+  void* view = MapViewOfFile(
+      mapping, FILE_MAP_WRITE, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), segment_size);
+  CloseHandle(mapping);
+  if (view == nullptr) {
+    return {};
+  }
+  views_.push_back(view);
+  size_ = new_size;
+  return {static_cast<std::byte*>(view), segment_size};
+}
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path) {
+  return Map(CreateFileW(path.wstring().c_str(),
+                         GENERIC_READ,
+                         FILE_SHARE_READ,
+                         nullptr,
+                         OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL,
+                         nullptr),
+             /*temporary=*/false);
+}
+
+std::unique_ptr<MappedFile> MappedFile::OpenTemporary(const std::filesystem::path& path) {
+  return Map(CreateFileW(path.wstring().c_str(),
+                         GENERIC_READ | DELETE,
+                         FILE_SHARE_READ | FILE_SHARE_DELETE,
+                         nullptr,
+                         OPEN_EXISTING,
+                         FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                         nullptr),
+             /*temporary=*/true);
+}
+
+std::unique_ptr<MappedFile> MappedFile::Map(void* file, bool temporary) {
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  LARGE_INTEGER size{};
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart != 0) {
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  }
+  // The view keeps the mapping object, and with it the file, alive.
+  const void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (mapping != nullptr) {
+    CloseHandle(mapping);
+  }
+  if (view == nullptr || !temporary) {
+    CloseHandle(file);
+  }
+  if (view == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<MappedFile>(
+      new MappedFile(view, static_cast<size_t>(size.QuadPart), temporary ? file : nullptr));
+}
+
+MappedFile::~MappedFile() {
+  UnmapViewOfFile(view_);
+  if (file_ != nullptr) {
+    CloseHandle(file_);
+  }
+}
+
+}  // namespace maia
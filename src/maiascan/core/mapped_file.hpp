@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace maia {
+
+// Path of a new file in `directory` whose name starts with `prefix` and is unique to this process and call.
+std::filesystem::path TemporaryPath(const std::filesystem::path& directory, std::string_view prefix);
+
+// Temporary file that is mapped into memory in independently growing segments. Data written to a segment lives in the
+// page cache and is paged out to the file by the OS under memory pressure, which keeps very large working sets off the
+// heap. The file is deleted when the object is destroyed.
+class SegmentedFile {
+ public:
+  // Segment sizes are rounded up to a multiple of this, which is also a multiple of the allocation granularity.
+  static constexpr size_t kSegmentGranularity = size_t{64} << 20;
+
+  // Creates a uniquely named file in `directory` whose name starts with `prefix`.
+  static std::unique_ptr<SegmentedFile> CreateTemporary(const std::filesystem::path& directory,
+                                                        std::string_view prefix);
+
+  SegmentedFile(const SegmentedFile&) = delete;
+  SegmentedFile& operator=(const SegmentedFile&) = delete;
+  ~SegmentedFile();
+
+  const std::filesystem::path& path() const { return path_; }
+
+  // Bytes currently mapped across all segments.
+  uint64_t size() const;
+
+  // Grows the file by a segment of at least `min_size` bytes and maps it read-write. Returns an empty span on failure.
+  // Safe to call concurrently; previously returned segments stay valid for the lifetime of the object.
+  std::span<std::byte> AddSegment(size_t min_size);
+
+ private:
+  SegmentedFile(std::filesystem::path path, void* file) : path_(std::move(path)), file_(file) {}
+
+  std::filesystem::path path_;
+  void* file_{};
+  mutable std::mutex mutex_;
+  uint64_t size_{};
+  std::vector<void*> views_;
+};
+
+// Read-only view of an entire existing file. Pages are loaded on first access, so opening large files is cheap and only
+// the parts that are actually touched become resident.
+class MappedFile {
+ public:
+  // Fails for missing or empty files.
+  static std::unique_ptr<MappedFile> Open(const std::filesystem::path& path);
+
+  // Like Open(), but takes ownership of the file: it is deleted once the view is gone, or right away if it cannot be
+  // mapped.
+  static std::unique_ptr<MappedFile> OpenTemporary(const std::filesystem::path& path);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  std::span<const std::byte> data() const { return {static_cast<const std::byte*>(view_), size_}; }
+
+ private:
+  MappedFile(const void* view, size_t size, void* file) : view_(view), size_(size), file_(file) {}
+
+  // Maps all of the open `file`. Temporary files stay open until the view is gone, since closing the last handle
+  // deletes them.
+  static std::unique_ptr<MappedFile> Map(void* file, bool temporary);
+
+  const void* view_{};
+  size_t size_{};
+  // Open handle of temporary files, otherwise null.
+  void* file_{};
+};
+
+}  // namespace maia
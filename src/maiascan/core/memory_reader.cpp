@@ -0,0 +1,272 @@
+#include "maiascan/core/memory_reader.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "maiascan/core/bits.hpp"
+#include "maiascan/core/perf.hpp"
+
+namespace maia {
+
+// Second buffer of a worker and the thread that fills it. ReadProcessMemory has no asynchronous form, so overlapping a
+// copy with the work on the previous one takes a thread blocked in the call.
+struct MemoryReader::ReadAheadStage {
+  enum class State : uint8_t {
+    kIdle,
+    // Requested or being copied; the thread owns `buffer`.
+    kPending,
+    // Copied and waiting to be claimed. An unclaimed read-ahead is dropped by the next request.
+    kDone,
+  };
+
+  std::mutex mutex;
+  std::condition_variable requested;
+  std::condition_variable finished;
+  State state{State::kIdle};
+  // The pending copy was dropped and is discarded once it completes.
+  bool dropped{};
+  bool stopping{};
+  uintptr_t address{};
+  size_t size{};
+  size_t read{};
+  PageBuffer buffer;
+  std::thread thread;
+};
+
+MemoryReader::MemoryReader(const Process& process,
+                           size_t worker_count,
+                           ReadMode mode,
+                           bool read_ahead,
+                           std::span<const PagePlacement> placements)
+    : process_(process),
+      workers_(worker_count),
+      mapper_(mode == ReadMode::kMapped && process.dump() == nullptr ? std::make_unique<SectionMapper>(process)
+                                                                      : nullptr),
+      read_ahead_(read_ahead) {
+  for (size_t i = 0; i < placements.size() && i < workers_.size(); ++i) {
+    workers_[i].placement = placements[i];
+  }
+  if (read_ahead_) {
+    for (auto& worker : workers_) {
+      worker.stage = std::make_unique<ReadAheadStage>();
+      worker.stage->thread = std::thread([this, &stage = *worker.stage, node = worker.placement.node] {
+        if (node != kAnyNode) {
+          PinCurrentThreadToNode(node);
+        }
+        RunReadAhead(stage);
+      });
+    }
+  }
+}
+
+MemoryReader::~MemoryReader() {
+  for (auto& worker : workers_) {
+    if (worker.stage) {
+      {
+        std::lock_guard lock(worker.stage->mutex);
+        worker.stage->stopping = true;
+      }
+      worker.stage->requested.notify_one();
+      worker.stage->thread.join();
+    }
+  }
+}
+
+void MemoryReader::PrepareRegions(std::span<const MemoryRegion> regions) {
+  if (mapper_) {
+    mapper_->Map(regions);
+  }
+}
+
+std::span<const std::byte> MemoryReader::FindMapped(Worker& worker, uintptr_t address, size_t size) {
+  std::span<const std::byte> view;
+  if (const DumpFile* dump = process_.dump()) {
+    // Dumps are read in place in any mode. A range the dump does not store in one piece is copied instead.
+    worker.dump_view = dump->Map(address, size);
+    if (worker.dump_view.data().size() == size) {
+      view = worker.dump_view.data();
+    }
+  } else if (mapper_) {
+    view = mapper_->Find(address, size);
+  }
+  worker.stats.bytes += view.size();
+  worker.stats.mapped_bytes += view.size();
+  return view;
+}
+
+size_t MemoryReader::ReadInto(uintptr_t address, std::byte* out, size_t size) {
+  size_t read = 0;
+  {
+    ScopedPerfTimer timer(PerfCounter::kReadNs);
+    read = process_.Read(address, std::span(out, size));
+  }
+  PerfAdd(PerfCounter::kReadCalls, 1);
+  PerfAdd(PerfCounter::kBytesRead, read);
+  return read;
+}
+
+size_t MemoryReader::ReadInto(Worker& worker, uintptr_t address, std::byte* out, size_t size) {
+  const size_t read = ReadInto(address, out, size);
+  ++worker.stats.calls;
+  worker.stats.bytes += read;
+  return read;
+}
+
+void MemoryReader::RunReadAhead(ReadAheadStage& stage) {
+  std::unique_lock lock(stage.mutex);
+  while (true) {
+    stage.requested.wait(lock, [&] { return stage.stopping || stage.state == ReadAheadStage::State::kPending; });
+    if (stage.stopping) {
+      return;
+    }
+    const uintptr_t address = stage.address;
+    const size_t size = stage.size;
+    lock.unlock();
+    const size_t read = ReadInto(address, stage.buffer.data(), size);
+    lock.lock();
+    stage.read = read;
+    stage.state = stage.dropped ? ReadAheadStage::State::kIdle : ReadAheadStage::State::kDone;
+    stage.dropped = false;
+    stage.finished.notify_one();
+  }
+}
+
+void MemoryReader::ReadAhead(size_t worker, uintptr_t address, size_t size) {
+  Worker& state = workers_[worker];
+  if (!state.stage || process_.dump() != nullptr || (mapper_ && !mapper_->Find(address, size).empty())) {
+    return;
+  }
+  ReadAheadStage& stage = *state.stage;
+  {
+    std::lock_guard lock(stage.mutex);
+    if (stage.state == ReadAheadStage::State::kPending || !stage.buffer.Reserve(size, state.placement)) {
+      return;
+    }
+    stage.address = address;
+    stage.size = size;
+    stage.state = ReadAheadStage::State::kPending;
+  }
+  stage.requested.notify_one();
+}
+
+void MemoryReader::DropReadAhead() {
+  for (auto& worker : workers_) {
+    if (worker.stage) {
+      std::lock_guard lock(worker.stage->mutex);
+      if (worker.stage->state == ReadAheadStage::State::kPending) {
+        worker.stage->dropped = true;
+      } else {
+        worker.stage->state = ReadAheadStage::State::kIdle;
+      }
+    }
+  }
+}
+
+std::optional<std::span<const std::byte>> MemoryReader::TakeReadAhead(Worker& worker, uintptr_t address, size_t size) {
+  if (!worker.stage) {
+    return std::nullopt;
+  }
+  ReadAheadStage& stage = *worker.stage;
+  std::unique_lock lock(stage.mutex);
+  if (stage.state == ReadAheadStage::State::kIdle || stage.dropped || stage.address != address || stage.size != size) {
+    return std::nullopt;
+  }
+  if (stage.state == ReadAheadStage::State::kPending) {
+    ScopedPerfTimer timer(PerfCounter::kReadAheadWaitNs);
+    stage.finished.wait(lock, [&] { return stage.state == ReadAheadStage::State::kDone; });
+  }
+  stage.state = ReadAheadStage::State::kIdle;
+  // The worker's old buffer, which its previous view points into, becomes the target of the next read-ahead.
+  std::swap(worker.buffer, stage.buffer);
+  ++worker.stats.calls;
+  worker.stats.bytes += stage.read;
+  return std::span<const std::byte>(worker.buffer.data(), stage.read);
+}
+
+std::span<const std::byte> MemoryReader::Read(size_t worker, uintptr_t address, size_t size) {
+  Worker& state = workers_[worker];
+  if (const auto view = FindMapped(state, address, size); !view.empty()) {
+    return view;
+  }
+  if (const auto view = TakeReadAhead(state, address, size)) {
+    return *view;
+  }
+  if (!state.buffer.Reserve(size, state.placement)) {
+    return {};
+  }
+  return {state.buffer.data(), ReadInto(state, address, state.buffer.data(), size)};
+}
+
+std::span<const std::byte> MemoryReader::ReadPages(size_t worker, uintptr_t address, size_t size, uint64_t* pages) {
+  Worker& state = workers_[worker];
+  if (const auto view = FindMapped(state, address, size); !view.empty()) {
+    return view;
+  }
+  if (!state.buffer.Reserve(size, state.placement)) {
+    return {};
+  }
+  std::byte* buffer = state.buffer.data();
+  const size_t page_count = (size + kPageSize - 1) / kPageSize;
+
+  size_t page = 0;
+  while (page < page_count) {
+    if (!TestBit(pages, page)) {
+      ++page;
+      continue;
+    }
+    // Extend the run over selected pages and short gaps between them.
+    size_t last = page;
+    for (size_t next = page + 1; next < page_count && next - last <= kMaxGapPages + 1; ++next) {
+      if (TestBit(pages, next)) {
+        last = next;
+      }
+    }
+    const size_t offset = page * kPageSize;
+    const size_t length = std::min(size, (last + 1) * kPageSize) - offset;
+    const size_t read = ReadInto(state, address + offset, buffer + offset, length);
+    if (read < length) {
+      // Deselect every page of the run that was not fully transferred.
+      for (size_t p = page + read / kPageSize; p <= last; ++p) {
+        ClearBit(pages, p);
+      }
+    }
+    page = last + 1;
+  }
+  return {buffer, size};
+}
+
+ReadStats MemoryReader::stats() const {
+  ReadStats total;
+  for (const auto& worker : workers_) {
+    total.calls += worker.stats.calls;
+    total.bytes += worker.stats.bytes;
+    total.mapped_bytes += worker.stats.mapped_bytes;
+  }
+  return total;
+}
+
+std::vector<PagePlacement> WorkerPlacements(const ThreadPool& pool, bool large_pages) {
+  std::vector<PagePlacement> placements(pool.size());
+  for (size_t worker = 0; worker < pool.size(); ++worker) {
+    placements[worker] = {.node = pool.node(worker), .large_pages = large_pages};
+  }
+  return placements;
+}
+
+std::vector<MemoryRegion> CoalesceRegions(std::span<const MemoryRegion> regions) {
+  std::vector<MemoryRegion> merged;
+  merged.reserve(regions.size());
+  for (const auto& region : regions) {
+    if (!merged.empty() && merged.back().end() == region.base) {
+      merged.back().size += region.size;
+    } else {
+      merged.push_back(region);
+    }
+  }
+  return merged;
+}
+
+}  // namespace maia
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/dump_file.hpp"
+#include "maiascan/core/page_buffer.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/core/section_mapper.hpp"
+#include "maiascan/core/thread_pool.hpp"
+
+namespace maia {
+
+inline constexpr size_t kPageSize = 4096;
+
+enum class ReadMode : uint8_t {
+  // Copy everything through ReadProcessMemory.
+  kCopy,
+  // Scan section-backed regions in place through local views (see SectionMapper), copying only the rest.
+  kMapped,
+};
+
+struct ReadStats {
+  // ReadProcessMemory calls issued.
+  uint64_t calls{};
+  // Bytes delivered to callers, whether copied or mapped.
+  uint64_t bytes{};
+  // Part of `bytes` served in place from mapped views.
+  uint64_t mapped_bytes{};
+};
+
+// The single path through which scans read target memory. Keeps one reusable page-aligned buffer per worker so that
+// steady-state scanning allocates nothing, and turns scattered page requests into as few ReadProcessMemory calls as
+// possible. Targets opened from a dump are instead read in place from a window of the dump file per worker.
+//
+// Callers are expected to only request ranges inside regions reported by Process::QueryRegions(), which already
+// excludes PAGE_NOACCESS and PAGE_GUARD memory, so reads normally succeed on the first call; a range that became
+// unreadable since the regions were queried is reported as a short read rather than retried.
+class MemoryReader {
+ public:
+  // Runs of selected pages separated by at most this many unselected pages are fetched with a single call, since
+  // copying a few extra pages is cheaper than another system call.
+  static constexpr size_t kMaxGapPages = 4;
+
+  // With `read_ahead`, every worker gets a reader thread of its own that serves ReadAhead(). `placements`, when not
+  // empty, holds one entry per worker and says where its buffers go; the reader thread of a worker placed on a node is
+  // pinned to that node as well.
+  MemoryReader(const Process& process,
+               size_t worker_count,
+               ReadMode mode = ReadMode::kCopy,
+               bool read_ahead = false,
+               std::span<const PagePlacement> placements = {});
+  MemoryReader(const MemoryReader&) = delete;
+  MemoryReader& operator=(const MemoryReader&) = delete;
+  ~MemoryReader();
+
+  const Process& process() const { return process_; }
+  bool read_ahead() const { return read_ahead_; }
+
+  // Called with the freshly queried regions before a scan walks them. In mapped mode this maps every region that can
+  // be shared; whatever fails to map silently falls back to copying.
+  void PrepareRegions(std::span<const MemoryRegion> regions);
+
+  // Reads [address, address + size) into the buffer of `worker` and returns the readable prefix. The view stays valid
+  // until the next read by the same worker. Ranges inside a mapped region are returned in place, without a copy.
+  std::span<const std::byte> Read(size_t worker, uintptr_t address, size_t size);
+
+  // Reads only the pages of [address, address + size) whose bit is set in `pages`, one bit per page counted from the
+  // page-aligned `address`. Bits of pages that turned out to be unreadable are cleared. The returned view covers the
+  // whole range; bytes of pages that were not selected are unspecified.
+  std::span<const std::byte> ReadPages(size_t worker, uintptr_t address, size_t size, uint64_t* pages);
+
+  // Starts copying [address, address + size) on the reader thread of `worker`, into a second buffer, while the worker
+  // keeps working on the view of its last read. The next Read() of exactly this range then waits for the copy instead
+  // of issuing its own, and the two buffers trade places. Ranges that are mapped in place are not copied ahead, and
+  // nothing is started while an earlier read-ahead of the worker is still in flight. Does nothing unless read-ahead
+  // was enabled at construction.
+  void ReadAhead(size_t worker, uintptr_t address, size_t size);
+
+  // Discards every read-ahead that was not claimed, so that a later read of the same range sees the memory as it is
+  // then. Called once the walk that issued them is done; no read may be in flight.
+  void DropReadAhead();
+
+  // Totals over all workers since construction. Only meaningful while no read is in flight.
+  ReadStats stats() const;
+
+  // Counts of worker `worker` alone, under the same conditions.
+  const ReadStats& worker_stats(size_t worker) const { return workers_[worker].stats; }
+
+ private:
+  struct ReadAheadStage;
+
+  // Padded so that workers updating their own counters do not share cache lines.
+  struct alignas(64) Worker {
+    PageBuffer buffer;
+    PagePlacement placement;
+    // Window of the target's dump behind the worker's last view, when the target is a dump.
+    DumpView dump_view;
+    ReadStats stats;
+    std::unique_ptr<ReadAheadStage> stage;
+  };
+
+  size_t ReadInto(Worker& worker, uintptr_t address, std::byte* out, size_t size);
+  size_t ReadInto(uintptr_t address, std::byte* out, size_t size);
+
+  // Claims the read-ahead of exactly [address, address + size), if that is what the worker's stage holds.
+  std::optional<std::span<const std::byte>> TakeReadAhead(Worker& worker, uintptr_t address, size_t size);
+  void RunReadAhead(ReadAheadStage& stage);
+
+  std::span<const std::byte> FindMapped(Worker& worker, uintptr_t address, size_t size);
+
+  const Process& process_;
+  std::vector<Worker> workers_;
+  std::unique_ptr<SectionMapper> mapper_;
+  bool read_ahead_;
+};
+
+// Buffer placement of every worker of `pool`: on the worker's node when the pool is pinned, in large pages when
+// `large_pages` is set.
+std::vector<PagePlacement> WorkerPlacements(const ThreadPool& pool, bool large_pages);
+
+// Merges regions that are directly adjacent in the address space, so that they are read with fewer, larger calls.
+// The merged region keeps the protection and type of its first part.
+std::vector<MemoryRegion> CoalesceRegions(std::span<const MemoryRegion> regions);
+
+}  // namespace maia
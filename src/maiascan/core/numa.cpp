@@ -0,0 +1,80 @@
+#include "maiascan/core/numa.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <bit>
+#include <memory>
+
+namespace maia {
+
+namespace {
+
+std::vector<NumaNode> QueryNumaNodes() {
+  std::vector<NumaNode> nodes;
+  DWORD length = 0;
+  GetLogicalProcessorInformationEx(RelationNumaNode, nullptr, &length);
+  auto buffer = std::make_unique<std::byte[]>(length);
+  auto* first = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.get());
+  if (length != 0 && GetLogicalProcessorInformationEx(RelationNumaNode, first, &length)) {
+    for (DWORD offset = 0; offset < length;) {
+      const auto& info = *reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.get() + offset);
+      if (info.Relationship == RelationNumaNode) {
+        nodes.push_back({.number = info.NumaNode.NodeNumber,
+                         .group = info.NumaNode.GroupMask.Group,
+                         .processor_mask = static_cast<uint64_t>(info.NumaNode.GroupMask.Mask)});
+      }
+      offset += info.Size;
+    }
+  }
+  if (nodes.empty()) {
+    // Without topology information there is one node of unknown processors, which threads are never pinned to.
+    nodes.push_back({});
+  }
+  std::sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) { return a.number < b.number; });
+  return nodes;
+}
+
+}  // namespace
+
+size_t NumaNode::processor_count() const { return static_cast<size_t>(std::popcount(processor_mask)); }
+
+const std::vector<NumaNode>& GetNumaNodes() {
+  static const std::vector<NumaNode> nodes = QueryNumaNodes();
+  return nodes;
+}
+
+std::vector<uint32_t> AssignNodes(size_t worker_count) {
+  const auto& nodes = GetNumaNodes();
+  size_t total = 0;
+  for (const auto& node : nodes) {
+    total += node.processor_count();
+  }
+  std::vector<uint32_t> assigned(worker_count, nodes.front().number);
+  if (total == 0) {
+    return assigned;
+  }
+  size_t before = 0;
+  for (const auto& node : nodes) {
+    const size_t first = worker_count * before / total;
+    before += node.processor_count();
+    const size_t last = worker_count * before / total;
+    std::fill(assigned.begin() + first, assigned.begin() + last, node.number);
+  }
+  return assigned;
+}
+
+bool PinCurrentThreadToNode(uint32_t node) {
+  const auto& nodes = GetNumaNodes();
+  const auto it =
+      std::find_if(nodes.begin(), nodes.end(), [&](const NumaNode& candidate) { return candidate.number == node; });
+  if (it == nodes.end() || it->processor_mask == 0) {
+    return false;
+  }
+  GROUP_AFFINITY affinity{};
+  affinity.Group = it->group;
+  affinity.Mask = static_cast<KAFFINITY>(it->processor_mask);
+  return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+}
+
+}  // namespace maia
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace maia {
+
+// Node number meaning "wherever the OS prefers".
+inline constexpr uint32_t kAnyNode = 0xFFFFFFFF;
+
+struct NumaNode {
+  uint32_t number{};
+  // Processors of the node, as a processor group and a mask within it. Nodes spanning several groups are represented
+  // by their first one.
+  uint16_t group{};
+  uint64_t processor_mask{};
+
+  size_t processor_count() const;
+};
+
+// NUMA nodes of this machine in ascending order, queried once on first use. Machines without NUMA report one node.
+const std::vector<NumaNode>& GetNumaNodes();
+
+// Node for each of `worker_count` workers. Workers are dealt out in contiguous blocks sized to every node's share of
+// the processors, so that neighbouring workers, which run neighbouring shards, share a node.
+std::vector<uint32_t> AssignNodes(size_t worker_count);
+
+// Restricts the calling thread to the processors of node `node`. Returns false for unknown nodes or when the OS
+// refuses.
+bool PinCurrentThreadToNode(uint32_t node);
+
+}  // namespace maia
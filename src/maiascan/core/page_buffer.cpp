@@ -0,0 +1,131 @@
+#include "maiascan/core/page_buffer.hpp"
+
+#include <windows.h>
+
+#include <utility>
+
+namespace maia {
+
+namespace {
+
+size_t AllocationGranularity() {
+  static const size_t granularity = [] {
+    SYSTEM_INFO info{};
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwAllocationGranularity);
+  }();
+  return granularity;
+}
+
+bool EnableLockMemoryPrivilege() {
+  HANDLE token = nullptr;
+  if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+    return false;
+  }
+  TOKEN_PRIVILEGES privileges{};
+  privileges.PrivilegeCount = 1;
+  privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+  const bool enabled = LookupPrivilegeValueW(nullptr, L"SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+                       AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                       GetLastError() == ERROR_SUCCESS;
+  CloseHandle(token);
+  return enabled;
+}
+
+size_t RoundUp(size_t size, size_t granularity) { return (size + granularity - 1) / granularity * granularity; }
+
+// Commits `capacity` bytes, preferably on `node`.
+std::byte* Commit(size_t capacity, uint32_t node, bool large_pages) {
+  const DWORD type = MEM_COMMIT | MEM_RESERVE | (large_pages ? MEM_LARGE_PAGES : 0);
+  if (node == kAnyNode) {
+    return static_cast<std::byte*>(VirtualAlloc(nullptr, capacity, type, PAGE_READWRITE));
+  }
+  return static_cast<std::byte*>(
+      VirtualAllocExNuma(GetCurrentProcess(), nullptr, capacity, type, PAGE_READWRITE, node));
+}
+
+// Allocates at least `size` bytes as `placement` asks, trying normal pages when large ones fail, and sets `capacity`
+// to what was allocated.
+std::byte* AllocatePages(size_t size, PagePlacement placement, size_t& capacity) {
+  if (placement.large_pages) {
+    if (const size_t large_page = LargePageSize(); large_page != 0) {
+      capacity = RoundUp(size, large_page);
+      if (auto* data = Commit(capacity, placement.node, true)) {
+        return data;
+      }
+    }
+  }
+  capacity = RoundUp(size, AllocationGranularity());
+  return Commit(capacity, placement.node, false);
+}
+
+class OsAllocator final : public ChunkAllocator {
+ public:
+  explicit OsAllocator(bool large_pages) : large_pages_(large_pages) {}
+
+  std::span<std::byte> AllocateChunk(size_t size) override {
+    size_t capacity = 0;
+    auto* data = AllocatePages(size, {.large_pages = large_pages_}, capacity);
+    return data == nullptr ? std::span<std::byte>() : std::span<std::byte>(data, capacity);
+  }
+
+  void FreeChunk(std::span<std::byte> chunk) override { VirtualFree(chunk.data(), 0, MEM_RELEASE); }
+
+ private:
+  bool large_pages_;
+};
+
+}  // namespace
+
+size_t LargePageSize() {
+  static const size_t size = EnableLockMemoryPrivilege() ? GetLargePageMinimum() : 0;
+  return size;
+}
+
+ChunkAllocator& OsChunkAllocator() {
+  static OsAllocator allocator(false);
+  return allocator;
+}
+
+ChunkAllocator& LargePageChunkAllocator() {
+  static OsAllocator allocator(true);
+  return allocator;
+}
+
+PageBuffer::PageBuffer(PageBuffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), capacity_(std::exchange(other.capacity_, 0)) {}
+
+PageBuffer& PageBuffer::operator=(PageBuffer&& other) noexcept {
+  if (this != &other) {
+    Release();
+    data_ = std::exchange(other.data_, nullptr);
+    capacity_ = std::exchange(other.capacity_, 0);
+  }
+  return *this;
+}
+
+PageBuffer::~PageBuffer() { Release(); }
+
+bool PageBuffer::Reserve(size_t size, PagePlacement placement) {
+  if (size <= capacity_) {
+    return true;
+  }
+  Release();
+  size_t capacity = 0;
+  data_ = AllocatePages(size, placement, capacity);
+  if (data_ == nullptr) {
+    return false;
+  }
+  capacity_ = capacity;
+  return true;
+}
+
+void PageBuffer::Release() {
+  if (data_ != nullptr) {
+    VirtualFree(data_, 0, MEM_RELEASE);
+    data_ = nullptr;
+    capacity_ = 0;
+  }
+}
+
+}  // namespace maia
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "maiascan/core/numa.hpp"
+
+namespace maia {
+
+// Where the pages of a buffer come from.
+struct PagePlacement {
+  // Preferred NUMA node of the pages. Buffers of a worker pinned to a node belong on that node, since the reads that
+  // fill them and the kernels that scan them both run there.
+  uint32_t node{kAnyNode};
+  // Back the buffer with large pages, which spares the TLB misses of streaming through it. Falls back to normal pages
+  // when large pages are unavailable (see LargePageSize()) or the OS has no contiguous memory left for them.
+  bool large_pages{};
+};
+
+// Minimum large page size, or zero when this process cannot allocate large pages. The first call tries to enable
+// SeLockMemoryPrivilege, which the account has to hold.
+size_t LargePageSize();
+
+// Page-aligned scratch buffer allocated directly from the OS. Capacity is always rounded up to the allocation
+// granularity (64 KiB), or to the large page size, so buffers map to whole allocation units and reads into them never
+// straddle a heap block.
+class PageBuffer {
+ public:
+  PageBuffer() = default;
+  PageBuffer(const PageBuffer&) = delete;
+  PageBuffer& operator=(const PageBuffer&) = delete;
+  PageBuffer(PageBuffer&& other) noexcept;
+  PageBuffer& operator=(PageBuffer&& other) noexcept;
+  ~PageBuffer();
+
+  // Makes sure at least `size` bytes are available. Contents are not preserved when the buffer has to grow.
+  // Returns false if the allocation failed, in which case the buffer is left empty. `placement` applies when the
+  // buffer has to grow.
+  bool Reserve(size_t size, PagePlacement placement = {});
+
+  std::byte* data() const { return data_; }
+  size_t capacity() const { return capacity_; }
+  std::span<std::byte> span(size_t size) const { return {data_, size}; }
+
+ private:
+  void Release();
+
+  std::byte* data_{};
+  size_t capacity_{};
+};
+
+// Source of the chunks arenas carve their allocations from. The default takes them straight from the OS like
+// PageBuffer does; embedders that budget or pool memory themselves implement this and hand it to the scanner through
+// ScanOptions::chunk_allocator. Chunks are requested and returned by the workers of a scan concurrently.
+class ChunkAllocator {
+ public:
+  virtual ~ChunkAllocator() = default;
+
+  // At least `size` page-aligned bytes, or an empty span when out of memory. The returned span may be larger than
+  // `size`, in which case all of it is used.
+  virtual std::span<std::byte> AllocateChunk(size_t size) = 0;
+
+  // Returns a chunk exactly as AllocateChunk() handed it out.
+  virtual void FreeChunk(std::span<std::byte> chunk) = 0;
+};
+
+// Allocates chunks with the OS page allocator, rounded up to the allocation granularity.
+ChunkAllocator& OsChunkAllocator();
+
+// Allocates chunks in large pages, rounded up to the large page size, and falls back to OsChunkAllocator() when that
+// fails. Like with the default, the pages land on the node of the worker that first writes them.
+ChunkAllocator& LargePageChunkAllocator();
+
+}  // namespace maia
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/thread_pool.hpp"
+
+namespace maia {
+
+// Sorts `items` by splitting it into one chunk per worker, sorting the chunks concurrently and then merging pairs of
+// neighbouring chunks in parallel rounds. Falls back to std::sort for inputs too small to be worth splitting.
+template <typename T, typename Compare>
+void ParallelSort(ThreadPool& pool, std::span<T> items, Compare compare) {
+  constexpr size_t kMinChunkSize = size_t{1} << 16;
+  const size_t chunk_count = std::bit_floor(std::min(pool.size(), std::max<size_t>(items.size() / kMinChunkSize, 1)));
+  if (chunk_count <= 1) {
+    std::sort(items.begin(), items.end(), compare);
+    return;
+  }
+
+  std::vector<size_t> bounds(chunk_count + 1);
+  for (size_t i = 0; i <= chunk_count; ++i) {
+    bounds[i] = items.size() * i / chunk_count;
+  }
+  pool.ParallelFor(chunk_count, [&](size_t index, size_t) {
+    std::sort(items.begin() + bounds[index], items.begin() + bounds[index + 1], compare);
+  });
+  for (size_t width = 1; width < chunk_count; width *= 2) {
+    pool.ParallelFor(chunk_count / (2 * width), [&](size_t index, size_t) {
+      const size_t first = 2 * width * index;
+      std::inplace_merge(items.begin() + bounds[first],
+                         items.begin() + bounds[first + width],
+                         items.begin() + bounds[first + 2 * width],
+                         compare);
+    });
+  }
+}
+
+}  // namespace maia
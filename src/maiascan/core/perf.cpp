@@ -0,0 +1,159 @@
+#include "maiascan/core/perf.hpp"
+
+#include <memory>
+#include <mutex>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/spdlog.h>
+
+#include "maiascan/core/thread_pool.hpp"
+
+namespace maia {
+
+namespace {
+
+// Counters of one thread. Only the owning thread writes them; readers sum every slot.
+struct alignas(64) PerfSlot {
+  std::array<std::atomic<uint64_t>, static_cast<size_t>(PerfCounter::kCount)> values{};
+};
+
+struct PerfRegistry {
+  std::mutex mutex;
+  // Slots live as long as the process, so threads that exited still count towards the totals.
+  std::vector<std::unique_ptr<PerfSlot>> slots;
+  std::shared_ptr<spdlog::logger> logger;
+};
+
+PerfRegistry& Registry() {
+  static PerfRegistry registry;
+  return registry;
+}
+
+PerfSlot& ThreadSlot() {
+  thread_local PerfSlot* slot = [] {
+    PerfRegistry& registry = Registry();
+    std::lock_guard lock(registry.mutex);
+    return registry.slots.emplace_back(std::make_unique<PerfSlot>()).get();
+  }();
+  return *slot;
+}
+
+double ToMilliseconds(uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1e6; }
+
+}  // namespace
+
+namespace detail {
+
+void AddPerfCounter(PerfCounter counter, uint64_t value) {
+  auto& slot = ThreadSlot().values[static_cast<size_t>(counter)];
+  slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+}  // namespace detail
+
+PerfTotals ReadPerfTotals() {
+  PerfTotals totals{};
+  PerfRegistry& registry = Registry();
+  std::lock_guard lock(registry.mutex);
+  for (const auto& slot : registry.slots) {
+    for (size_t i = 0; i < totals.size(); ++i) {
+      totals[i] += slot->values[i].load(std::memory_order_relaxed);
+    }
+  }
+  return totals;
+}
+
+bool OpenPerfLog(const std::filesystem::path& path) {
+  ClosePerfLog();
+  std::shared_ptr<spdlog::logger> logger;
+  try {
+    logger = std::make_shared<spdlog::logger>(
+        "perf", std::make_shared<spdlog::sinks::basic_file_sink_mt>(path.string(), /*truncate=*/true));
+  } catch (const spdlog::spdlog_ex&) {
+    return false;
+  }
+  // Messages are the fields of a JSON object, which the pattern completes with a timestamp.
+  logger->set_pattern(R"({"time":"%Y-%m-%dT%H:%M:%S.%f",%v})");
+  logger->flush_on(spdlog::level::info);
+  {
+    PerfRegistry& registry = Registry();
+    std::lock_guard lock(registry.mutex);
+    registry.logger = std::move(logger);
+  }
+  detail::perf_enabled.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void ClosePerfLog() {
+  detail::perf_enabled.store(false, std::memory_order_relaxed);
+  PerfRegistry& registry = Registry();
+  std::lock_guard lock(registry.mutex);
+  if (registry.logger) {
+    registry.logger->flush();
+    registry.logger.reset();
+  }
+}
+
+PerfPhase::PerfPhase(std::string_view name, const ThreadPool* pool)
+    : enabled_(PerfEnabled()), name_(name), pool_(pool), start_(std::chrono::steady_clock::now()) {
+  if (enabled_) {
+    totals_at_start_ = ReadPerfTotals();
+    if (pool_ != nullptr) {
+      busy_at_start_ = pool_->busy_ns();
+    }
+  }
+}
+
+PerfPhase::~PerfPhase() {
+  if (!enabled_ || !PerfEnabled()) {
+    return;
+  }
+  const uint64_t wall_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+  const PerfTotals totals = ReadPerfTotals();
+  const auto delta = [&](PerfCounter counter) {
+    return totals[static_cast<size_t>(counter)] - totals_at_start_[static_cast<size_t>(counter)];
+  };
+
+  nlohmann::ordered_json line = {
+      {"phase", name_},
+      {"wall_ms", ToMilliseconds(wall_ns)},
+      {"region_queries", delta(PerfCounter::kRegionQueries)},
+      {"region_ms", ToMilliseconds(delta(PerfCounter::kRegionNs))},
+      {"read_calls", delta(PerfCounter::kReadCalls)},
+      {"read_ms", ToMilliseconds(delta(PerfCounter::kReadNs))},
+      {"bytes_read", delta(PerfCounter::kBytesRead)},
+      {"read_ahead_wait_ms", ToMilliseconds(delta(PerfCounter::kReadAheadWaitNs))},
+      {"kernel_ms", ToMilliseconds(delta(PerfCounter::kKernelNs))},
+      {"merge_ms", ToMilliseconds(delta(PerfCounter::kMergeNs))},
+  };
+  for (const auto& [key, value] : fields_) {
+    line[key] = value;
+  }
+  if (pool_ != nullptr) {
+    const auto busy = pool_->busy_ns();
+    auto utilization = nlohmann::ordered_json::array();
+    for (size_t i = 0; i < busy.size(); ++i) {
+      const uint64_t worker_busy = busy[i] - (i < busy_at_start_.size() ? busy_at_start_[i] : 0);
+      utilization.push_back(wall_ns == 0 ? 0.0 : static_cast<double>(worker_busy) / static_cast<double>(wall_ns));
+    }
+    line["utilization"] = std::move(utilization);
+  }
+
+  const std::string text = line.dump();
+  PerfRegistry& registry = Registry();
+  std::lock_guard lock(registry.mutex);
+  if (registry.logger) {
+    // Without the braces, which the pattern supplies.
+    registry.logger->info(std::string_view(text).substr(1, text.size() - 2));
+  }
+}
+
+void PerfPhase::Set(std::string_view key, uint64_t value) {
+  if (enabled_) {
+    fields_.emplace_back(key, value);
+  }
+}
+
+}  // namespace maia
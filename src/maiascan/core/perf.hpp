@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace maia {
+
+class ThreadPool;
+
+// Scan instrumentation for profiling on machines where no profiler can be attached. Hot paths bump per-thread
+// counters, mostly through ScopedPerfTimer, and every PerfPhase logs what the counters accumulated during it as one
+// JSON line through spdlog. Everything stays off until OpenPerfLog() succeeds, and while off an instrumented path costs
+// a relaxed load.
+
+enum class PerfCounter : uint8_t {
+  // VirtualQueryEx calls and the time spent in them while enumerating regions.
+  kRegionQueries,
+  kRegionNs,
+  // ReadProcessMemory calls, the time spent in them and the bytes they copied.
+  kReadCalls,
+  kReadNs,
+  kBytesRead,
+  // Time workers spent waiting for a read-ahead to complete (see MemoryReader::ReadAhead()).
+  kReadAheadWaitNs,
+  // Time spent evaluating predicates, comparisons and signatures over data that was already read.
+  kKernelNs,
+  // Time spent combining per-shard results into the result of a scan.
+  kMergeNs,
+  kCount,
+};
+
+using PerfTotals = std::array<uint64_t, static_cast<size_t>(PerfCounter::kCount)>;
+
+namespace detail {
+
+inline std::atomic<bool> perf_enabled{false};
+
+void AddPerfCounter(PerfCounter counter, uint64_t value);
+
+}  // namespace detail
+
+inline bool PerfEnabled() { return detail::perf_enabled.load(std::memory_order_relaxed); }
+
+// Adds `value` to the calling thread's `counter`.
+inline void PerfAdd(PerfCounter counter, uint64_t value) {
+  if (PerfEnabled()) {
+    detail::AddPerfCounter(counter, value);
+  }
+}
+
+// Sums of every counter over all threads since the log was opened.
+PerfTotals ReadPerfTotals();
+
+// Adds the nanoseconds between construction and destruction to a counter of the calling thread.
+class ScopedPerfTimer {
+ public:
+  explicit ScopedPerfTimer(PerfCounter counter) : counter_(counter), enabled_(PerfEnabled()) {
+    if (enabled_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ScopedPerfTimer(const ScopedPerfTimer&) = delete;
+  ScopedPerfTimer& operator=(const ScopedPerfTimer&) = delete;
+  ~ScopedPerfTimer() {
+    if (enabled_) {
+      const auto elapsed = std::chrono::steady_clock::now() - start_;
+      detail::AddPerfCounter(counter_, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+  }
+
+ private:
+  PerfCounter counter_;
+  bool enabled_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Starts writing phases as JSON lines to `path`, replacing an earlier file, and enables the counters. Returns false
+// when the file cannot be created.
+bool OpenPerfLog(const std::filesystem::path& path);
+
+// Flushes and closes the log and disables the counters.
+void ClosePerfLog();
+
+// A named stretch of work such as one scan. When the log is open, the destructor logs the wall time, the counters
+// accumulated in between and, given the pool that ran the work, the share of the wall time each worker was busy.
+class PerfPhase {
+ public:
+  explicit PerfPhase(std::string_view name, const ThreadPool* pool = nullptr);
+  PerfPhase(const PerfPhase&) = delete;
+  PerfPhase& operator=(const PerfPhase&) = delete;
+  ~PerfPhase();
+
+  // Adds a field to the line, e.g. the number of results.
+  void Set(std::string_view key, uint64_t value);
+
+ private:
+  bool enabled_;
+  std::string name_;
+  const ThreadPool* pool_;
+  std::chrono::steady_clock::time_point start_;
+  PerfTotals totals_at_start_{};
+  std::vector<uint64_t> busy_at_start_;
+  std::vector<std::pair<std::string, uint64_t>> fields_;
+};
+
+}  // namespace maia
@@ -0,0 +1,174 @@
+#include "maiascan/core/process.hpp"
+
+#include <windows.h>
+
+#include <tlhelp32.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "maiascan/core/dump_file.hpp"
+#include "maiascan/core/perf.hpp"
+
+namespace maia {
+
+namespace {
+
+constexpr DWORD kReadableProtections = PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READ |
+                                       PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+constexpr DWORD kExecutableProtections =
+    PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+MemoryRegion ToRegion(const MEMORY_BASIC_INFORMATION& info) {
+  return {.base = reinterpret_cast<uintptr_t>(info.BaseAddress),
+          .size = info.RegionSize,
+          .allocation_base = info.State == MEM_FREE ? 0 : reinterpret_cast<uintptr_t>(info.AllocationBase),
+          .protect = static_cast<uint32_t>(info.Protect),
+          .type = static_cast<uint32_t>(info.Type),
+          .state = static_cast<uint32_t>(info.State)};
+}
+
+std::string ToUtf8(const WCHAR* text) {
+  const int size = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+  if (size <= 1) {
+    return {};
+  }
+  std::string result(static_cast<size_t>(size - 1), '\0');
+  WideCharToMultiByte(CP_UTF8, 0, text, -1, result.data(), size, nullptr, nullptr);
+  return result;
+}
+
+}  // namespace
+
+bool IsReadable(const MemoryRegion& region) {
+  return region.state == MEM_COMMIT && (region.protect & PAGE_GUARD) == 0 &&
+         (region.protect & kReadableProtections) != 0;
+}
+
+bool IsExecutableImage(const MemoryRegion& region) {
+  return region.type == MEM_IMAGE && (region.protect & kExecutableProtections) != 0;
+}
+
+bool IsFileBacked(const MemoryRegion& region) { return region.type == MEM_IMAGE || region.type == MEM_MAPPED; }
+
+std::optional<Process> Process::Open(uint32_t pid, ProcessAccess access) {
+  DWORD rights = PROCESS_QUERY_INFORMATION | PROCESS_VM_READ;
+  if (access == ProcessAccess::kReadWrite) {
+    rights |= PROCESS_VM_WRITE | PROCESS_VM_OPERATION;
+  }
+  HANDLE handle = OpenProcess(rights, FALSE, pid);
+  if (handle == nullptr) {
+    return std::nullopt;
+  }
+  return Process(pid, handle);
+}
+
+std::optional<Process> Process::OpenDump(const std::filesystem::path& path, uintptr_t raw_base) {
+  std::shared_ptr<const DumpFile> dump = DumpFile::Open(path, raw_base);
+  if (!dump) {
+    return std::nullopt;
+  }
+  Process process(dump->pid(), nullptr);
+  process.dump_ = std::move(dump);
+  return process;
+}
+
+Process::Process(Process&& other) noexcept
+    : pid_(std::exchange(other.pid_, 0)),
+      handle_(std::exchange(other.handle_, nullptr)),
+      dump_(std::move(other.dump_)) {}
+
+Process& Process::operator=(Process&& other) noexcept {
+  if (this != &other) {
+    if (handle_ != nullptr) {
+      CloseHandle(handle_);
+    }
+    pid_ = std::exchange(other.pid_, 0);
+    handle_ = std::exchange(other.handle_, nullptr);
+    dump_ = std::move(other.dump_);
+  }
+  return *this;
+}
+
+Process::~Process() {
+  if (handle_ != nullptr) {
+    CloseHandle(handle_);
+  }
+}
+
+std::vector<MemoryRegion> Process::QueryRegions() const {
+  if (dump_) {
+    return dump_->regions();
+  }
+  ScopedPerfTimer timer(PerfCounter::kRegionNs);
+  SYSTEM_INFO system_info{};
+  GetSystemInfo(&system_info);
+  auto address = reinterpret_cast<uintptr_t>(system_info.lpMinimumApplicationAddress);
+  const auto max_address = reinterpret_cast<uintptr_t>(system_info.lpMaximumApplicationAddress);
+
+  std::vector<MemoryRegion> regions;
+  MEMORY_BASIC_INFORMATION info{};
+  while (address < max_address &&
+         VirtualQueryEx(handle_, reinterpret_cast<LPCVOID>(address), &info, sizeof(info)) == sizeof(info)) {
+    PerfAdd(PerfCounter::kRegionQueries, 1);
+    const MemoryRegion region = ToRegion(info);
+    if (IsReadable(region)) {
+      regions.push_back(region);
+    }
+    address = region.end();
+  }
+  return regions;
+}
+
+std::optional<MemoryRegion> Process::Query(uintptr_t address) const {
+  if (dump_) {
+    return dump_->Query(address);
+  }
+  MEMORY_BASIC_INFORMATION info{};
+  if (VirtualQueryEx(handle_, reinterpret_cast<LPCVOID>(address), &info, sizeof(info)) != sizeof(info)) {
+    return std::nullopt;
+  }
+  return ToRegion(info);
+}
+
+std::vector<Module> Process::QueryModules() const {
+  if (dump_) {
+    return dump_->modules();
+  }
+  std::vector<Module> modules;
+  HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE | TH32CS_SNAPMODULE32, pid_);
+  if (snapshot == INVALID_HANDLE_VALUE) {
+    return modules;
+  }
+  MODULEENTRY32W entry{};
+  entry.dwSize = sizeof(entry);
+  for (BOOL found = Module32FirstW(snapshot, &entry); found; found = Module32NextW(snapshot, &entry)) {
+    modules.push_back({.name = ToUtf8(entry.szModule),
+                       .base = reinterpret_cast<uintptr_t>(entry.modBaseAddr),
+                       .size = entry.modBaseSize});
+  }
+  CloseHandle(snapshot);
+  std::sort(modules.begin(), modules.end(), [](const Module& a, const Module& b) { return a.base < b.base; });
+  return modules;
+}
+
+size_t Process::Read(uintptr_t address, std::span<std::byte> out) const {
+  if (dump_) {
+    return dump_->Read(address, out);
+  }
+  SIZE_T bytes_read = 0;
+  // A partial copy fails with ERROR_PARTIAL_COPY but still reports how much was transferred.
+  ReadProcessMemory(handle_, reinterpret_cast<LPCVOID>(address), out.data(), out.size(), &bytes_read);
+  return bytes_read;
+}
+
+size_t Process::Write(uintptr_t address, std::span<const std::byte> data) const {
+  if (dump_) {
+    return 0;
+  }
+  SIZE_T bytes_written = 0;
+  WriteProcessMemory(handle_, reinterpret_cast<LPVOID>(address), data.data(), data.size(), &bytes_written);
+  return bytes_written;
+}
+
+}  // namespace maia
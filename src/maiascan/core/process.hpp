@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace maia {
+
+// A range of the target's address space as reported by VirtualQueryEx. Process::QueryRegions() only reports committed,
+// readable ones.
+struct MemoryRegion {
+  uintptr_t base{};
+  size_t size{};
+  // Base of the VirtualAlloc allocation, mapped view or image the region belongs to. Zero for free ranges.
+  uintptr_t allocation_base{};
+  uint32_t protect{};
+  uint32_t type{};
+  uint32_t state{};
+
+  uintptr_t end() const { return base + size; }
+};
+
+// Whether the region is committed memory that can be read without faulting, i.e. neither PAGE_NOACCESS nor PAGE_GUARD.
+bool IsReadable(const MemoryRegion& region);
+
+// Whether the region is an executable section of a loaded image, i.e. module code.
+bool IsExecutableImage(const MemoryRegion& region);
+
+// Whether the region belongs to an image or a mapped view, whose layout rarely changes once mapped.
+bool IsFileBacked(const MemoryRegion& region);
+
+// An executable image loaded in the target.
+struct Module {
+  std::string name;
+  uintptr_t base{};
+  size_t size{};
+
+  uintptr_t end() const { return base + size; }
+};
+
+enum class ProcessAccess : uint8_t {
+  kRead,
+  // Also allows Write(), for freezing values.
+  kReadWrite,
+};
+
+class DumpFile;
+
+// Owning handle to a target process opened for memory inspection, or to a dump standing in for one.
+class Process {
+ public:
+  static std::optional<Process> Open(uint32_t pid, ProcessAccess access = ProcessAccess::kRead);
+
+  // Opens a minidump or raw region dump, see DumpFile, as a read-only target. Every query is answered from the dump,
+  // Write() fails and native_handle() is null. `raw_base` is the address of the first byte of a raw dump.
+  static std::optional<Process> OpenDump(const std::filesystem::path& path, uintptr_t raw_base);
+
+  Process(const Process&) = delete;
+  Process& operator=(const Process&) = delete;
+  Process(Process&& other) noexcept;
+  Process& operator=(Process&& other) noexcept;
+  ~Process();
+
+  uint32_t pid() const { return pid_; }
+
+  // The underlying HANDLE, for platform code that needs more than this interface offers.
+  void* native_handle() const { return handle_; }
+
+  // The dump behind a target from OpenDump(), null for a live process.
+  const DumpFile* dump() const { return dump_.get(); }
+
+  // Walks the whole user address space and returns every readable region, see IsReadable(), in ascending address
+  // order.
+  std::vector<MemoryRegion> QueryRegions() const;
+
+  // Describes the range of pages starting at `address` that share state, protection and type, free ranges included.
+  // Fails past the end of the user address space.
+  std::optional<MemoryRegion> Query(uintptr_t address) const;
+
+  // Returns the modules currently loaded in the target, sorted by base address.
+  std::vector<Module> QueryModules() const;
+
+  // Copies target memory starting at `address` into `out`. Returns the number of bytes actually copied, which is less
+  // than `out.size()` when the range runs into memory that is no longer readable.
+  size_t Read(uintptr_t address, std::span<std::byte> out) const;
+
+  // Copies `data` into target memory at `address` and returns the number of bytes written. Requires a process opened
+  // with ProcessAccess::kReadWrite.
+  size_t Write(uintptr_t address, std::span<const std::byte> data) const;
+
+ private:
+  Process(uint32_t pid, void* handle) : pid_(pid), handle_(handle) {}
+
+  uint32_t pid_{};
+  void* handle_{};
+  std::shared_ptr<const DumpFile> dump_;
+};
+
+}  // namespace maia
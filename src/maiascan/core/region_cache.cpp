@@ -0,0 +1,72 @@
+#include "maiascan/core/region_cache.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "maiascan/core/perf.hpp"
+
+namespace maia {
+
+namespace {
+
+bool SameRange(const MemoryRegion& a, const MemoryRegion& b) {
+  return a.base == b.base && a.size == b.size && a.allocation_base == b.allocation_base && a.protect == b.protect &&
+         a.type == b.type && a.state == b.state;
+}
+
+}  // namespace
+
+const std::vector<MemoryRegion>& RegionCache::Refresh() {
+  ScopedPerfTimer timer(PerfCounter::kRegionNs);
+  if (++refreshes_ % kFullWalkInterval == 0) {
+    Invalidate();
+  }
+  std::vector<Allocation> allocations;
+  std::vector<MemoryRegion> regions;
+  stats_ = {};
+
+  uintptr_t address = 0;
+  while (const auto range = process_.Query(address)) {
+    ++stats_.query_calls;
+    address = range->end();
+    if (range->allocation_base == 0) {
+      continue;
+    }
+
+    if (allocations.empty() || allocations.back().base != range->allocation_base) {
+      const auto cached = std::ranges::lower_bound(allocations_, range->allocation_base, {}, &Allocation::base);
+      if (cached != allocations_.end() && cached->base == range->allocation_base && IsFileBacked(*range) &&
+          SameRange(cached->first, *range)) {
+        allocations.push_back(*cached);
+        allocations.back().first_region = regions.size();
+        const auto cached_regions = regions_.begin() + static_cast<ptrdiff_t>(cached->first_region);
+        regions.insert(regions.end(), cached_regions, cached_regions + static_cast<ptrdiff_t>(cached->region_count));
+        address = cached->end;
+        ++stats_.reused_allocations;
+        continue;
+      }
+      allocations.push_back({.base = range->allocation_base, .first = *range, .first_region = regions.size()});
+      ++stats_.queried_allocations;
+    }
+
+    Allocation& allocation = allocations.back();
+    allocation.end = range->end();
+    if (IsReadable(*range)) {
+      regions.push_back(*range);
+      ++allocation.region_count;
+    }
+  }
+
+  PerfAdd(PerfCounter::kRegionQueries, stats_.query_calls);
+  allocations_ = std::move(allocations);
+  regions_ = std::move(regions);
+  return regions_;
+}
+
+bool RegionCache::Overlaps(uintptr_t address, size_t size) const {
+  const auto region =
+      std::ranges::partition_point(regions_, [&](const MemoryRegion& region) { return region.end() <= address; });
+  return region != regions_.end() && region->base < address + size;
+}
+
+}  // namespace maia
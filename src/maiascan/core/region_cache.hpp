@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "maiascan/core/process.hpp"
+
+namespace maia {
+
+struct RegionCacheStats {
+  // Process::Query() calls made by the last refresh.
+  uint64_t query_calls{};
+  // Allocations of the last refresh whose regions were carried over after a single query, and those walked in full.
+  size_t reused_allocations{};
+  size_t queried_allocations{};
+};
+
+// The readable regions of a target, kept between scans and refreshed incrementally so that a process with hundreds of
+// thousands of regions is not walked one VirtualQueryEx call per region before every scan.
+//
+// A refresh still visits every allocation, but an allocation of an image or a mapped view whose first range is
+// unchanged since the previous refresh is taken to be unchanged as a whole: its regions are carried over and the walk
+// jumps past it. Such layouts only change when the target itself calls VirtualProtect on them past their first range,
+// which nothing short of a full walk notices, so every kFullWalkInterval-th refresh walks all allocations again and
+// Invalidate() forces the next one to. Private allocations, whose commits and protections move all the time, are
+// walked in full.
+//
+// Not thread-safe; meant to be owned by a single scanner.
+class RegionCache {
+ public:
+  // Refreshes between two full walks, which bounds how long a re-protected image stays stale.
+  static constexpr uint64_t kFullWalkInterval = 16;
+
+  explicit RegionCache(const Process& process) : process_(process) {}
+
+  // Brings the map up to date and returns the readable regions in ascending address order, as
+  // Process::QueryRegions() would.
+  const std::vector<MemoryRegion>& Refresh();
+
+  // Regions as of the last refresh.
+  const std::vector<MemoryRegion>& regions() const { return regions_; }
+
+  // Whether any part of [address, address + size) was readable at the last refresh.
+  bool Overlaps(uintptr_t address, size_t size) const;
+
+  // Makes the next refresh walk every allocation again, e.g. after the target re-protected part of an image.
+  void Invalidate() { allocations_.clear(); }
+
+  const RegionCacheStats& stats() const { return stats_; }
+
+ private:
+  struct Allocation {
+    uintptr_t base{};
+    uintptr_t end{};
+    // First range of the allocation as last queried, compared with a fresh query to tell whether it changed.
+    MemoryRegion first;
+    // Readable regions of the allocation are regions_[first_region, first_region + region_count).
+    size_t first_region{};
+    size_t region_count{};
+  };
+
+  const Process& process_;
+  std::vector<Allocation> allocations_;
+  std::vector<MemoryRegion> regions_;
+  uint64_t refreshes_{};
+  RegionCacheStats stats_;
+};
+
+}  // namespace maia
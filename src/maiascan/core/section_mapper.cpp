@@ -0,0 +1,221 @@
+#include "maiascan/core/section_mapper.hpp"
+
+#include <windows.h>
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+
+#include "maiascan/core/bits.hpp"
+#include "maiascan/core/memory_reader.hpp"
+
+namespace maia {
+
+namespace {
+
+constexpr DWORD kSharedProtections = PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE | PAGE_EXECUTE_READ |
+                                     PAGE_EXECUTE_READWRITE;
+constexpr DWORD kImmutableProtections = PAGE_READONLY | PAGE_EXECUTE | PAGE_EXECUTE_READ;
+// Pages looked up per QueryWorkingSetEx call.
+constexpr size_t kWorkingSetBatch = 1024;
+
+bool IsEligible(const MemoryRegion& region) {
+  if (region.type == MEM_MAPPED) {
+    return (region.protect & kSharedProtections) != 0;
+  }
+  if (region.type == MEM_IMAGE) {
+    return (region.protect & kImmutableProtections) != 0;
+  }
+  return false;
+}
+
+// NT device path of the file backing the view at `address`, e.g. \Device\HarddiskVolume3\Games\game.exe.
+std::wstring MappedFileName(HANDLE process, uintptr_t address) {
+  std::array<WCHAR, 1024> name{};
+  const DWORD length =
+      GetMappedFileNameW(process, reinterpret_cast<LPVOID>(address), name.data(), static_cast<DWORD>(name.size()));
+  return {name.data(), length};
+}
+
+// Bytes spanned by the local allocation starting at `base`, across all of its regions.
+size_t LocalAllocationSize(uintptr_t base) {
+  MEMORY_BASIC_INFORMATION info{};
+  uintptr_t end = base;
+  while (VirtualQuery(reinterpret_cast<LPCVOID>(end), &info, sizeof(info)) == sizeof(info) &&
+         reinterpret_cast<uintptr_t>(info.AllocationBase) == base) {
+    end = reinterpret_cast<uintptr_t>(info.BaseAddress) + info.RegionSize;
+  }
+  return end - base;
+}
+
+// Bitmap of the pages of [base, base + page_count pages) that `process` has resident and still backed by the section
+// they were mapped from. Pages that are paged out or were replaced by a private copy on write are left clear.
+std::vector<uint64_t> SharedPages(HANDLE process, uintptr_t base, size_t page_count) {
+  std::vector<uint64_t> pages(WordCount(page_count));
+  std::vector<PSAPI_WORKING_SET_EX_INFORMATION> batch;
+  for (size_t first = 0; first < page_count; first += kWorkingSetBatch) {
+    const size_t count = std::min(kWorkingSetBatch, page_count - first);
+    batch.assign(count, {});
+    for (size_t i = 0; i < count; ++i) {
+      batch[i].VirtualAddress = reinterpret_cast<PVOID>(base + (first + i) * kPageSize);
+    }
+    if (!QueryWorkingSetEx(process, batch.data(), static_cast<DWORD>(count * sizeof(batch[0])))) {
+      std::fill(pages.begin(), pages.end(), 0);
+      return pages;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      if (batch[i].VirtualAttributes.Valid && batch[i].VirtualAttributes.Shared) {
+        SetBit(pages.data(), first + i);
+      }
+    }
+  }
+  return pages;
+}
+
+}  // namespace
+
+SectionMapper::~SectionMapper() {
+  for (const auto& allocation : allocations_) {
+    if (allocation.owned_view != nullptr) {
+      UnmapViewOfFile(allocation.owned_view);
+    }
+  }
+}
+
+SectionMapper::Allocation SectionMapper::MapAllocation(const MemoryRegion& region) const {
+  Allocation allocation{.base = region.allocation_base, .owned_view = nullptr, .size = 0};
+  const std::wstring target_file = MappedFileName(process_.native_handle(), region.allocation_base);
+  if (target_file.empty()) {
+    // Pagefile-backed sections have no name that could be opened from here.
+    return allocation;
+  }
+
+  const bool image = region.type == MEM_IMAGE;
+  if (image && MappedFileName(GetCurrentProcess(), region.allocation_base) == target_file) {
+    // The same image is loaded at the same base in this process, so the pages both sides still share with the image
+    // section are already identical.
+    allocation.size = LocalAllocationSize(region.allocation_base);
+    return allocation;
+  }
+
+  // The \\?\GLOBALROOT prefix lets CreateFileW open NT device paths directly.
+  HANDLE file = CreateFileW((L"\\\\?\\GLOBALROOT" + target_file).c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return allocation;
+  }
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY | (image ? SEC_IMAGE : 0), 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return allocation;
+  }
+  // Images must land on the target's base, otherwise relocated pages differ.
+  void* view = MapViewOfFileEx(
+      mapping, FILE_MAP_READ, 0, 0, 0, image ? reinterpret_cast<LPVOID>(region.allocation_base) : nullptr);
+  CloseHandle(mapping);
+  if (view == nullptr) {
+    return allocation;
+  }
+  allocation.owned_view = view;
+  allocation.size = LocalAllocationSize(reinterpret_cast<uintptr_t>(view));
+  return allocation;
+}
+
+void SectionMapper::AddSharedRuns(const View& view, bool local_module, std::vector<View>& views) const {
+  const size_t page_count = view.size / kPageSize;
+  auto shared = SharedPages(process_.native_handle(), view.base, page_count);
+  if (local_module) {
+    // Touch every local page first, so that pages merely paged out are not mistaken for private ones.
+    for (size_t page = 0; page < page_count; ++page) {
+      static_cast<void>(*reinterpret_cast<const volatile std::byte*>(view.local + page * kPageSize));
+    }
+    const auto local = SharedPages(GetCurrentProcess(), reinterpret_cast<uintptr_t>(view.local), page_count);
+    for (size_t i = 0; i < shared.size(); ++i) {
+      shared[i] &= local[i];
+    }
+  }
+  size_t first = 0;
+  for (size_t page = 0; page <= page_count; ++page) {
+    if (page < page_count && TestBit(shared.data(), page)) {
+      continue;
+    }
+    if (page > first) {
+      const View run{.base = view.base + first * kPageSize,
+                     .size = (page - first) * kPageSize,
+                     .local = view.local + first * kPageSize};
+      if (Verify(run)) {
+        views.push_back(run);
+      }
+    }
+    first = page + 1;
+  }
+}
+
+bool SectionMapper::Verify(const View& view) const {
+  std::array<std::byte, kPageSize> page{};
+  const size_t sample = std::min(view.size, kPageSize);
+  for (const size_t offset : {size_t{0}, view.size - sample}) {
+    if (process_.Read(view.base + offset, std::span(page.data(), sample)) != sample ||
+        std::memcmp(page.data(), view.local + offset, sample) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SectionMapper::Map(std::span<const MemoryRegion> regions) {
+  std::vector<View> views;
+  for (const auto& region : regions) {
+    if (!IsEligible(region)) {
+      continue;
+    }
+    auto allocation = std::find_if(allocations_.begin(), allocations_.end(), [&](const Allocation& candidate) {
+      return candidate.base == region.allocation_base;
+    });
+    if (allocation == allocations_.end()) {
+      allocations_.push_back(MapAllocation(region));
+      allocation = allocations_.end() - 1;
+    }
+    const size_t offset = region.base - region.allocation_base;
+    if (allocation->size < offset + region.size) {
+      continue;
+    }
+    const auto* local = static_cast<const std::byte*>(
+        allocation->owned_view != nullptr ? allocation->owned_view : reinterpret_cast<void*>(allocation->base));
+    AddSharedRuns({.base = region.base, .size = region.size, .local = local + offset},
+                  allocation->owned_view == nullptr,
+                  views);
+  }
+  views_ = std::move(views);
+}
+
+std::span<const std::byte> SectionMapper::Find(uintptr_t address, size_t size) const {
+  auto it = std::upper_bound(
+      views_.begin(), views_.end(), address, [](uintptr_t value, const View& view) { return value < view.base; });
+  if (it == views_.begin()) {
+    return {};
+  }
+  --it;
+  if (address + size > it->base + it->size) {
+    return {};
+  }
+  return {it->local + (address - it->base), size};
+}
+
+uint64_t SectionMapper::mapped_bytes() const {
+  uint64_t total = 0;
+  for (const auto& view : views_) {
+    total += view.size;
+  }
+  return total;
+}
+
+}  // namespace maia
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/process.hpp"
+
+namespace maia {
+
+// Makes section-backed regions of the target readable in place, without copying them through ReadProcessMemory.
+//
+// Windows offers no way to map another process's private memory, but pages that are views of a section can be
+// reproduced locally by mapping the same backing object:
+//  * MEM_MAPPED views of a file are coherent with any other view of that file, so the file is mapped read-only here.
+//  * MEM_IMAGE pages that still come from the image section hold the same bytes in every process that maps the image
+//    at the same base. Our own copy is used when the image is already loaded here, otherwise it is mapped with
+//    SEC_IMAGE at the target's base.
+// A page stops coming from its section as soon as it is written, even when it is read-only again afterwards: patched
+// code and import tables the loader filled in are private copies in the target that a fresh view does not have. Only
+// pages the target has resident and still shared with the section (per QueryWorkingSetEx) are read in place; the rest,
+// like private memory, keeps going through the normal read path. Every run of such pages is also checked against a
+// real read of its first and last page before it is used.
+class SectionMapper {
+ public:
+  explicit SectionMapper(const Process& process) : process_(process) {}
+  SectionMapper(const SectionMapper&) = delete;
+  SectionMapper& operator=(const SectionMapper&) = delete;
+  ~SectionMapper();
+
+  // Tries to map every eligible region of `regions`. Allocations mapped by an earlier call are reused, so calling this
+  // before every scan only pays for new allocations.
+  void Map(std::span<const MemoryRegion> regions);
+
+  // Returns the local view of [address, address + size) if that range lies entirely within one mapped region.
+  std::span<const std::byte> Find(uintptr_t address, size_t size) const;
+
+  // Bytes of target memory currently readable in place.
+  uint64_t mapped_bytes() const;
+
+ private:
+  struct View {
+    uintptr_t base;
+    size_t size;
+    const std::byte* local;
+  };
+
+  struct Allocation {
+    uintptr_t base;
+    // Local view to unmap on destruction; nullptr when the view is a module of our own process.
+    void* owned_view;
+    // Bytes of the local view, or zero when mapping the allocation failed and should not be retried.
+    size_t size;
+  };
+
+  Allocation MapAllocation(const MemoryRegion& region) const;
+  // Appends to `views` the runs of pages of `view` that can be read in place. `local_module` is set when the local
+  // side is a module of our own process, whose pages can be private copies as well.
+  void AddSharedRuns(const View& view, bool local_module, std::vector<View>& views) const;
+  bool Verify(const View& view) const;
+
+  const Process& process_;
+  std::vector<Allocation> allocations_;
+  // Sorted by base.
+  std::vector<View> views_;
+};
+
+}  // namespace maia
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+namespace maia {
+
+// Bounded lock-free queue between exactly one producer thread and one consumer thread. Neither side ever blocks or
+// allocates: a full ring rejects the push and an empty one returns nothing, leaving it to the caller to retry later.
+template <typename T>
+class SpscRing {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit SpscRing(size_t capacity)
+      : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1), slots_(std::make_unique<T[]>(mask_ + 1)) {}
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Producer side. Returns false, without touching the ring, when it is full.
+  bool TryPush(const T& item) {
+    const size_t tail = producer_.tail.load(std::memory_order_relaxed);
+    if (tail - producer_.cached_head > mask_) {
+      producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+      if (tail - producer_.cached_head > mask_) {
+        return false;
+      }
+    }
+    slots_[tail & mask_] = item;
+    producer_.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Moves up to `out.size()` items into `out` and returns how many there were.
+  size_t PopBatch(std::span<T> out) {
+    const size_t head = consumer_.head.load(std::memory_order_relaxed);
+    if (consumer_.cached_tail == head) {
+      consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+    }
+    const size_t count = std::min(out.size(), consumer_.cached_tail - head);
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = slots_[(head + i) & mask_];
+    }
+    consumer_.head.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+ private:
+  // Each side keeps its index on its own cache line together with its last view of the other side's index, so the
+  // threads only touch each other's line when that view runs out.
+  struct alignas(64) Consumer {
+    std::atomic<size_t> head{};
+    size_t cached_tail{};
+  };
+  struct alignas(64) Producer {
+    std::atomic<size_t> tail{};
+    size_t cached_head{};
+  };
+
+  const size_t mask_;
+  std::unique_ptr<T[]> slots_;
+  Consumer consumer_;
+  Producer producer_;
+};
+
+}  // namespace maia
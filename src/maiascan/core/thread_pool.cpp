@@ -0,0 +1,164 @@
+#include "maiascan/core/thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "maiascan/core/perf.hpp"
+
+namespace maia {
+
+namespace {
+
+// Indices a single pass can schedule; larger calls run as several passes.
+constexpr size_t kMaxPassCount = std::numeric_limits<uint32_t>::max();
+
+constexpr uint64_t Pack(uint64_t begin, uint64_t end) { return end << 32 | begin; }
+constexpr uint64_t BeginOf(uint64_t bounds) { return bounds & 0xFFFFFFFFU; }
+constexpr uint64_t EndOf(uint64_t bounds) { return bounds >> 32; }
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t thread_count, bool pin_to_nodes) {
+  if (thread_count == 0) {
+    thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  if (pin_to_nodes) {
+    nodes_ = AssignNodes(thread_count);
+  }
+  ranges_ = std::vector<WorkRange>(thread_count);
+  workers_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count, const IndexFn& fn) {
+  std::unique_lock lock(mutex_);
+  for (size_t offset = 0; offset < count; offset += kMaxPassCount) {
+    const size_t pass_count = std::min(count - offset, kMaxPassCount);
+    // Every worker starts with an equal contiguous share of the pass.
+    const size_t worker_count = workers_.size();
+    for (size_t i = 0; i < worker_count; ++i) {
+      ranges_[i].bounds.store(Pack(pass_count * i / worker_count, pass_count * (i + 1) / worker_count),
+                              std::memory_order_relaxed);
+    }
+    job_ = &fn;
+    offset_ = offset;
+    busy_ = worker_count;
+    ++generation_;
+    wake_.notify_all();
+    done_.wait(lock, [this] { return busy_ == 0; });
+  }
+  job_ = nullptr;
+}
+
+std::vector<uint64_t> ThreadPool::busy_ns() const {
+  std::vector<uint64_t> busy;
+  busy.reserve(ranges_.size());
+  for (const auto& range : ranges_) {
+    busy.push_back(range.busy_ns.load(std::memory_order_relaxed));
+  }
+  return busy;
+}
+
+void ThreadPool::WorkerLoop(size_t worker) {
+  if (!nodes_.empty()) {
+    PinCurrentThreadToNode(nodes_[worker]);
+  }
+  uint64_t seen_generation = 0;
+  while (true) {
+    const IndexFn* job = nullptr;
+    size_t offset = 0;
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+      job = job_;
+      offset = offset_;
+    }
+
+    if (PerfEnabled()) {
+      const auto start = std::chrono::steady_clock::now();
+      Drain(worker, *job, offset);
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      auto& busy = ranges_[worker].busy_ns;
+      busy.store(busy.load(std::memory_order_relaxed) +
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                 std::memory_order_relaxed);
+    } else {
+      Drain(worker, *job, offset);
+    }
+
+    std::lock_guard lock(mutex_);
+    if (--busy_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::Drain(size_t worker, const IndexFn& job, size_t offset) {
+  size_t index = 0;
+  while (Pop(worker, index) || Steal(worker, index)) {
+    job(offset + index, worker);
+  }
+}
+
+bool ThreadPool::Pop(size_t worker, size_t& index) {
+  auto& bounds = ranges_[worker].bounds;
+  uint64_t current = bounds.load(std::memory_order_acquire);
+  while (BeginOf(current) < EndOf(current)) {
+    if (bounds.compare_exchange_weak(current, Pack(BeginOf(current) + 1, EndOf(current)), std::memory_order_acq_rel)) {
+      index = BeginOf(current);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::PeekNext(size_t worker, size_t& index) const {
+  const uint64_t current = ranges_[worker].bounds.load(std::memory_order_relaxed);
+  if (BeginOf(current) >= EndOf(current)) {
+    return false;
+  }
+  index = offset_ + BeginOf(current);
+  return true;
+}
+
+bool ThreadPool::Steal(size_t worker, size_t& index) {
+  // Indices are only ever moved between ranges, never copied, so a sweep that finds every range empty means every
+  // index has been claimed; a range in flight between a victim and its thief is run by that thief.
+  const size_t worker_count = workers_.size();
+  for (size_t i = 1; i < worker_count; ++i) {
+    auto& bounds = ranges_[(worker + i) % worker_count].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    while (BeginOf(current) < EndOf(current)) {
+      const uint64_t begin = BeginOf(current);
+      const uint64_t end = EndOf(current);
+      const uint64_t split = end - (end - begin + 1) / 2;
+      if (bounds.compare_exchange_weak(current, Pack(begin, split), std::memory_order_acq_rel)) {
+        // Run the first stolen index now and make the rest stealable in turn.
+        ranges_[worker].bounds.store(Pack(split + 1, end), std::memory_order_release);
+        index = split;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace maia
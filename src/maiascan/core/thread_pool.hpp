@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "maiascan/core/numa.hpp"
+
+namespace maia {
+
+// Fixed set of worker threads that cooperatively drain index ranges. Every call splits the range into one contiguous
+// piece per worker, which a worker consumes from the front; a worker that runs out steals the back half of whatever
+// another one has left. Neighbouring indices, which for scans are neighbouring shards of the same region, therefore
+// stay on one thread, and a single huge region is split between idle workers only once they have nothing else to do.
+class ThreadPool {
+ public:
+  // Invoked as `fn(index, worker)`; `worker` is stable for the duration of the call and lies in [0, size()), which
+  // lets callers keep per-worker scratch state without locking.
+  using IndexFn = std::function<void(size_t index, size_t worker)>;
+
+  // A `thread_count` of zero sizes the pool to the number of hardware threads. With `pin_to_nodes` every worker is
+  // bound to the processors of one NUMA node (see AssignNodes()), so that it stays next to the buffers it reads into.
+  explicit ThreadPool(size_t thread_count = 0, bool pin_to_nodes = false);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  size_t size() const { return workers_.size(); }
+
+  // NUMA node `worker` is pinned to, or kAnyNode when the pool is not pinned.
+  uint32_t node(size_t worker) const { return nodes_.empty() ? kAnyNode : nodes_[worker]; }
+
+  // Runs `fn` for every index in [0, count) and blocks until all of them completed. Not reentrant.
+  void ParallelFor(size_t count, const IndexFn& fn);
+
+  // Called from within a job: the index `worker` will most likely run next, which is the front of what is left of its
+  // own share. Only a hint, since another worker may steal it in the meantime. Returns false when the share is empty.
+  bool PeekNext(size_t worker, size_t& index) const;
+
+  // Nanoseconds each worker spent running jobs, counted only while performance instrumentation is enabled.
+  std::vector<uint64_t> busy_ns() const;
+
+ private:
+  // Remaining indices [begin, end) of one worker, packed as `end << 32 | begin` so that the owner and thieves can
+  // update it with a single compare-exchange.
+  struct alignas(64) WorkRange {
+    std::atomic<uint64_t> bounds{};
+    // Written by the owning worker only.
+    std::atomic<uint64_t> busy_ns{};
+  };
+
+  void WorkerLoop(size_t worker);
+  void Drain(size_t worker, const IndexFn& job, size_t offset);
+  bool Pop(size_t worker, size_t& index);
+  bool Steal(size_t worker, size_t& index);
+
+  std::vector<std::thread> workers_;
+  // Node of every worker when pinned, otherwise empty.
+  std::vector<uint32_t> nodes_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const IndexFn* job_{};
+  size_t offset_{};
+  std::vector<WorkRange> ranges_;
+  size_t busy_{};
+  uint64_t generation_{};
+  bool stopping_{};
+};
+
+}  // namespace maia
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace maia {
+
+// Longest encoding of a 64-bit value.
+inline constexpr size_t kMaxVarintSize = 10;
+
+// Appends `value` as LEB128: seven bits per byte, least significant group first, high bit set on all but the last.
+inline void AppendVarint(std::vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+// Writes `value` as LEB128 to `out`, which needs room for kMaxVarintSize bytes, and returns the bytes written.
+inline size_t WriteVarint(uint8_t* out, uint64_t value) {
+  size_t size = 0;
+  while (value >= 0x80) {
+    out[size++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  out[size++] = static_cast<uint8_t>(value);
+  return size;
+}
+
+// Decodes one LEB128 value from [data, end) and advances `data` past it. Returns false on truncated or overlong input.
+inline bool ReadVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+  value = 0;
+  for (size_t shift = 0; data < end && shift < 64; shift += 7) {
+    const uint8_t byte = *data++;
+    value |= uint64_t{byte & 0x7FU} << shift;
+    if ((byte & 0x80U) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Maps signed deltas to unsigned ones so that small magnitudes of either sign encode to short varints.
+inline uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+}  // namespace maia
@@ -0,0 +1,62 @@
+#include "maiascan/gui/job_queue.hpp"
+
+#include <utility>
+
+namespace maia::gui {
+
+JobQueue::JobQueue() : thread_([this] { Run(); }) {}
+
+JobQueue::~JobQueue() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  CancelAll();
+  wake_.notify_all();
+  thread_.join();
+}
+
+std::shared_ptr<ScanProgress> JobQueue::Submit(Job job) {
+  auto progress = std::make_shared<ScanProgress>();
+  {
+    std::lock_guard lock(mutex_);
+    queue_.push_back({.job = std::move(job), .progress = progress});
+  }
+  wake_.notify_one();
+  return progress;
+}
+
+void JobQueue::CancelAll() {
+  std::lock_guard lock(mutex_);
+  if (running_) {
+    running_->Cancel();
+  }
+  for (Entry& entry : queue_) {
+    entry.progress->Cancel();
+  }
+}
+
+bool JobQueue::busy() const {
+  std::lock_guard lock(mutex_);
+  return running_ || !queue_.empty();
+}
+
+void JobQueue::Run() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    // Queued jobs are already cancelled when stopping, so draining them is quick.
+    if (queue_.empty()) {
+      return;
+    }
+    Entry entry = std::move(queue_.front());
+    queue_.pop_front();
+    running_ = entry.progress;
+    lock.unlock();
+    entry.job(*entry.progress);
+    lock.lock();
+    running_.reset();
+  }
+}
+
+}  // namespace maia::gui
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "maiascan/scan/scan_progress.hpp"
+
+namespace maia::gui {
+
+// Runs scans one at a time on a thread of its own, so that the render thread only ever submits work, samples
+// progress and picks up results, and never waits for a scan. Every job gets a ScanProgress of its own, which doubles
+// as its cancellation token: the render thread samples it without locking and cancels it to make the job's scan stop
+// after the shards in flight.
+class JobQueue {
+ public:
+  using Job = std::function<void(ScanProgress& progress)>;
+
+  JobQueue();
+  JobQueue(const JobQueue&) = delete;
+  JobQueue& operator=(const JobQueue&) = delete;
+  // Cancels the running and queued jobs and waits for the running one to return.
+  ~JobQueue();
+
+  // Queues `job` behind the others and returns its progress. Jobs that are cancelled before they start still run, on
+  // a cancelled progress, so that they can hand off whatever they have to.
+  std::shared_ptr<ScanProgress> Submit(Job job);
+
+  // Cancels every job submitted so far.
+  void CancelAll();
+
+  // Whether a job is running or queued.
+  bool busy() const;
+
+ private:
+  struct Entry {
+    Job job;
+    std::shared_ptr<ScanProgress> progress;
+  };
+
+  void Run();
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<Entry> queue_;
+  std::shared_ptr<ScanProgress> running_;
+  bool stopping_{};
+  std::thread thread_;
+};
+
+}  // namespace maia::gui
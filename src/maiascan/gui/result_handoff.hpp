@@ -0,0 +1,45 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace maia::gui {
+
+// Passes the latest value a job produced to the render thread through two slots: the job moves its finished value
+// into the shared one, and the render thread moves it from there into the one it draws from. Neither side copies a
+// result or holds the lock for longer than a few moves, values are destroyed outside of it, and the render thread
+// keeps drawing its current value until it takes a newer one. A value not taken before the next one is published is
+// dropped.
+template <typename T>
+class ResultHandoff {
+ public:
+  // Job side.
+  void Publish(T value) {
+    std::optional<T> stale;
+    {
+      std::lock_guard lock(mutex_);
+      stale = std::exchange(pending_, std::move(value));
+    }
+  }
+
+  // Render side: replaces `out` with the latest published value and returns whether there was one. The value `out`
+  // held before is destroyed after the lock is released.
+  bool Take(std::optional<T>& out) {
+    std::optional<T> previous;
+    {
+      std::lock_guard lock(mutex_);
+      if (!pending_) {
+        return false;
+      }
+      previous = std::exchange(out, std::exchange(pending_, std::nullopt));
+    }
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::optional<T> pending_;
+};
+
+}  // namespace maia::gui
@@ -0,0 +1,93 @@
+#include "maiascan/gui/result_pages.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "maiascan/core/bits.hpp"
+
+namespace maia::gui {
+
+ResultPages::ResultPages(const Process& process, std::chrono::steady_clock::duration refresh)
+    : reader_(process, 1), refresh_(refresh) {}
+
+void ResultPages::Reset(const CandidateSet& candidates) {
+  type_ = candidates.type;
+  pager_ = CandidatePager(candidates);
+  arena_ = candidates.arena;
+  pages_.clear();
+}
+
+void ResultPages::Fetch(size_t first, size_t last) {
+  ++fetches_;
+  last = std::min(last, size());
+  if (first >= last) {
+    return;
+  }
+  for (size_t page = first / kPageRows; page <= (last - 1) / kPageRows; ++page) {
+    FindOrLoad(page).used = fetches_;
+  }
+}
+
+const ResultRow& ResultPages::row(size_t index) const {
+  const size_t first = index / kPageRows * kPageRows;
+  const auto page = std::ranges::find(pages_, first, &Page::first);
+  return page->rows[index - first];
+}
+
+ResultPages::Page& ResultPages::FindOrLoad(size_t page_index) {
+  const size_t first = page_index * kPageRows;
+  auto page = std::ranges::find(pages_, first, &Page::first);
+  if (page == pages_.end()) {
+    if (pages_.size() < kCachedPages) {
+      page = pages_.insert(pages_.end(), Page{});
+    } else {
+      page = std::ranges::min_element(pages_, {}, &Page::used);
+    }
+    page->first = first;
+    Load(*page);
+  } else if (std::chrono::steady_clock::now() - page->fetched >= refresh_) {
+    Load(*page);
+  }
+  return *page;
+}
+
+void ResultPages::Load(Page& page) {
+  std::vector<uintptr_t> addresses(std::min(kPageRows, size() - page.first));
+  addresses.resize(pager_.Read(page.first, addresses));
+  page.rows.resize(addresses.size());
+  page.fetched = std::chrono::steady_clock::now();
+
+  // Ranks follow address order, so every cluster is a run of consecutive rows. The first row always fits its own
+  // cluster since values are at most 8 bytes.
+  const size_t value_size = SizeOf(type_);
+  for (size_t begin = 0; begin < addresses.size();) {
+    const uintptr_t base = addresses[begin] / kPageSize * kPageSize;
+    uint64_t pages = 0;
+    size_t end = begin;
+    size_t span = 0;
+    for (; end < addresses.size(); ++end) {
+      const uintptr_t first_page = (addresses[end] - base) / kPageSize;
+      const uintptr_t last_page = (addresses[end] + value_size - 1 - base) / kPageSize;
+      if (last_page >= kClusterPages) {
+        break;
+      }
+      pages |= uint64_t{1} << first_page;
+      pages |= uint64_t{1} << last_page;
+      span = (last_page + 1) * kPageSize;
+    }
+    const auto data = reader_.ReadPages(0, base, span, &pages);
+    for (size_t i = begin; i < end; ++i) {
+      ResultRow& row = page.rows[i];
+      const size_t offset = addresses[i] - base;
+      row.address = addresses[i];
+      row.readable = !data.empty() && TestBit(&pages, offset / kPageSize) &&
+                     TestBit(&pages, (offset + value_size - 1) / kPageSize);
+      if (row.readable) {
+        std::memcpy(row.value.data(), data.data() + offset, value_size);
+      }
+    }
+    begin = end;
+  }
+}
+
+}  // namespace maia::gui
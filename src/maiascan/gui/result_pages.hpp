@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "maiascan/core/arena.hpp"
+#include "maiascan/core/memory_reader.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/scan/candidates.hpp"
+#include "maiascan/scan/value.hpp"
+
+namespace maia::gui {
+
+// One row of the result table: a candidate and its current value.
+struct ResultRow {
+  uintptr_t address{};
+  // False when the value could not be read; `value` is then unspecified.
+  bool readable{};
+  std::array<std::byte, 8> value{};
+};
+
+// Rows of a scan result for a view that only ever shows a screenful of them. Rows are fetched by rank a page at a
+// time: the addresses come from a CandidatePager without expanding the result, and the values of a page are read
+// with one MemoryReader::ReadPages() call per cluster of nearby addresses, so a visible page of 256 rows typically
+// costs a handful of reads. A few recently used pages are cached and re-read once they are older than the refresh
+// period, which keeps the values of the visible rows live without reading anything else.
+class ResultPages {
+ public:
+  static constexpr size_t kPageRows = 256;
+  // Enough for a tall table plus the pages on either side of it.
+  static constexpr size_t kCachedPages = 16;
+  // Addresses within this many pages of the first address of a cluster are read together, see Watcher::kSpanPages.
+  static constexpr size_t kClusterPages = 64;
+
+  explicit ResultPages(const Process& process,
+                       std::chrono::steady_clock::duration refresh = std::chrono::milliseconds(250));
+
+  // Shows the rows of `candidates`, dropping every cached page.
+  void Reset(const CandidateSet& candidates);
+
+  size_t size() const { return pager_.size(); }
+  ValueType type() const { return type_; }
+
+  // Makes rows [first, last) available to row(), reading the pages that are missing or stale. Call once per frame
+  // with the visible range.
+  void Fetch(size_t first, size_t last);
+
+  // Row `index`, which must lie in the range of the latest Fetch().
+  const ResultRow& row(size_t index) const;
+
+  // Reads issued so far, for the status line.
+  uint64_t read_calls() const { return reader_.stats().calls; }
+
+ private:
+  struct Page {
+    size_t first{};
+    std::vector<ResultRow> rows;
+    std::chrono::steady_clock::time_point fetched;
+    // Fetch() count of the last use, for evicting the least recently used page.
+    uint64_t used{};
+  };
+
+  Page& FindOrLoad(size_t page_index);
+  void Load(Page& page);
+
+  MemoryReader reader_;
+  std::chrono::steady_clock::duration refresh_;
+  ValueType type_{ValueType::kInt32};
+  CandidatePager pager_{0};
+  // Keeps the blocks of `pager_` alive.
+  std::shared_ptr<Arena> arena_;
+  std::vector<Page> pages_;
+  uint64_t fetches_{};
+};
+
+}  // namespace maia::gui
@@ -0,0 +1,52 @@
+#include "maiascan/gui/result_table.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <climits>
+#include <string>
+
+#include <imgui.h>
+
+namespace maia::gui {
+
+void DrawResultTable(ResultPages& pages) {
+  constexpr ImGuiTableFlags kFlags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                     ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable;
+  if (!ImGui::BeginTable("results", 3, kFlags)) {
+    return;
+  }
+  ImGui::TableSetupScrollFreeze(0, 1);
+  ImGui::TableSetupColumn("#", ImGuiTableColumnFlags_WidthFixed);
+  ImGui::TableSetupColumn("Address", ImGuiTableColumnFlags_WidthFixed);
+  ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthStretch);
+  ImGui::TableHeadersRow();
+
+  // Passing the row height up front spares the clipper its measuring step, which would fetch the first page every
+  // frame no matter where the table is scrolled to. The clipper counts in int, which caps the rows shown.
+  const float row_height = ImGui::GetTextLineHeight() + 2 * ImGui::GetStyle().CellPadding.y;
+  ImGuiListClipper clipper;
+  clipper.Begin(static_cast<int>(std::min<size_t>(pages.size(), INT_MAX)), row_height);
+  while (clipper.Step()) {
+    const auto first = static_cast<size_t>(clipper.DisplayStart);
+    const auto last = static_cast<size_t>(clipper.DisplayEnd);
+    pages.Fetch(first, last);
+    for (size_t index = first; index < last; ++index) {
+      const ResultRow& row = pages.row(index);
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%zu", index);
+      ImGui::TableNextColumn();
+      ImGui::Text("%016" PRIxPTR, row.address);
+      ImGui::TableNextColumn();
+      if (row.readable) {
+        const std::string value = FormatValue(pages.type(), row.value.data());
+        ImGui::TextUnformatted(value.data(), value.data() + value.size());
+      } else {
+        ImGui::TextDisabled("??");
+      }
+    }
+  }
+  ImGui::EndTable();
+}
+
+}  // namespace maia::gui
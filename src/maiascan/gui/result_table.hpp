@@ -0,0 +1,12 @@
+#pragma once
+
+#include "maiascan/gui/result_pages.hpp"
+
+namespace maia::gui {
+
+// Draws the rows of `pages` as a scrolling table that fills the remaining space of the current window. Only the rows
+// ImGuiListClipper reports as visible are fetched and formatted, so the cost of a frame does not depend on the size of
+// the result.
+void DrawResultTable(ResultPages& pages);
+
+}  // namespace maia::gui
@@ -0,0 +1,163 @@
+#include "maiascan/gui/scan_window.hpp"
+
+#include <utility>
+
+#include <fmt/core.h>
+#include <imgui.h>
+
+#include "maiascan/gui/result_table.hpp"
+
+namespace maia::gui {
+
+void ScanWindow::Draw() {
+  TakeOutcome();
+  const bool busy = jobs_.busy();
+
+  const ImGuiViewport* viewport = ImGui::GetMainViewport();
+  ImGui::SetNextWindowPos(viewport->WorkPos);
+  ImGui::SetNextWindowSize(viewport->WorkSize);
+  constexpr ImGuiWindowFlags kFlags =
+      ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBringToFrontOnFocus;
+  ImGui::Begin("maiascan", nullptr, kFlags);
+
+  ImGui::BeginDisabled(busy);
+  ImGui::SetNextItemWidth(120);
+  ImGui::InputInt("PID", &pid_, 0);
+  ImGui::SameLine();
+  if (ImGui::Button("Attach")) {
+    Attach();
+  }
+  ImGui::EndDisabled();
+  ImGui::SetNextItemWidth(80);
+  // The names of value types are literals, so their views are null-terminated.
+  if (ImGui::BeginCombo("Type", ToString(type_).data())) {
+    for (auto i = static_cast<int>(ValueType::kInt8); i <= static_cast<int>(ValueType::kDouble); ++i) {
+      const auto type = static_cast<ValueType>(i);
+      if (ImGui::Selectable(ToString(type).data(), type == type_)) {
+        type_ = type;
+      }
+    }
+    ImGui::EndCombo();
+  }
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(200);
+  ImGui::InputText("Value", value_.data(), value_.size());
+
+  ImGui::BeginDisabled(busy || !scanner_);
+  if (ImGui::Button("First scan")) {
+    RunFirstScan();
+  }
+  ImGui::SameLine();
+  ImGui::BeginDisabled(!result_);
+  if (ImGui::Button("Next scan")) {
+    RunNextScan();
+  }
+  ImGui::EndDisabled();
+  ImGui::EndDisabled();
+  ImGui::SameLine();
+  ImGui::BeginDisabled(!busy);
+  if (ImGui::Button("Cancel")) {
+    jobs_.CancelAll();
+  }
+  ImGui::EndDisabled();
+  ImGui::SameLine();
+  ImGui::TextUnformatted(status_.c_str());
+
+  if (busy) {
+    DrawProgress();
+  }
+  if (pages_ && result_) {
+    DrawResultTable(*pages_);
+  }
+  ImGui::End();
+}
+
+void ScanWindow::Attach() {
+  // A job publishes its outcome just before the queue stops being busy, so one can still be waiting here. It belongs
+  // to the previous target and is dropped with it.
+  std::optional<ScanOutcome> stale;
+  handoff_.Take(stale);
+  outcome_.reset();
+  pages_.reset();
+  scanner_.reset();
+  result_.reset();
+  process_ = Process::Open(static_cast<uint32_t>(pid_));
+  if (!process_) {
+    status_ = fmt::format("Failed to open process {}", pid_);
+    return;
+  }
+  scanner_ = std::make_unique<Scanner>(*process_, pool_);
+  pages_ = std::make_unique<ResultPages>(*process_);
+  status_ = fmt::format("Attached to process {}", pid_);
+}
+
+std::optional<MatchPredicate> ScanWindow::ParsePredicate() {
+  const auto value = ParseScanValue(type_, value_.data());
+  if (!value) {
+    status_ = fmt::format("Invalid {} value: {}", ToString(type_), value_.data());
+    return std::nullopt;
+  }
+  return MakeExactPredicate(*value);
+}
+
+void ScanWindow::RunFirstScan() {
+  const auto predicate = ParsePredicate();
+  if (!predicate) {
+    return;
+  }
+  Submit([predicate = *predicate](Scanner& scanner) { return scanner.FirstScan(predicate); });
+}
+
+void ScanWindow::RunNextScan() {
+  const auto predicate = ParsePredicate();
+  if (!predicate) {
+    return;
+  }
+  if (type_ != result_->candidates.type) {
+    status_ = "Next scans keep the type of the first scan";
+    return;
+  }
+  Submit([predicate = *predicate, previous = result_](Scanner& scanner) {
+    return scanner.NextScan(*previous, {.op = NextScanOp::kMatch, .predicate = predicate});
+  });
+}
+
+template <typename Scan>
+void ScanWindow::Submit(Scan&& scan) {
+  status_ = "Scanning";
+  progress_ = jobs_.Submit([this, scan = std::forward<Scan>(scan)](ScanProgress& progress) {
+    const auto start = std::chrono::steady_clock::now();
+    scanner_->set_progress(&progress);
+    auto result = std::make_shared<const ScanResult>(scan(*scanner_));
+    scanner_->set_progress(nullptr);
+    handoff_.Publish({.result = std::move(result), .elapsed = std::chrono::steady_clock::now() - start});
+  });
+}
+
+void ScanWindow::TakeOutcome() {
+  if (!handoff_.Take(outcome_) || !pages_) {
+    return;
+  }
+  // A cancelled scan only holds the candidates of the shards it got to, so the previous result stays up.
+  if (outcome_->result->stats.cancelled) {
+    status_ = fmt::format("Cancelled after {:.3f} s", outcome_->elapsed.count());
+    return;
+  }
+  result_ = outcome_->result;
+  pages_->Reset(result_->candidates);
+  status_ = fmt::format("{} candidates in {:.3f} s", result_->candidates.count(), outcome_->elapsed.count());
+}
+
+void ScanWindow::DrawProgress() {
+  const ScanProgressSample sample = progress_->Sample();
+  const std::chrono::duration<double> remaining = sample.remaining();
+  const std::string overlay = fmt::format("{:.0f} / {:.0f} MiB, {} / {} shards, {:.1f} s left",
+                                          static_cast<double>(sample.bytes_done) / (1 << 20),
+                                          static_cast<double>(sample.bytes_total) / (1 << 20),
+                                          sample.shards_done,
+                                          sample.shards_total,
+                                          remaining.count());
+  ImGui::ProgressBar(static_cast<float>(sample.fraction()), ImVec2{-1, 0}, overlay.c_str());
+}
+
+}  // namespace maia::gui
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "maiascan/core/process.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/gui/job_queue.hpp"
+#include "maiascan/gui/result_handoff.hpp"
+#include "maiascan/gui/result_pages.hpp"
+#include "maiascan/scan/scan_progress.hpp"
+#include "maiascan/scan/scanner.hpp"
+
+namespace maia::gui {
+
+// The main window of the GUI: attaches to a target, runs first and next scans for a value and lists the candidates
+// with their current values. Scans run as jobs on a JobQueue, so the window keeps drawing, showing their progress and
+// offering to cancel them, while every core scans.
+class ScanWindow {
+ public:
+  ScanWindow() = default;
+  ScanWindow(const ScanWindow&) = delete;
+  ScanWindow& operator=(const ScanWindow&) = delete;
+
+  void Draw();
+
+ private:
+  // What a scan job hands back to the render thread.
+  struct ScanOutcome {
+    // Shared with the next scan job, which reads it while the table still shows it.
+    std::shared_ptr<const ScanResult> result;
+    std::chrono::duration<double> elapsed{};
+  };
+
+  void Attach();
+  // Parses the value field for the selected type, reporting failures in the status line.
+  std::optional<MatchPredicate> ParsePredicate();
+  void RunFirstScan();
+  void RunNextScan();
+  // Runs `scan` on the job queue and publishes its result.
+  template <typename Scan>
+  void Submit(Scan&& scan);
+  // Picks up the result of a finished job, if any.
+  void TakeOutcome();
+  void DrawProgress();
+
+  int pid_{};
+  ValueType type_{ValueType::kInt32};
+  std::array<char, 64> value_{};
+  std::string status_;
+
+  ThreadPool pool_;
+  // The scanner and pages refer to the process, so they are dropped before it is replaced. Jobs use the scanner, so
+  // the target can only change while no job runs.
+  std::optional<Process> process_;
+  std::unique_ptr<Scanner> scanner_;
+  std::unique_ptr<ResultPages> pages_;
+  std::shared_ptr<const ScanResult> result_;
+
+  ResultHandoff<ScanOutcome> handoff_;
+  std::optional<ScanOutcome> outcome_;
+  // Progress of the latest job.
+  std::shared_ptr<ScanProgress> progress_;
+  // Destroyed first, which cancels and joins the running job before anything it uses goes away.
+  JobQueue jobs_;
+};
+
+}  // namespace maia::gui
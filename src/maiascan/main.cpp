@@ -1,20 +1,50 @@
-#include <afx.h>
-
 #include <iostream>
+#include <string>
 
 #include <fmt/core.h>
 #include <cxxopts.hpp>
 
+#include "maiascan/cli/commands.hpp"
+
 int main(int argc, const char* const* argv) {
   cxxopts::Options opts("maiascan", "Memory scanner");
-  opts.add_options("help")("h,help", "Show help", cxxopts::value<bool>()->default_value("false"));
+  opts.positional_help("[scan|pointer|watch]");
+  opts.add_options("help")("h,help", "Show help", cxxopts::value<bool>()->default_value("false"))(
+      "command", "Command to run: scan, pointer or watch", cxxopts::value<std::string>()->default_value("scan"));
+  opts.parse_positional({"command"});
+  maia::cli::AddTargetOptions(opts);
+  maia::cli::AddScanOptions(opts);
+  maia::cli::AddPointerOptions(opts);
+  maia::cli::AddWatchOptions(opts);
 
   try {
     auto result = opts.parse(argc, argv);
-    // auto show_help = result["h"].as<bool>();
-    if (result.arguments().empty()) {
+    if (result.arguments().empty() || result["help"].as<bool>()) {
+      std::cout << opts.help();
+      return 0;
+    }
+    const auto& command = result["command"].as<std::string>();
+    if (command != "scan" && command != "pointer" && command != "watch") {
+      std::cout << fmt::format("Unknown command: {}\n", command);
       std::cout << opts.help();
+      return 1;
+    }
+    // Scans and pointer searches can also run on a dump, and a pointer search on a saved map alone.
+    const bool has_target = result.count("pid") != 0 || (command != "watch" && result.count("dump") != 0);
+    if (!has_target && (command != "pointer" || result.count("load-map") == 0)) {
+      std::cout << fmt::format("{} is required to {}\n",
+                               command == "watch" ? "--pid" : "--pid or --dump",
+                               command == "pointer" ? "search pointer paths" : command);
+      std::cout << opts.help();
+      return 1;
+    }
+    if (!maia::cli::OpenPerfLogOption(result)) {
+      return 1;
+    }
+    if (command == "watch") {
+      return maia::cli::RunWatchCommand(result);
     }
+    return command == "scan" ? maia::cli::RunScanCommand(result) : maia::cli::RunPointerCommand(result);
   } catch (cxxopts::exceptions::parsing& e) {
     std::cout << fmt::format("Failed to parse: {}\n", e.what());
     std::cout << opts.help();
@@ -0,0 +1,421 @@
+#include "maiascan/pointer/pointer_map.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "maiascan/core/bits.hpp"
+#include "maiascan/core/external_sort.hpp"
+#include "maiascan/core/perf.hpp"
+#include "maiascan/core/varint.hpp"
+
+namespace maia {
+
+namespace {
+
+// Pointer map files are laid out as
+//
+//   FileHeader | index: IndexEntry[block_count] | data: encoded blocks | manifest: JSON
+//
+// Every block holds kEntriesPerBlock entries (the last one possibly fewer). The value of its first entry lives in the
+// index and its address is stored as a varint; each further entry stores the varint delta of its value followed by the
+// zigzag varint delta of its address, both relative to the previous entry. Sorting by value keeps value deltas to a
+// byte or two, and addresses holding the same value are sorted too.
+constexpr std::array<char, 8> kFileMagic{'M', 'A', 'I', 'A', 'P', 'M', 'A', 'P'};
+constexpr uint32_t kFileVersion = 1;
+constexpr size_t kEntriesPerBlock = 128;
+
+struct FileHeader {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t pointer_size;
+  uint64_t entry_count;
+  uint64_t index_offset;
+  uint64_t block_count;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t manifest_offset;
+  uint64_t manifest_size;
+};
+
+bool IsInFile(uint64_t offset, uint64_t size, size_t file_size) {
+  return offset <= file_size && size <= file_size - offset;
+}
+
+nlohmann::json ToJson(const PointerMapInfo& info, std::optional<uint64_t> target) {
+  nlohmann::json modules = nlohmann::json::array();
+  for (const auto& module : info.modules) {
+    modules.push_back({{"name", module.name}, {"base", module.base}, {"size", module.size}});
+  }
+  return {{"pid", info.pid},
+          {"target", target ? nlohmann::json(*target) : nlohmann::json()},
+          {"modules", std::move(modules)}};
+}
+
+// Reads the manifest written by ToJson(). Fields of the wrong type fail the load instead of throwing.
+bool FromJson(const nlohmann::json& json, PointerMapInfo& info) {
+  if (!json.is_object() || !json.contains("pid") || !json["pid"].is_number_unsigned() || !json.contains("modules") ||
+      !json["modules"].is_array()) {
+    return false;
+  }
+  info.pid = json["pid"].get<uint32_t>();
+  if (json.contains("target") && json["target"].is_number_unsigned()) {
+    info.target = json["target"].get<uint64_t>();
+  }
+  for (const auto& module : json["modules"]) {
+    if (!module.is_object() || !module.contains("name") || !module["name"].is_string() || !module.contains("base") ||
+        !module["base"].is_number_unsigned() || !module.contains("size") || !module["size"].is_number_unsigned()) {
+      return false;
+    }
+    info.modules.push_back({.name = module["name"].get<std::string>(),
+                            .base = module["base"].get<uintptr_t>(),
+                            .size = module["size"].get<size_t>()});
+  }
+  return true;
+}
+
+// Answers whether a value points into one of the regions. Nearly every scanned word is tested, so two bitmaps over
+// 1 MiB buckets of the address space settle most values without touching the region list: buckets no region touches
+// reject, buckets entirely inside one region accept, and only buckets at region edges fall back to a binary search.
+class AddressFilter {
+ public:
+  static constexpr size_t kBucketShift = 20;
+
+  explicit AddressFilter(std::span<const MemoryRegion> regions) : regions_(regions) {
+    if (regions.empty()) {
+      return;
+    }
+    limit_ = regions.back().end();
+    const size_t bucket_count = ((limit_ - 1) >> kBucketShift) + 1;
+    touched_.assign(WordCount(bucket_count), 0);
+    covered_.assign(WordCount(bucket_count), 0);
+    for (const auto& region : regions) {
+      const uintptr_t first = region.base >> kBucketShift;
+      const uintptr_t last = (region.end() - 1) >> kBucketShift;
+      for (uintptr_t bucket = first; bucket <= last; ++bucket) {
+        SetBit(touched_.data(), bucket);
+        if ((bucket << kBucketShift) >= region.base && ((bucket + 1) << kBucketShift) <= region.end()) {
+          SetBit(covered_.data(), bucket);
+        }
+      }
+    }
+  }
+
+  bool Contains(uint64_t value) const {
+    if (value >= limit_) {
+      return false;
+    }
+    const size_t bucket = value >> kBucketShift;
+    if (!TestBit(touched_.data(), bucket)) {
+      return false;
+    }
+    if (TestBit(covered_.data(), bucket)) {
+      return true;
+    }
+    const auto next = std::upper_bound(
+        regions_.begin(), regions_.end(), value, [](uint64_t v, const MemoryRegion& r) { return v < r.base; });
+    return next != regions_.begin() && value < std::prev(next)->end();
+  }
+
+ private:
+  std::span<const MemoryRegion> regions_;
+  uint64_t limit_{};
+  std::vector<uint64_t> touched_;
+  std::vector<uint64_t> covered_;
+};
+
+template <typename T>
+void CollectPointers(const AddressFilter& filter,
+                     uintptr_t base,
+                     std::span<const std::byte> data,
+                     size_t size,
+                     std::vector<PointerEntry>& out) {
+  const size_t end = std::min(size, data.size() < sizeof(T) ? 0 : data.size() - sizeof(T) + 1);
+  for (size_t offset = 0; offset < end; offset += sizeof(T)) {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    if (filter.Contains(value)) {
+      out.push_back({.value = value, .address = base + offset});
+    }
+  }
+}
+
+}  // namespace
+
+// Streams entries in ascending order into a map file. Encoded blocks go to the file as they fill; the index, which takes
+// an eighth of a byte per entry, stays in memory until Finish() writes it in front of the data with the header.
+class PointerMap::Writer {
+ public:
+  Writer(const std::filesystem::path& path, uint64_t entry_count)
+      : out_(path, std::ios::binary | std::ios::trunc),
+        entry_count_(entry_count),
+        block_count_((entry_count + kEntriesPerBlock - 1) / kEntriesPerBlock) {
+    index_.reserve(block_count_);
+    out_.seekp(static_cast<std::streamoff>(data_offset()));
+  }
+
+  void Add(std::span<const PointerEntry> entries) {
+    for (const auto& entry : entries) {
+      if (encoded_++ % kEntriesPerBlock == 0) {
+        index_.push_back({.first_value = entry.value, .data_offset = data_size_ + buffer_.size()});
+        AppendVarint(buffer_, entry.address);
+      } else {
+        AppendVarint(buffer_, entry.value - previous_.value);
+        AppendVarint(buffer_, ZigZagEncode(static_cast<int64_t>(entry.address - previous_.address)));
+      }
+      previous_ = entry;
+    }
+    if (buffer_.size() >= kFlushSize) {
+      Flush();
+    }
+  }
+
+  // Completes the file. Returns false if it could not be written or did not get the announced number of entries.
+  bool Finish(const PointerMapInfo& info, std::optional<uint64_t> target) {
+    Flush();
+    const std::string manifest = ToJson(info, target).dump();
+    const FileHeader header{.magic = kFileMagic,
+                            .version = kFileVersion,
+                            .pointer_size = static_cast<uint32_t>(info.pointer_size),
+                            .entry_count = entry_count_,
+                            .index_offset = sizeof(FileHeader),
+                            .block_count = block_count_,
+                            .data_offset = data_offset(),
+                            .data_size = data_size_,
+                            .manifest_offset = data_offset() + data_size_,
+                            .manifest_size = manifest.size()};
+    out_.write(manifest.data(), static_cast<std::streamsize>(manifest.size()));
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out_.write(reinterpret_cast<const char*>(index_.data()),
+               static_cast<std::streamsize>(index_.size() * sizeof(IndexEntry)));
+    out_.close();
+    return !out_.fail() && encoded_ == entry_count_;
+  }
+
+ private:
+  static constexpr size_t kFlushSize = size_t{1} << 20;
+
+  uint64_t data_offset() const { return sizeof(FileHeader) + block_count_ * sizeof(IndexEntry); }
+
+  void Flush() {
+    out_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    data_size_ += buffer_.size();
+    buffer_.clear();
+  }
+
+  std::ofstream out_;
+  uint64_t entry_count_;
+  uint64_t block_count_;
+  uint64_t encoded_{};
+  uint64_t data_size_{};
+  PointerEntry previous_;
+  std::vector<IndexEntry> index_;
+  std::vector<uint8_t> buffer_;
+};
+
+PointerMap PointerMap::Build(MemoryReader& reader,
+                             ThreadPool& pool,
+                             const PointerMapOptions& options,
+                             RegionCache* region_cache) {
+  PerfPhase phase("pointer_map", &pool);
+  const auto queried = region_cache != nullptr ? region_cache->Refresh() : reader.process().QueryRegions();
+  reader.PrepareRegions(queried);
+  const auto regions = CoalesceRegions(queried);
+  const auto shards = SplitIntoShards(regions, options.shard_size, options.pointer_size);
+  const AddressFilter filter(regions);
+  const ReadStats reads_at_start = reader.stats();
+
+  // Shards collect into a reused per-worker buffer and hand what they found to the sorter, which keeps it in
+  // per-worker buffers and, past the memory limit, spills it in sorted runs while the remaining shards are scanned.
+  const bool can_spill = options.memory_limit != 0 && !options.spill_dir.empty();
+  ExternalSorter<PointerEntry> sorter(pool.size(), options.spill_dir, can_spill ? options.memory_limit : 0);
+  std::vector<std::vector<PointerEntry>> collected(pool.size());
+  pool.ParallelFor(shards.size(), [&](size_t index, size_t worker) {
+    const Shard& shard = shards[index];
+    const auto data = reader.Read(worker, shard.base, shard.read_size);
+    ReadAheadNextShard(reader, pool, shards, worker);
+    auto& entries = collected[worker];
+    entries.clear();
+    {
+      ScopedPerfTimer timer(PerfCounter::kKernelNs);
+      if (options.pointer_size == 4) {
+        CollectPointers<uint32_t>(filter, shard.base, data, shard.size, entries);
+      } else {
+        CollectPointers<uint64_t>(filter, shard.base, data, shard.size, entries);
+      }
+    }
+    sorter.Push(worker, entries);
+  });
+  reader.DropReadAhead();
+  collected = {};
+
+  PointerMapInfo info{.pid = reader.process().pid(),
+                      .pointer_size = options.pointer_size,
+                      .modules = reader.process().QueryModules()};
+  const ReadStats reads = reader.stats();
+  const PointerMapStats stats{.regions = regions.size(),
+                              .bytes_scanned = reads.bytes - reads_at_start.bytes,
+                              .read_calls = reads.calls - reads_at_start.calls,
+                              .spilled_runs = sorter.run_count(),
+                              .spilled_bytes = sorter.spilled_bytes(),
+                              .spill_failed = sorter.failed()};
+
+  std::optional<PointerMap> map;
+  {
+    ScopedPerfTimer timer(PerfCounter::kMergeNs);
+    if (!sorter.spilled()) {
+      map.emplace();
+      map->entries_ = sorter.TakeSorted(pool);
+    } else {
+      // The runs are merged straight into a map file, which is then mapped like a loaded one and deleted with it.
+      const auto path = TemporaryPath(options.spill_dir, "maiascan-pointer-map");
+      Writer writer(path, sorter.size());
+      sorter.Merge(pool, [&](std::span<const PointerEntry> entries) { writer.Add(entries); });
+      if (writer.Finish(info, {})) {
+        map = FromFile(MappedFile::OpenTemporary(path));
+      }
+      if (!map) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        // Without a map file the merge has to land in memory after all.
+        map.emplace();
+        map->entries_.reserve(sorter.size());
+        sorter.Merge(pool, [&](std::span<const PointerEntry> entries) {
+          map->entries_.insert(map->entries_.end(), entries.begin(), entries.end());
+        });
+      }
+    }
+  }
+
+  if (!map->file_) {
+    map->entry_count_ = map->entries_.size();
+  }
+  map->info_ = std::move(info);
+  map->stats_ = stats;
+  phase.Set("pointers", map->entry_count_);
+  if (stats.spilled_runs != 0) {
+    phase.Set("spilled_runs", stats.spilled_runs);
+  }
+  if (stats.spill_failed) {
+    phase.Set("spill_failed", 1);
+  }
+  return std::move(*map);
+}
+
+std::optional<PointerMap> PointerMap::Load(const std::filesystem::path& path) {
+  return FromFile(MappedFile::Open(path));
+}
+
+std::optional<PointerMap> PointerMap::FromFile(std::unique_ptr<MappedFile> file) {
+  if (!file) {
+    return std::nullopt;
+  }
+  const auto bytes = file->data();
+  FileHeader header;
+  if (bytes.size() < sizeof(header)) {
+    return std::nullopt;
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != kFileMagic || header.version != kFileVersion ||
+      (header.pointer_size != 4 && header.pointer_size != 8) ||
+      header.block_count != (header.entry_count + kEntriesPerBlock - 1) / kEntriesPerBlock ||
+      header.index_offset % alignof(IndexEntry) != 0 || header.block_count > bytes.size() / sizeof(IndexEntry) ||
+      !IsInFile(header.index_offset, header.block_count * sizeof(IndexEntry), bytes.size()) ||
+      !IsInFile(header.data_offset, header.data_size, bytes.size()) ||
+      !IsInFile(header.manifest_offset, header.manifest_size, bytes.size())) {
+    return std::nullopt;
+  }
+
+  PointerMap map;
+  map.index_ = {reinterpret_cast<const IndexEntry*>(bytes.data() + header.index_offset), header.block_count};
+  map.data_ = {reinterpret_cast<const uint8_t*>(bytes.data() + header.data_offset), header.data_size};
+  for (size_t i = 0; i < map.index_.size(); ++i) {
+    const IndexEntry& entry = map.index_[i];
+    if (entry.data_offset >= map.data_.size() ||
+        (i > 0 && (entry.data_offset <= map.index_[i - 1].data_offset ||
+                   entry.first_value < map.index_[i - 1].first_value))) {
+      return std::nullopt;
+    }
+  }
+
+  const auto* manifest = reinterpret_cast<const char*>(bytes.data() + header.manifest_offset);
+  const auto json = nlohmann::json::parse(manifest, manifest + header.manifest_size, nullptr, false);
+  if (json.is_discarded() || !FromJson(json, map.info_)) {
+    return std::nullopt;
+  }
+  map.info_.pointer_size = header.pointer_size;
+  map.entry_count_ = header.entry_count;
+  map.file_ = std::move(file);
+  return map;
+}
+
+bool PointerMap::Save(const std::filesystem::path& path, std::optional<uint64_t> target) const {
+  Writer writer(path, entry_count_);
+  if (file_) {
+    // Re-encode block by block so that a loaded map never has to be decoded as a whole.
+    std::vector<PointerEntry> scratch;
+    for (size_t block = 0; block < index_.size(); ++block) {
+      scratch.clear();
+      DecodeBlock(block, scratch);
+      writer.Add(scratch);
+    }
+  } else {
+    writer.Add(entries_);
+  }
+  return writer.Finish(info_, target);
+}
+
+size_t PointerMap::memory_usage() const {
+  return file_ ? file_->data().size() : entries_.capacity() * sizeof(PointerEntry);
+}
+
+void PointerMap::DecodeBlock(size_t block, std::vector<PointerEntry>& out) const {
+  const uint8_t* data = data_.data() + index_[block].data_offset;
+  const uint8_t* end = data_.data() + (block + 1 < index_.size() ? index_[block + 1].data_offset : data_.size());
+  const size_t count = std::min(kEntriesPerBlock, entry_count_ - block * kEntriesPerBlock);
+  PointerEntry entry{.value = index_[block].first_value};
+  if (!ReadVarint(data, end, entry.address)) {
+    return;
+  }
+  out.push_back(entry);
+  for (size_t i = 1; i < count; ++i) {
+    uint64_t value_delta;
+    uint64_t address_delta;
+    if (!ReadVarint(data, end, value_delta) || !ReadVarint(data, end, address_delta)) {
+      return;
+    }
+    entry.value += value_delta;
+    entry.address += static_cast<uint64_t>(ZigZagDecode(address_delta));
+    out.push_back(entry);
+  }
+}
+
+std::span<const PointerEntry> PointerMap::FindValues(uint64_t lower,
+                                                     uint64_t upper,
+                                                     std::vector<PointerEntry>& scratch) const {
+  const auto by_value = [](const PointerEntry& e, uint64_t v) { return e.value < v; };
+  const auto by_upper = [](uint64_t v, const PointerEntry& e) { return v < e.value; };
+  if (!file_) {
+    const auto first = std::lower_bound(entries_.begin(), entries_.end(), lower, by_value);
+    const auto last = std::upper_bound(first, entries_.end(), upper, by_upper);
+    return {first, last};
+  }
+
+  // Entries equal to `lower` may start in the block before the first one whose first value reaches it.
+  scratch.clear();
+  const auto next = std::lower_bound(
+      index_.begin(), index_.end(), lower, [](const IndexEntry& e, uint64_t v) { return e.first_value < v; });
+  size_t block = next == index_.begin() ? 0 : static_cast<size_t>(next - index_.begin()) - 1;
+  for (; block < index_.size() && index_[block].first_value <= upper; ++block) {
+    DecodeBlock(block, scratch);
+  }
+  const auto first = std::lower_bound(scratch.begin(), scratch.end(), lower, by_value);
+  const auto last = std::upper_bound(first, scratch.end(), upper, by_upper);
+  return {first, last};
+}
+
+}  // namespace maia
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/mapped_file.hpp"
+#include "maiascan/core/memory_reader.hpp"
+#include "maiascan/core/region_cache.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/scan/scanner.hpp"
+
+namespace maia {
+
+// A pointer-sized value found in target memory together with the address holding it.
+struct PointerEntry {
+  uint64_t value{};
+  uint64_t address{};
+
+  friend bool operator<(const PointerEntry& a, const PointerEntry& b) {
+    return a.value != b.value ? a.value < b.value : a.address < b.address;
+  }
+};
+
+struct PointerMapOptions {
+  // Width of a pointer in the target: 8 for 64-bit processes, 4 for 32-bit ones. Pointers are expected at addresses
+  // aligned to their width.
+  size_t pointer_size{8};
+  size_t shard_size{kDefaultShardSize};
+  // Bytes the collected entries may take up in memory. Beyond that they are sorted in runs written to `spill_dir` and
+  // merged into a temporary map file, which the built map then reads from like a loaded one. Zero, or an empty
+  // `spill_dir`, keeps everything in memory.
+  size_t memory_limit{};
+  std::filesystem::path spill_dir;
+};
+
+struct PointerMapStats {
+  size_t regions{};
+  uint64_t bytes_scanned{};
+  uint64_t read_calls{};
+  // Sorted runs written because the entries exceeded PointerMapOptions::memory_limit.
+  size_t spilled_runs{};
+  uint64_t spilled_bytes{};
+  // Set when a run could not be written to the spill file; the entries it held stayed in memory past the limit.
+  bool spill_failed{};
+};
+
+// Where a map came from. Saved alongside the entries so that a loaded map can be searched without the process.
+struct PointerMapInfo {
+  uint32_t pid{};
+  size_t pointer_size{8};
+  // Modules of the target when the map was built, sorted by base address. Static addresses are only meaningful
+  // relative to these, since module bases move between runs.
+  std::vector<Module> modules;
+  // Address the map was searched for when it was saved, if any.
+  std::optional<uint64_t> target;
+};
+
+// Reverse pointer index of a target: every aligned pointer-sized value that points into readable memory, sorted by the
+// value it holds. Answers "which addresses point into [lower, upper]" with a binary search, which is the only query
+// a pointer-path search needs.
+//
+// A map is either built in memory from a live process or loaded from a file written by Save(). Files hold the entries
+// in blocks of delta-encoded varints behind an index of the first value of every block; loading maps the file and
+// decodes only the blocks that queries touch. Builds that exceed their memory limit produce such a file too and read
+// from it the same way.
+class PointerMap {
+ public:
+  PointerMap() = default;
+
+  // Reads every readable region of the target once, in parallel, and indexes the values that look like pointers into
+  // one of those regions. Regions come from `region_cache` when given, which avoids a full walk when maps are rebuilt.
+  static PointerMap Build(MemoryReader& reader,
+                          ThreadPool& pool,
+                          const PointerMapOptions& options = {},
+                          RegionCache* region_cache = nullptr);
+
+  // Maps a file written by Save(). Fails on missing, truncated or foreign files.
+  static std::optional<PointerMap> Load(const std::filesystem::path& path);
+
+  // Writes the map together with its info and `target`. Returns false if the file could not be written.
+  bool Save(const std::filesystem::path& path, std::optional<uint64_t> target = {}) const;
+
+  const PointerMapInfo& info() const { return info_; }
+  const PointerMapStats& stats() const { return stats_; }
+  size_t size() const { return entry_count_; }
+  // Heap held by the entries, or the size of the mapped file for loaded and spilled maps.
+  size_t memory_usage() const;
+
+  // Entries whose value lies in [lower, upper], in ascending value order. Loaded maps decode them into `scratch`, so
+  // the result is only valid until the next call with the same scratch vector.
+  std::span<const PointerEntry> FindValues(uint64_t lower, uint64_t upper, std::vector<PointerEntry>& scratch) const;
+
+ private:
+  struct IndexEntry {
+    uint64_t first_value;
+    // Offset of the encoded block from the start of the data section.
+    uint64_t data_offset;
+  };
+
+  class Writer;
+
+  // Validates the map file behind `file` and reads its entries from it.
+  static std::optional<PointerMap> FromFile(std::unique_ptr<MappedFile> file);
+
+  // Appends the entries of encoded block `block` to `out`.
+  void DecodeBlock(size_t block, std::vector<PointerEntry>& out) const;
+
+  std::vector<PointerEntry> entries_;
+  size_t entry_count_{};
+  std::unique_ptr<MappedFile> file_;
+  std::span<const IndexEntry> index_;
+  std::span<const uint8_t> data_;
+  PointerMapInfo info_;
+  PointerMapStats stats_;
+};
+
+}  // namespace maia
@@ -0,0 +1,231 @@
+#include "maiascan/pointer/pointer_scanner.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+#include <fmt/core.h>
+
+#include "maiascan/core/perf.hpp"
+
+namespace maia {
+
+namespace {
+
+// Frontier nodes handed to a worker at a time.
+constexpr size_t kNodesPerTask = 64;
+
+// Paths checked by a worker at a time in Filter().
+constexpr size_t kPathsPerTask = 256;
+
+// Upper bound on the addresses Resolves() tracks per offset. Exact offsets rarely fan out, but a value stored at
+// thousands of addresses would otherwise make a single path arbitrarily expensive.
+constexpr size_t kMaxResolveWidth = 4096;
+
+struct Node {
+  uint64_t address;
+  // Index of the node in the previous level whose address this one points near.
+  uint32_t parent;
+  // Distance from the value stored at `address` to the address of the parent.
+  uint32_t offset;
+};
+
+bool ByAddressThenOffset(const Node& a, const Node& b) {
+  return a.address != b.address ? a.address < b.address : a.offset < b.offset;
+}
+
+}  // namespace
+
+PointerScanner::PointerScanner(const PointerMap& map,
+                               std::span<const Module> modules,
+                               ThreadPool& pool,
+                               ChunkAllocator* allocator)
+    : map_(map), modules_(modules), pool_(pool), arena_(pool.size(), allocator) {}
+
+size_t PointerScanner::FindModule(uint64_t address) const {
+  const auto next = std::upper_bound(
+      modules_.begin(), modules_.end(), address, [](uint64_t a, const Module& m) { return a < m.base; });
+  if (next == modules_.begin() || address >= std::prev(next)->end()) {
+    return modules_.size();
+  }
+  return static_cast<size_t>(std::prev(next) - modules_.begin());
+}
+
+PointerScanResult PointerScanner::Scan(uintptr_t target, const PointerScanOptions& options) {
+  PerfPhase phase("pointer_scan", &pool_);
+  PointerScanResult result;
+  // Levels live in the arena until the next search. Each is sorted by address, which is what the visited check
+  // searches, and nodes refer to their parent by its index in the previous level.
+  arena_.Reset();
+  std::vector<std::span<const Node>> levels;
+  const auto root = arena_.AllocateArray<Node>(0, 1);
+  if (root.empty()) {
+    return result;
+  }
+  root[0] = {.address = target, .parent = 0, .offset = 0};
+  levels.push_back(root);
+  const auto visited = [&](uint64_t address) {
+    return std::any_of(levels.begin(), levels.end(), [&](std::span<const Node> level) {
+      const auto it = std::lower_bound(
+          level.begin(), level.end(), address, [](const Node& node, uint64_t a) { return node.address < a; });
+      return it != level.end() && it->address == address;
+    });
+  };
+
+  std::vector<std::vector<Node>> children(pool_.size());
+  std::vector<std::vector<Node>> statics(pool_.size());
+  std::vector<std::vector<PointerEntry>> scratch(pool_.size());
+  std::vector<Node> found;
+  std::vector<Node> next;
+  for (size_t depth = 1; depth <= options.max_depth && !levels.back().empty(); ++depth) {
+    const std::span<const Node> level = levels.back();
+    const bool last_level = depth == options.max_depth;
+    const size_t task_count = (level.size() + kNodesPerTask - 1) / kNodesPerTask;
+    pool_.ParallelFor(task_count, [&](size_t task, size_t worker) {
+      const size_t last = std::min((task + 1) * kNodesPerTask, level.size());
+      for (size_t i = task * kNodesPerTask; i < last; ++i) {
+        const uint64_t address = level[i].address;
+        const uint64_t lower = address - std::min<uint64_t>(address, options.max_offset);
+        for (const auto& entry : map_.FindValues(lower, address, scratch[worker])) {
+          const Node child{.address = entry.address,
+                           .parent = static_cast<uint32_t>(i),
+                           .offset = static_cast<uint32_t>(address - entry.value)};
+          if (FindModule(entry.address) != modules_.size()) {
+            statics[worker].push_back(child);
+          } else if (!last_level) {
+            children[worker].push_back(child);
+          }
+        }
+      }
+    });
+    result.stats.levels = depth;
+
+    // Every static chain is a result of its own, in a deterministic order.
+    found.clear();
+    for (auto& worker_statics : statics) {
+      found.insert(found.end(), worker_statics.begin(), worker_statics.end());
+      worker_statics.clear();
+    }
+    std::sort(found.begin(), found.end(), [](const Node& a, const Node& b) {
+      return std::tie(a.address, a.offset, a.parent) < std::tie(b.address, b.offset, b.parent);
+    });
+    for (const Node& node : found) {
+      if (result.paths.size() == options.max_results) {
+        break;
+      }
+      const size_t module = FindModule(node.address);
+      PointerPath path{
+          .module = module, .module_offset = node.address - modules_[module].base, .offsets = {node.offset}};
+      uint32_t parent = node.parent;
+      for (size_t i = levels.size() - 1; i > 0; --i) {
+        path.offsets.push_back(levels[i][parent].offset);
+        parent = levels[i][parent].parent;
+      }
+      result.paths.push_back(std::move(path));
+    }
+    if (result.paths.size() == options.max_results) {
+      break;
+    }
+
+    // The next level keeps each new address once, through the smallest offset that reached it.
+    next.clear();
+    for (auto& worker_children : children) {
+      next.insert(next.end(), worker_children.begin(), worker_children.end());
+      worker_children.clear();
+    }
+    std::sort(next.begin(), next.end(), ByAddressThenOffset);
+    const size_t limit = std::min<size_t>(options.max_level_nodes, std::numeric_limits<uint32_t>::max());
+    size_t kept = 0;
+    for (size_t i = 0; i < next.size(); ++i) {
+      if ((i > 0 && next[i].address == next[i - 1].address) || visited(next[i].address)) {
+        continue;
+      }
+      if (kept == limit) {
+        result.stats.truncated = true;
+        break;
+      }
+      next[kept++] = next[i];
+    }
+    const auto nodes = arena_.AllocateArray<Node>(0, kept);
+    if (nodes.size() < kept) {
+      result.stats.truncated = true;
+      break;
+    }
+    std::copy(next.begin(), next.begin() + static_cast<ptrdiff_t>(kept), nodes.begin());
+    levels.push_back(nodes);
+    result.stats.nodes += kept;
+  }
+  phase.Set("paths", result.paths.size());
+  phase.Set("nodes", result.stats.nodes);
+  return result;
+}
+
+std::vector<PointerPath> PointerScanner::Filter(std::span<const PointerPath> paths,
+                                                std::span<const Module> path_modules,
+                                                uintptr_t target) const {
+  std::vector<uint8_t> keep(paths.size());
+  std::vector<std::vector<PointerEntry>> scratch(pool_.size());
+  pool_.ParallelFor((paths.size() + kPathsPerTask - 1) / kPathsPerTask, [&](size_t task, size_t worker) {
+    const size_t last = std::min(paths.size(), (task + 1) * kPathsPerTask);
+    for (size_t i = task * kPathsPerTask; i < last; ++i) {
+      const auto& name = path_modules[paths[i].module].name;
+      const auto module =
+          std::find_if(modules_.begin(), modules_.end(), [&](const Module& m) { return m.name == name; });
+      keep[i] = module != modules_.end() &&
+                Resolves(paths[i], module->base + paths[i].module_offset, target, scratch[worker]);
+    }
+  });
+  std::vector<PointerPath> kept;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (keep[i]) {
+      kept.push_back(paths[i]);
+    }
+  }
+  return kept;
+}
+
+bool PointerScanner::Resolves(const PointerPath& path,
+                              uint64_t base,
+                              uintptr_t target,
+                              std::vector<PointerEntry>& scratch) const {
+  // values[k] holds the candidates for the pointer read before adding offsets[k]; the last one is fixed by the target.
+  const auto& offsets = path.offsets;
+  if (offsets.empty() || target < offsets.back()) {
+    return false;
+  }
+  std::vector<uint64_t> values{target - offsets.back()};
+  for (size_t k = offsets.size() - 1; k-- > 0;) {
+    std::vector<uint64_t> previous;
+    for (const uint64_t value : values) {
+      for (const auto& entry : map_.FindValues(value, value, scratch)) {
+        if (entry.address >= offsets[k] && previous.size() < kMaxResolveWidth) {
+          previous.push_back(entry.address - offsets[k]);
+        }
+      }
+    }
+    std::sort(previous.begin(), previous.end());
+    previous.erase(std::unique(previous.begin(), previous.end()), previous.end());
+    values = std::move(previous);
+    if (values.empty()) {
+      return false;
+    }
+  }
+  for (const uint64_t value : values) {
+    for (const auto& entry : map_.FindValues(value, value, scratch)) {
+      if (entry.address == base) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+std::string FormatPointerPath(const PointerPath& path, std::span<const Module> modules) {
+  std::string text = fmt::format("\"{}\"+{:#x}", modules[path.module].name, path.module_offset);
+  for (const uint32_t offset : path.offsets) {
+    text += fmt::format(" -> {:#x}", offset);
+  }
+  return text;
+}
+
+}  // namespace maia
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "maiascan/core/arena.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/pointer/pointer_map.hpp"
+
+namespace maia {
+
+struct PointerScanOptions {
+  // Maximum number of dereferences between a module and the target.
+  size_t max_depth{4};
+  // Largest offset added to a pointer at any level; the pointer itself must not lie above the address it leads to.
+  uint32_t max_offset{0x1000};
+  // The search stops once this many paths were found.
+  size_t max_results{10000};
+  // New addresses kept per level. Bounds the memory and time of deep searches through densely linked heaps; levels
+  // that hit it are reported through PointerScanStats::truncated.
+  size_t max_level_nodes{size_t{1} << 22};
+};
+
+// A chain that reaches the target from a static address: read the pointer at modules[module].base + module_offset,
+// then for every offset but the last add it and dereference again. Adding the last offset yields the target.
+struct PointerPath {
+  size_t module{};
+  uint64_t module_offset{};
+  std::vector<uint32_t> offsets;
+};
+
+struct PointerScanStats {
+  size_t levels{};
+  // Distinct non-static addresses visited on the way to the target.
+  size_t nodes{};
+  bool truncated{};
+};
+
+struct PointerScanResult {
+  std::vector<PointerPath> paths;
+  PointerScanStats stats;
+};
+
+// Searches a PointerMap backwards from a target address: level by level, every address reached so far is looked up as
+// a pointer value minus up to max_offset, and the addresses holding those pointers form the next level. Addresses
+// inside a module image end a path. Each level is expanded in parallel and every address is expanded at most once,
+// through the shortest chain that reached it.
+class PointerScanner {
+ public:
+  // `modules` must be sorted by base address, as returned by Process::QueryModules(). The nodes of a search are kept
+  // in chunks from `allocator`, the OS when null.
+  PointerScanner(const PointerMap& map,
+                 std::span<const Module> modules,
+                 ThreadPool& pool,
+                 ChunkAllocator* allocator = nullptr);
+
+  // Not reentrant: the nodes of a search are kept in an arena that the next search reuses.
+  PointerScanResult Scan(uintptr_t target, const PointerScanOptions& options = {});
+
+  // Keeps the paths that also lead from their module to `target` in this scanner's map, typically one taken after the
+  // target restarted. `path_modules` are the modules the paths refer to; they are matched to this scanner's modules by
+  // name, so the kept paths still refer to `path_modules`. Only exact offsets are followed, so this is much cheaper
+  // than a new search.
+  std::vector<PointerPath> Filter(std::span<const PointerPath> paths,
+                                  std::span<const Module> path_modules,
+                                  uintptr_t target) const;
+
+ private:
+  // Index of the module containing `address`, or modules_.size() when it is not static.
+  size_t FindModule(uint64_t address) const;
+
+  // Whether `path` leads from `base` to `target`, walking its offsets backwards through the map.
+  bool Resolves(const PointerPath& path, uint64_t base, uintptr_t target, std::vector<PointerEntry>& scratch) const;
+
+  const PointerMap& map_;
+  std::span<const Module> modules_;
+  ThreadPool& pool_;
+  Arena arena_;
+};
+
+// Formats `path` as `"module"+0x1234 -> 0x10 -> 0x8`.
+std::string FormatPointerPath(const PointerPath& path, std::span<const Module> modules);
+
+}  // namespace maia
@@ -0,0 +1,154 @@
+#include "maiascan/scan/candidates.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "maiascan/core/varint.hpp"
+
+namespace maia {
+
+CandidateBlock CandidateBlock::All(uintptr_t base, uint32_t slot_count) {
+  CandidateBlock block;
+  block.base_ = base;
+  block.slot_count_ = slot_count;
+  block.count_ = slot_count;
+  block.encoding_ = Encoding::kAll;
+  return block;
+}
+
+CandidateBlock CandidateBlock::FromBits(
+    uintptr_t base, uint32_t slot_count, const uint64_t* bits, Arena& arena, size_t worker) {
+  CandidateBlock block;
+  block.base_ = base;
+  block.slot_count_ = slot_count;
+
+  const size_t word_count = WordCount(slot_count);
+  const uint64_t tail_mask = slot_count % 64 == 0 ? ~uint64_t{0} : (uint64_t{1} << (slot_count % 64)) - 1;
+  size_t count = 0;
+  for (size_t i = 0; i < word_count; ++i) {
+    count += static_cast<size_t>(std::popcount(i + 1 == word_count ? bits[i] & tail_mask : bits[i]));
+  }
+  block.count_ = static_cast<uint32_t>(count);
+  if (count == slot_count) {
+    block.encoding_ = Encoding::kAll;
+    return block;
+  }
+  if (count == 0) {
+    block.encoding_ = Encoding::kDeltas;
+    return block;
+  }
+
+  // Try the delta list first, in storage sized for the bitmap plus room for one more varint, and give up as soon as it
+  // grows past the size of the bitmap. Whichever encoding wins keeps the same allocation.
+  const size_t bitmap_bytes = word_count * sizeof(uint64_t);
+  const auto words = arena.AllocateArray<uint64_t>(worker, word_count + WordCount(kMaxVarintSize * 8));
+  if (words.empty()) {
+    return All(base, 0);
+  }
+  auto* deltas = reinterpret_cast<uint8_t*>(words.data());
+  size_t size = 0;
+  bool first = true;
+  size_t previous = 0;
+  const bool fits = ForEachSetBit(bits, slot_count, [&](size_t slot) {
+    size += WriteVarint(deltas + size, first ? slot : slot - previous - 1);
+    first = false;
+    previous = slot;
+    return size < bitmap_bytes;
+  });
+  if (fits) {
+    arena.Shrink(worker, std::as_writable_bytes(words), size);
+    block.encoding_ = Encoding::kDeltas;
+    block.deltas_ = {deltas, size};
+    return block;
+  }
+
+  std::copy(bits, bits + word_count, words.begin());
+  if (slot_count % 64 != 0) {
+    words[word_count - 1] &= tail_mask;
+  }
+  block.encoding_ = Encoding::kBitmap;
+  block.bits_ = arena.ShrinkArray(worker, words, word_count);
+  return block;
+}
+
+CandidateBlock CandidateBlock::FromEncoded(uintptr_t base,
+                                           uint32_t slot_count,
+                                           uint32_t count,
+                                           Encoding encoding,
+                                           std::span<const uint8_t> encoded,
+                                           Arena& arena,
+                                           size_t worker) {
+  if (encoding == Encoding::kAll) {
+    return All(base, slot_count);
+  }
+  CandidateBlock block;
+  block.base_ = base;
+  block.slot_count_ = slot_count;
+  block.count_ = count;
+  block.encoding_ = encoding;
+  if (encoded.empty()) {
+    return block;
+  }
+  const auto storage = arena.Allocate(worker, encoded.size(), alignof(uint64_t));
+  if (storage.empty()) {
+    return All(base, 0);
+  }
+  std::memcpy(storage.data(), encoded.data(), encoded.size());
+  if (encoding == Encoding::kBitmap) {
+    block.bits_ = {reinterpret_cast<const uint64_t*>(storage.data()), encoded.size() / sizeof(uint64_t)};
+  } else {
+    block.deltas_ = {reinterpret_cast<const uint8_t*>(storage.data()), encoded.size()};
+  }
+  return block;
+}
+
+size_t CandidateSet::count() const {
+  size_t total = 0;
+  for (const auto& block : blocks) {
+    total += block.count();
+  }
+  return total;
+}
+
+size_t CandidateSet::memory_usage() const {
+  size_t total = blocks.capacity() * sizeof(CandidateBlock);
+  for (const auto& block : blocks) {
+    total += block.memory_usage();
+  }
+  return total;
+}
+
+CandidatePager::CandidatePager(const CandidateSet& candidates) : stride_(candidates.stride) {
+  blocks_.reserve(candidates.blocks.size());
+  offsets_.reserve(candidates.blocks.size() + 1);
+  for (const auto& block : candidates.blocks) {
+    Append(block);
+  }
+}
+
+void CandidatePager::Append(const CandidateBlock& block) {
+  if (block.empty()) {
+    return;
+  }
+  blocks_.push_back(block);
+  offsets_.push_back(offsets_.back() + block.count());
+}
+
+size_t CandidatePager::Read(size_t first, std::span<uintptr_t> out) const {
+  size_t written = 0;
+  auto next = std::upper_bound(offsets_.begin(), offsets_.end(), first);
+  for (size_t i = static_cast<size_t>(next - offsets_.begin()) - 1; i < blocks_.size() && written < out.size(); ++i) {
+    const CandidateBlock& block = blocks_[i];
+    size_t rank = offsets_[i];
+    block.ForEachSlot([&](size_t slot) {
+      if (rank++ >= first) {
+        out[written++] = block.base() + slot * stride_;
+      }
+      return written < out.size();
+    });
+  }
+  return written;
+}
+
+}  // namespace maia
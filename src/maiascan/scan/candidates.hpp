@@ -0,0 +1,193 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "maiascan/core/arena.hpp"
+#include "maiascan/core/bits.hpp"
+#include "maiascan/scan/value.hpp"
+
+namespace maia {
+
+// Candidates of one scanned block of memory (a region, or a shard-sized piece of a large region), stored as slot
+// indices relative to `base()`: slot `i` is the address `base() + i * stride` of the owning CandidateSet.
+//
+// The encoding adapts to the density of the block: a block where every slot is still a candidate needs no storage at
+// all, dense blocks use one bit per slot and sparse blocks keep the gaps between consecutive slots as LEB128 varints,
+// which is usually one or two bytes per candidate. Storage lives in the arena of the scan that produced the block, so
+// blocks are cheap to copy and only valid while that arena is (see CandidateSet::arena).
+class CandidateBlock {
+ public:
+  enum class Encoding : uint8_t { kAll, kBitmap, kDeltas };
+
+  CandidateBlock() = default;
+
+  static CandidateBlock All(uintptr_t base, uint32_t slot_count);
+
+  // Builds a block from one match bit per slot, choosing whichever of the bitmap and the delta list is smaller, and
+  // stores it in the chunks of `worker` in `arena`. Blocks that do not fit in memory come back empty.
+  static CandidateBlock FromBits(
+      uintptr_t base, uint32_t slot_count, const uint64_t* bits, Arena& arena, size_t worker);
+
+  // Rebuilds a block from the fields and encoded() bytes of another, copying the bytes into the chunks of `worker` in
+  // `arena`. Blocks that do not fit in memory come back empty.
+  static CandidateBlock FromEncoded(uintptr_t base,
+                                    uint32_t slot_count,
+                                    uint32_t count,
+                                    Encoding encoding,
+                                    std::span<const uint8_t> encoded,
+                                    Arena& arena,
+                                    size_t worker);
+
+  uintptr_t base() const { return base_; }
+  uint32_t slot_count() const { return slot_count_; }
+  size_t count() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  Encoding encoding() const { return encoding_; }
+
+  // Bitmap of the block for kBitmap, empty otherwise.
+  std::span<const uint64_t> bits() const { return bits_; }
+
+  // Bytes of the bitmap or the delta list, whichever the block uses.
+  std::span<const uint8_t> encoded() const {
+    if (encoding_ == Encoding::kBitmap) {
+      return {reinterpret_cast<const uint8_t*>(bits_.data()), bits_.size_bytes()};
+    }
+    return deltas_;
+  }
+
+  // Arena bytes referenced by the block.
+  size_t memory_usage() const { return bits_.size_bytes() + deltas_.size_bytes(); }
+
+  // Calls `fn(slot)` for every candidate slot in ascending order. If `fn` returns bool, returning false stops the walk
+  // and makes ForEachSlot() return false.
+  template <typename Fn>
+  bool ForEachSlot(Fn&& fn) const;
+
+ private:
+  template <typename Fn>
+  static bool Invoke(Fn& fn, size_t slot) {
+    if constexpr (std::is_same_v<std::invoke_result_t<Fn&, size_t>, bool>) {
+      return fn(slot);
+    } else {
+      fn(slot);
+      return true;
+    }
+  }
+
+  uintptr_t base_{};
+  uint32_t slot_count_{};
+  uint32_t count_{};
+  Encoding encoding_{Encoding::kAll};
+  std::span<const uint64_t> bits_;
+  std::span<const uint8_t> deltas_;
+};
+
+// All candidates of a scan, ordered by address.
+struct CandidateSet {
+  ValueType type{ValueType::kInt32};
+  size_t stride{4};
+  std::vector<CandidateBlock> blocks;
+  // Owns the storage of `blocks`.
+  std::shared_ptr<Arena> arena;
+
+  size_t count() const;
+  size_t memory_usage() const;
+
+  // Calls `fn(address)` for every candidate in ascending order; see CandidateBlock::ForEachSlot() for early exit.
+  template <typename Fn>
+  bool ForEachAddress(Fn&& fn) const;
+};
+
+// Random access by rank over a growing list of candidate blocks, for views that page through results without
+// expanding them: finding a page is a binary search over the blocks plus a walk of one block. Blocks can be appended
+// while a scan is still streaming them (see ResultStream), in any order, since ranks follow the order of appending.
+class CandidatePager {
+ public:
+  explicit CandidatePager(size_t stride) : stride_(stride) {}
+  explicit CandidatePager(const CandidateSet& candidates);
+
+  void Append(const CandidateBlock& block);
+
+  size_t size() const { return offsets_.back(); }
+
+  // Writes the addresses of candidates [first, first + out.size()) to `out` and returns how many there were.
+  size_t Read(size_t first, std::span<uintptr_t> out) const;
+
+ private:
+  size_t stride_;
+  std::vector<CandidateBlock> blocks_;
+  // offsets_[i] is the rank of the first candidate of blocks_[i]; the last entry is the total.
+  std::vector<size_t> offsets_{0};
+};
+
+template <typename Fn>
+bool CandidateBlock::ForEachSlot(Fn&& fn) const {
+  switch (encoding_) {
+    case Encoding::kAll:
+      for (size_t slot = 0; slot < slot_count_; ++slot) {
+        if (!Invoke(fn, slot)) {
+          return false;
+        }
+      }
+      return true;
+    case Encoding::kBitmap:
+      for (size_t i = 0; i < bits_.size(); ++i) {
+        for (uint64_t word = bits_[i]; word != 0; word &= word - 1) {
+          if (!Invoke(fn, i * 64 + static_cast<size_t>(std::countr_zero(word)))) {
+            return false;
+          }
+        }
+      }
+      return true;
+    case Encoding::kDeltas: {
+      // The first entry is the slot itself, every later entry the gap minus one to the previous slot.
+      size_t slot = 0;
+      size_t shift = 0;
+      size_t gap = 0;
+      bool first = true;
+      for (const uint8_t byte : deltas_) {
+        gap |= size_t{byte & 0x7FU} << shift;
+        shift += 7;
+        if ((byte & 0x80U) != 0) {
+          continue;
+        }
+        slot = first ? gap : slot + gap + 1;
+        first = false;
+        gap = 0;
+        shift = 0;
+        if (!Invoke(fn, slot)) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+  return true;
+}
+
+template <typename Fn>
+bool CandidateSet::ForEachAddress(Fn&& fn) const {
+  for (const auto& block : blocks) {
+    const bool completed = block.ForEachSlot([&](size_t slot) {
+      const uintptr_t address = block.base() + slot * stride;
+      if constexpr (std::is_same_v<std::invoke_result_t<Fn&, uintptr_t>, bool>) {
+        return fn(address);
+      } else {
+        fn(address);
+        return true;
+      }
+    });
+    if (!completed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace maia
@@ -0,0 +1,243 @@
+#include "maiascan/scan/checkpoint.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#include "maiascan/core/lz.hpp"
+#include "maiascan/core/perf.hpp"
+
+namespace maia {
+
+namespace {
+
+// Blocks each worker compresses per batch, which bounds the buffers a capture needs besides the checkpoint itself.
+constexpr size_t kBlocksPerWorker = 2;
+
+// Heap chunks are allocated in this size, or smaller when the rest of the memory limit is smaller, so that checkpoints
+// of small generations stay small.
+constexpr size_t kHeapChunkSize = size_t{4} << 20;
+
+// Writes every value of `values` XORed with the value before it to `out`; the first value is kept as it is.
+void XorWithPrevious(std::span<const std::byte> values, size_t value_size, std::vector<uint8_t>& out) {
+  out.resize(values.size());
+  const auto* in = reinterpret_cast<const uint8_t*>(values.data());
+  std::copy_n(in, std::min(value_size, values.size()), out.begin());
+  for (size_t i = value_size; i < values.size(); ++i) {
+    out[i] = in[i] ^ in[i - value_size];
+  }
+}
+
+// Undoes XorWithPrevious() in place.
+void UndoXorWithPrevious(std::span<uint8_t> values, size_t value_size) {
+  for (size_t i = value_size; i < values.size(); ++i) {
+    values[i] ^= values[i - value_size];
+  }
+}
+
+}  // namespace
+
+std::optional<ScanCheckpoint> ScanCheckpoint::Capture(const ScanResult& result,
+                                                      ThreadPool& pool,
+                                                      const CheckpointOptions& options) {
+  PerfPhase phase("checkpoint", &pool);
+  const CandidateSet& candidates = result.candidates;
+  const size_t value_size = SizeOf(candidates.type);
+  ScanCheckpoint checkpoint;
+  checkpoint.type_ = candidates.type;
+  checkpoint.stride_ = candidates.stride;
+  checkpoint.count_ = candidates.count();
+  checkpoint.has_values_ = result.snapshot.has_value();
+  checkpoint.stats_ = result.stats;
+
+  // Blocks are compressed a batch at a time into buffers of their own, since their compressed sizes decide where they
+  // go, and stored before the next batch starts.
+  const size_t block_count = candidates.blocks.size();
+  const size_t batch_size = pool.size() * kBlocksPerWorker;
+  checkpoint.blocks_.resize(block_count);
+  std::vector<std::vector<uint8_t>> compressed(std::min(batch_size, block_count));
+  std::vector<std::vector<uint8_t>> deltas(pool.size());
+  for (size_t first = 0; first < block_count; first += batch_size) {
+    const size_t count = std::min(batch_size, block_count - first);
+    pool.ParallelFor(count, [&](size_t batch_index, size_t worker) {
+      const size_t index = first + batch_index;
+      const CandidateBlock& block = candidates.blocks[index];
+      auto& out = compressed[batch_index];
+      out.clear();
+      const auto encoded = block.encoded();
+      LzCompress(encoded, out);
+      Block& entry = checkpoint.blocks_[index];
+      entry = {.base = block.base(),
+               .slot_count = block.slot_count(),
+               .count = static_cast<uint32_t>(block.count()),
+               .encoding = block.encoding(),
+               .encoded_size = static_cast<uint32_t>(encoded.size()),
+               .values_size = 0,
+               .encoded_compressed = static_cast<uint32_t>(out.size()),
+               .values_compressed = 0,
+               .chunk = 0,
+               .offset = 0};
+      if (checkpoint.has_values_) {
+        const auto values = result.snapshot->block_values(index);
+        XorWithPrevious(values, value_size, deltas[worker]);
+        LzCompress(deltas[worker], out);
+        entry.values_size = static_cast<uint32_t>(values.size());
+        entry.values_compressed = static_cast<uint32_t>(out.size() - entry.encoded_compressed);
+      }
+    });
+
+    for (size_t index = first; index < first + count; ++index) {
+      Block& entry = checkpoint.blocks_[index];
+      if (!checkpoint.has_values_) {
+        entry.values_size = 0;
+        entry.values_compressed = 0;
+      }
+      if (checkpoint.Place(entry, options)) {
+        continue;
+      }
+      // Without room elsewhere the values go first; candidates alone still allow eq and range next scans.
+      if (!checkpoint.has_values_) {
+        return std::nullopt;
+      }
+      checkpoint.DropValues(index);
+      entry.values_size = 0;
+      entry.values_compressed = 0;
+      if (!checkpoint.Place(entry, options)) {
+        return std::nullopt;
+      }
+    }
+    pool.ParallelFor(count, [&](size_t batch_index, size_t) {
+      const Block& entry = checkpoint.blocks_[first + batch_index];
+      std::memcpy(checkpoint.chunks_[entry.chunk].data + entry.offset,
+                  compressed[batch_index].data(),
+                  entry.encoded_compressed + entry.values_compressed);
+    });
+  }
+
+  uint64_t total = 0;
+  for (const Chunk& chunk : checkpoint.chunks_) {
+    total += chunk.used;
+  }
+  phase.Set("candidates", checkpoint.count_);
+  phase.Set("bytes", total);
+  return checkpoint;
+}
+
+bool ScanCheckpoint::Place(Block& entry, const CheckpointOptions& options) {
+  const size_t size = entry.encoded_compressed + entry.values_compressed;
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    if (chunks_[i].size - chunks_[i].used >= size) {
+      entry.chunk = static_cast<uint32_t>(i);
+      entry.offset = chunks_[i].used;
+      chunks_[i].used += size;
+      return true;
+    }
+  }
+
+  Chunk chunk{};
+  if (size <= options.max_memory - heap_size_) {
+    const size_t chunk_size = std::max(size, std::min(kHeapChunkSize, options.max_memory - heap_size_));
+    heap_.push_back(std::make_unique_for_overwrite<uint8_t[]>(chunk_size));
+    heap_size_ += chunk_size;
+    chunk = {.data = heap_.back().get(), .size = chunk_size, .used = 0};
+  } else if (!options.spill_dir.empty() && !spill_failed_) {
+    if (!file_) {
+      file_ = SegmentedFile::CreateTemporary(options.spill_dir, "maiascan-checkpoint");
+    }
+    const auto segment = file_ ? file_->AddSegment(size) : std::span<std::byte>();
+    spill_failed_ = segment.empty();
+    chunk = {.data = reinterpret_cast<uint8_t*>(segment.data()), .size = segment.size(), .used = 0};
+  }
+  if (chunk.size == 0) {
+    return false;
+  }
+  entry.chunk = static_cast<uint32_t>(chunks_.size());
+  entry.offset = 0;
+  chunk.used = size;
+  chunks_.push_back(chunk);
+  return true;
+}
+
+void ScanCheckpoint::DropValues(size_t placed) {
+  // Blocks sit in their chunk in the order they were placed, so moving each one down to the end of the blocks before
+  // it never overwrites one that still has to move.
+  std::vector<size_t> used(chunks_.size());
+  for (size_t i = 0; i < placed; ++i) {
+    Block& entry = blocks_[i];
+    uint8_t* data = chunks_[entry.chunk].data;
+    std::memmove(data + used[entry.chunk], data + entry.offset, entry.encoded_compressed);
+    entry.offset = used[entry.chunk];
+    entry.values_size = 0;
+    entry.values_compressed = 0;
+    used[entry.chunk] += entry.encoded_compressed;
+  }
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    chunks_[i].used = used[i];
+  }
+  has_values_ = false;
+}
+
+size_t ScanCheckpoint::memory_usage() const {
+  return heap_size_ + blocks_.capacity() * sizeof(Block) + chunks_.capacity() * sizeof(Chunk);
+}
+
+ScanResult ScanCheckpoint::Restore(ThreadPool& pool,
+                                   std::shared_ptr<Arena> arena,
+                                   const std::filesystem::path& snapshot_dir) const {
+  PerfPhase phase("restore", &pool);
+  const size_t value_size = SizeOf(type_);
+  std::optional<Snapshot> snapshot;
+  if (has_values_ && !snapshot_dir.empty()) {
+    snapshot = Snapshot::Create(snapshot_dir, pool.size());
+  }
+
+  std::vector<CandidateBlock> blocks(blocks_.size());
+  std::vector<std::span<const std::byte>> values(blocks_.size());
+  std::vector<std::vector<uint8_t>> scratch(pool.size());
+  std::atomic<bool> values_failed{false};
+  pool.ParallelFor(blocks_.size(), [&](size_t index, size_t worker) {
+    const Block& entry = blocks_[index];
+    const uint8_t* in = chunks_[entry.chunk].data + entry.offset;
+    auto& encoded = scratch[worker];
+    encoded.resize(entry.encoded_size);
+    if (!LzDecompress({in, entry.encoded_compressed}, encoded)) {
+      return;
+    }
+    blocks[index] = CandidateBlock::FromEncoded(
+        entry.base, entry.slot_count, entry.count, entry.encoding, encoded, *arena, worker);
+    if (!snapshot || blocks[index].empty()) {
+      return;
+    }
+    const auto storage = snapshot->Allocate(worker, entry.values_size);
+    const std::span<uint8_t> out(reinterpret_cast<uint8_t*>(storage.data()), storage.size());
+    if (storage.empty() || !LzDecompress({in + entry.encoded_compressed, entry.values_compressed}, out)) {
+      values_failed.store(true, std::memory_order_relaxed);
+      return;
+    }
+    UndoXorWithPrevious(out, value_size);
+    values[index] = storage;
+  });
+
+  // Blocks that could not be decoded or did not fit in memory are left out, like the scans that produced them would.
+  ScanResult result;
+  result.candidates.type = type_;
+  result.candidates.stride = stride_;
+  result.candidates.arena = std::move(arena);
+  std::vector<std::span<const std::byte>> kept_values;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (!blocks[i].empty()) {
+      result.candidates.blocks.push_back(blocks[i]);
+      kept_values.push_back(values[i]);
+    }
+  }
+  if (snapshot && !snapshot->failed() && !values_failed.load(std::memory_order_relaxed)) {
+    snapshot->SetBlocks(std::move(kept_values));
+    result.snapshot = std::move(snapshot);
+  }
+  result.stats = stats_;
+  phase.Set("candidates", result.candidates.count());
+  return result;
+}
+
+}  // namespace maia
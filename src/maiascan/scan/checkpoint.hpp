@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/arena.hpp"
+#include "maiascan/core/mapped_file.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/scan/candidates.hpp"
+#include "maiascan/scan/scanner.hpp"
+
+namespace maia {
+
+struct CheckpointOptions {
+  // Compressed bytes a checkpoint may keep on the heap. Blocks past it go to a temporary file in `spill_dir`. Without
+  // one the checkpoint keeps only its candidates, and is not taken at all if even those do not fit.
+  size_t max_memory{size_t{64} << 20};
+  std::filesystem::path spill_dir;
+};
+
+// A scan generation frozen in compressed form: its candidates and, if it had a snapshot, the values recorded in it.
+// Restoring one (see Scanner::Restore()) rebuilds a result that next scans can continue from, without reading the
+// target again.
+//
+// Every candidate block is compressed on its own, in parallel, with LzCompress(): its bitmap or delta list as it is,
+// and its values as the XOR of each value with the one before, which turns repeated and slowly changing values into
+// zero runs. Checkpoints do not depend on each other, so any generation is restored by decoding only its own blocks.
+// Blocks are compressed a few per worker at a time and stored right away, so capturing never holds more than the cap
+// plus those few blocks on the heap.
+class ScanCheckpoint {
+ public:
+  static std::optional<ScanCheckpoint> Capture(const ScanResult& result,
+                                               ThreadPool& pool,
+                                               const CheckpointOptions& options = {});
+
+  ValueType type() const { return type_; }
+  size_t count() const { return count_; }
+  // Whether the snapshot values were kept, which the comparisons of next scans need.
+  bool has_values() const { return has_values_; }
+  // Stats of the scan that produced the generation.
+  const ScanStats& stats() const { return stats_; }
+
+  // Heap held by the checkpoint, and bytes moved to its spill file.
+  size_t memory_usage() const;
+  uint64_t file_size() const { return file_ ? file_->size() : 0; }
+
+  // Decodes the checkpoint into candidate storage from `arena` and, if it has values and `snapshot_dir` is not empty,
+  // a new snapshot in that directory.
+  ScanResult Restore(ThreadPool& pool, std::shared_ptr<Arena> arena, const std::filesystem::path& snapshot_dir) const;
+
+ private:
+  struct Block {
+    uintptr_t base;
+    uint32_t slot_count;
+    uint32_t count;
+    CandidateBlock::Encoding encoding;
+    // Sizes of the encoded candidates and the values, before and after compression. The compressed candidates start at
+    // `offset` into chunks_[chunk] and the compressed values follow them.
+    uint32_t encoded_size;
+    uint32_t values_size;
+    uint32_t encoded_compressed;
+    uint32_t values_compressed;
+    uint32_t chunk;
+    uint64_t offset;
+  };
+
+  // Storage for compressed blocks, either on the heap or a segment of `file_`.
+  struct Chunk {
+    uint8_t* data;
+    size_t size;
+    size_t used;
+  };
+
+  ScanCheckpoint() = default;
+
+  // Finds room for the compressed bytes of `entry`: in a chunk with space left, in a new heap chunk as long as the heap
+  // stays within `options.max_memory`, or else in a new segment of the spill file. Returns false when there is none.
+  bool Place(Block& entry, const CheckpointOptions& options);
+  // Drops the values of the first `placed` blocks and moves their candidates together in their chunks.
+  void DropValues(size_t placed);
+
+  ValueType type_{};
+  size_t stride_{};
+  size_t count_{};
+  bool has_values_{};
+  ScanStats stats_;
+  std::vector<Block> blocks_;
+  std::vector<Chunk> chunks_;
+  // Owns the heap chunks.
+  std::vector<std::unique_ptr<uint8_t[]>> heap_;
+  size_t heap_size_{};
+  std::unique_ptr<SegmentedFile> file_;
+  // Set once the spill file could not be created or grown.
+  bool spill_failed_{};
+};
+
+}  // namespace maia
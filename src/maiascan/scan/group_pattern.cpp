@@ -0,0 +1,153 @@
+#include "maiascan/scan/group_pattern.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+
+#include <fmt/core.h>
+
+#include "maiascan/core/bits.hpp"
+#include "maiascan/scan/kernels_internal.hpp"
+
+namespace maia {
+
+namespace {
+
+// Slots filtered and verified together. Small enough for the tile to stay in L1 between the two passes at the usual
+// strides, and a whole number of bitmap words.
+constexpr size_t kTileBytes = size_t{16} << 10;
+
+template <typename T, bool kRange>
+bool MatchField(const std::byte* data, const MatchPredicate& predicate) {
+  return detail::Matches<T, kRange>(
+      detail::LoadAs<T>(data), detail::LoadAs<T>(predicate.lower), detail::LoadAs<T>(predicate.upper));
+}
+
+std::optional<size_t> ParseOffset(std::string_view text) {
+  int base = 10;
+  if (text.starts_with("0x") || text.starts_with("0X")) {
+    text.remove_prefix(2);
+    base = 16;
+  }
+  size_t offset = 0;
+  const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), offset, base);
+  if (text.empty() || error != std::errc{} || end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return offset;
+}
+
+// Parses `type:value` or `type:lower..upper`.
+std::optional<MatchPredicate> ParseField(std::string_view token, double epsilon) {
+  const size_t colon = token.find(':');
+  if (colon == std::string_view::npos) {
+    return std::nullopt;
+  }
+  const auto type = ParseValueType(token.substr(0, colon));
+  if (!type) {
+    return std::nullopt;
+  }
+  const std::string_view value = token.substr(colon + 1);
+  const size_t dots = value.find("..");
+  if (dots == std::string_view::npos) {
+    const auto exact = ParseScanValue(*type, value);
+    return exact ? std::optional(MakeExactPredicate(*exact, epsilon)) : std::nullopt;
+  }
+  const auto lower = ParseScanValue(*type, value.substr(0, dots));
+  const auto upper = ParseScanValue(*type, value.substr(dots + 2));
+  return lower && upper ? std::optional(MakeRangePredicate(*lower, *upper)) : std::nullopt;
+}
+
+std::string FormatPredicate(const MatchPredicate& predicate) {
+  const std::string lower = FormatValue(predicate.type, predicate.lower.data());
+  if (!predicate.range || predicate.lower == predicate.upper) {
+    return fmt::format("{}:{}", ToString(predicate.type), lower);
+  }
+  return fmt::format("{}:{}..{}", ToString(predicate.type), lower, FormatValue(predicate.type, predicate.upper.data()));
+}
+
+}  // namespace
+
+std::optional<GroupPattern> GroupPattern::Parse(std::string_view text, double epsilon) {
+  GroupPattern pattern;
+  size_t next_offset = 0;
+  bool placed = false;
+  while (true) {
+    const size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+      break;
+    }
+    const size_t end = std::min(text.find_first_of(" \t", begin), text.size());
+    const std::string_view token = text.substr(begin, end - begin);
+    text.remove_prefix(end);
+    if (token.starts_with('+')) {
+      const auto offset = ParseOffset(token.substr(1));
+      if (!offset || placed) {
+        return std::nullopt;
+      }
+      next_offset = *offset;
+      placed = true;
+      continue;
+    }
+    const auto predicate = ParseField(token, epsilon);
+    if (!predicate) {
+      return std::nullopt;
+    }
+    pattern.fields_.push_back({.offset = next_offset, .predicate = *predicate});
+    next_offset += SizeOf(predicate->type);
+    pattern.size_ = std::max(pattern.size_, next_offset);
+    placed = false;
+  }
+  if (pattern.fields_.empty() || placed || pattern.fields_.front().offset != 0) {
+    return std::nullopt;
+  }
+  for (size_t i = 1; i < pattern.fields_.size(); ++i) {
+    const GroupField& field = pattern.fields_[i];
+    pattern.matchers_.push_back(VisitValueType(field.predicate.type, [&]<typename T>() {
+      return field.predicate.range ? &MatchField<T, true> : &MatchField<T, false>;
+    }));
+  }
+  return pattern;
+}
+
+bool GroupPattern::MatchesRest(const std::byte* data) const {
+  for (size_t i = 0; i < matchers_.size(); ++i) {
+    const GroupField& field = fields_[i + 1];
+    if (!matchers_[i](data + field.offset, field.predicate)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string GroupPattern::ToString() const {
+  std::string text;
+  for (const GroupField& field : fields_) {
+    if (!text.empty()) {
+      text += fmt::format(" +{:#x} ", field.offset);
+    }
+    text += FormatPredicate(field.predicate);
+  }
+  return text;
+}
+
+void FindGroupMatches(
+    const std::byte* data, size_t slot_count, size_t stride, const GroupPattern& pattern, uint64_t* bits) {
+  const size_t tile_slots = std::max<size_t>(kTileBytes / stride / 64, 1) * 64;
+  for (size_t first = 0; first < slot_count; first += tile_slots) {
+    const size_t count = std::min(tile_slots, slot_count - first);
+    const std::byte* tile = data + first * stride;
+    uint64_t* tile_bits = bits + first / 64;
+    FindMatches(tile, count, stride, pattern.first(), tile_bits);
+    for (size_t i = 0; i < WordCount(count); ++i) {
+      for (uint64_t word = tile_bits[i]; word != 0; word &= word - 1) {
+        const size_t slot = i * 64 + static_cast<size_t>(std::countr_zero(word));
+        if (!pattern.MatchesRest(tile + slot * stride)) {
+          tile_bits[i] &= ~(uint64_t{1} << (slot % 64));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace maia
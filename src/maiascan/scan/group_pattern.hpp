@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "maiascan/scan/kernels.hpp"
+
+namespace maia {
+
+// One field of a group pattern, at `offset` bytes from the start of the group.
+struct GroupField {
+  size_t offset{};
+  MatchPredicate predicate;
+};
+
+// A struct-like pattern of several typed values at fixed offsets from each other, e.g. a float health at +0, its
+// maximum at +4 and an id at +0x10. Candidates are the addresses of the first field, so a group scan keeps the
+// candidate grid and the value type of its first field and later next scans refine that field.
+class GroupPattern {
+ public:
+  // Parses whitespace-separated fields of the form `type:value` or `type:lower..upper`, with the types ParseValueType()
+  // accepts. Every field starts where the previous one ends unless a `+offset` token in front of it places it at that
+  // many bytes from the first field, e.g. "f32:100 f32:100 +0x10 i32:42". Floating point values match within
+  // `epsilon`. Fails for malformed fields and when the first field is not at offset 0.
+  static std::optional<GroupPattern> Parse(std::string_view text, double epsilon = 0);
+
+  // Fields in the order given; the first one is at offset 0.
+  std::span<const GroupField> fields() const { return fields_; }
+  const MatchPredicate& first() const { return fields_.front().predicate; }
+
+  // Bytes from the start of the first field to the end of the last one.
+  size_t size() const { return size_; }
+
+  // Whether every field but the first matches for the group starting at `data`, which must hold size() bytes.
+  bool MatchesRest(const std::byte* data) const;
+
+  // The pattern in the form Parse() accepts, with every offset spelled out.
+  std::string ToString() const;
+
+ private:
+  using FieldMatcher = bool (*)(const std::byte* data, const MatchPredicate& predicate);
+
+  GroupPattern() = default;
+
+  std::vector<GroupField> fields_;
+  // Matchers of fields_[1..], instantiated for their type and comparison when the pattern is parsed.
+  std::vector<FieldMatcher> matchers_;
+  size_t size_{};
+};
+
+// Sets bit `i` of `bits` when the group at `data + i * stride` matches `pattern`, for every `i < slot_count`, and
+// clears the others. `data` must hold `(slot_count - 1) * stride + pattern.size()` bytes. The first field is filtered
+// with the vector kernels a tile at a time, and its hits are verified against the other fields right after, while the
+// tile is still in cache.
+void FindGroupMatches(
+    const std::byte* data, size_t slot_count, size_t stride, const GroupPattern& pattern, uint64_t* bits);
+
+}  // namespace maia
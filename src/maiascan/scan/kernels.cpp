@@ -0,0 +1,208 @@
+#include "maiascan/scan/kernels.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+#include "maiascan/core/bits.hpp"
+#include "maiascan/core/cpu_features.hpp"
+#include "maiascan/scan/kernels_internal.hpp"
+
+namespace maia {
+
+namespace {
+
+using detail::LaneKernel;
+
+template <typename T, bool kRange>
+void ScalarKernel(const std::byte* data, size_t lanes, const MatchPredicate& predicate, uint64_t* bits) {
+  const T lower = detail::LoadAs<T>(predicate.lower);
+  const T upper = detail::LoadAs<T>(predicate.upper);
+  detail::RunWords<T, kRange>(data, lanes, predicate, bits, [&](const std::byte* word_data) {
+    return detail::ScalarWord<T, kRange>(word_data, 64, lower, upper);
+  });
+}
+
+LaneKernel SelectScalarKernel(ValueType type, bool range) {
+  return VisitValueType(type, [&]<typename T>() -> LaneKernel {
+    return range ? &ScalarKernel<T, true> : &ScalarKernel<T, false>;
+  });
+}
+
+// Candidates further apart than this many values are loaded one by one instead of evaluating every packed lane in
+// between with a vector kernel.
+constexpr size_t kMaxPackedStep = 8;
+
+using StridedKernel = void (*)(const std::byte* data,
+                               size_t slot_count,
+                               size_t stride,
+                               const MatchPredicate& predicate,
+                               uint64_t* bits);
+
+template <typename T, bool kRange>
+void ScalarStridedKernel(
+    const std::byte* data, size_t slot_count, size_t stride, const MatchPredicate& predicate, uint64_t* bits) {
+  const T lower = detail::LoadAs<T>(predicate.lower);
+  const T upper = detail::LoadAs<T>(predicate.upper);
+  for (size_t word = 0; word * 64 < slot_count; ++word) {
+    const size_t slots = std::min<size_t>(64, slot_count - word * 64);
+    const std::byte* word_data = data + word * 64 * stride;
+    uint64_t matches = 0;
+    for (size_t slot = 0; slot < slots; ++slot) {
+      matches |= uint64_t{detail::Matches<T, kRange>(detail::LoadAs<T>(word_data + slot * stride), lower, upper)}
+                 << slot;
+    }
+    bits[word] = matches;
+  }
+}
+
+StridedKernel SelectStridedKernel(ValueType type, bool range) {
+  return VisitValueType(type, [&]<typename T>() -> StridedKernel {
+    return range ? &ScalarStridedKernel<T, true> : &ScalarStridedKernel<T, false>;
+  });
+}
+
+// Word with every `step`-th bit set, starting at bit 0, for a power of two `step` of at most 64.
+uint64_t EveryNthBit(size_t step) {
+  uint64_t mask = 0;
+  for (size_t bit = 0; bit < 64; bit += step) {
+    mask |= uint64_t{1} << bit;
+  }
+  return mask;
+}
+
+// Whether slots `stride` bytes apart map onto whole lanes of densely packed values: overlapping slots must split a value
+// into equal phases, and sparse slots must skip the same lanes in every bitmap word.
+bool IsPackedStride(size_t stride, size_t value_size) {
+  if (stride < value_size) {
+    return value_size % stride == 0;
+  }
+  return stride % value_size == 0 && std::has_single_bit(stride / value_size);
+}
+
+LaneKernel SelectKernel(KernelIsa isa, const MatchPredicate& predicate) {
+  LaneKernel kernel = nullptr;
+  if (isa == KernelIsa::kAvx2) {
+    kernel = detail::SelectAvx2Kernel(predicate.type, predicate.range);
+  }
+  if (kernel == nullptr && isa >= KernelIsa::kSse41) {
+    kernel = detail::SelectSse41Kernel(predicate.type, predicate.range);
+  }
+  return kernel != nullptr ? kernel : SelectScalarKernel(predicate.type, predicate.range);
+}
+
+KernelIsa DetectKernelIsa() {
+  const auto& features = GetCpuFeatures();
+  if (features.avx2) {
+    return KernelIsa::kAvx2;
+  }
+  if (features.sse41) {
+    return KernelIsa::kSse41;
+  }
+  return KernelIsa::kScalar;
+}
+
+template <typename T>
+MatchPredicate MakeFloatRange(const ScanValue& value, double epsilon) {
+  const T center = value.As<T>();
+  const T delta = static_cast<T>(epsilon < 0 ? -epsilon : epsilon);
+  const T lower = center - delta;
+  const T upper = center + delta;
+  MatchPredicate predicate{.type = value.type, .range = true};
+  std::memcpy(predicate.lower.data(), &lower, sizeof(T));
+  std::memcpy(predicate.upper.data(), &upper, sizeof(T));
+  return predicate;
+}
+
+}  // namespace
+
+MatchPredicate MakeExactPredicate(const ScanValue& value, double epsilon) {
+  if (value.type == ValueType::kFloat) {
+    return MakeFloatRange<float>(value, epsilon);
+  }
+  if (value.type == ValueType::kDouble) {
+    return MakeFloatRange<double>(value, epsilon);
+  }
+  return {.type = value.type, .range = false, .lower = value.bytes, .upper = value.bytes};
+}
+
+MatchPredicate MakeRangePredicate(const ScanValue& lower, const ScanValue& upper) {
+  return {.type = lower.type, .range = true, .lower = lower.bytes, .upper = upper.bytes};
+}
+
+KernelIsa ActiveKernelIsa() {
+  static const KernelIsa isa = DetectKernelIsa();
+  return isa;
+}
+
+std::string_view ToString(KernelIsa isa) {
+  switch (isa) {
+    case KernelIsa::kScalar:
+      return "scalar";
+    case KernelIsa::kSse41:
+      return "sse4.1";
+    case KernelIsa::kAvx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+void FindMatches(const std::byte* data,
+                 size_t slot_count,
+                 size_t stride,
+                 const MatchPredicate& predicate,
+                 uint64_t* bits) {
+  FindMatches(ActiveKernelIsa(), data, slot_count, stride, predicate, bits);
+}
+
+void FindMatches(KernelIsa isa,
+                 const std::byte* data,
+                 size_t slot_count,
+                 size_t stride,
+                 const MatchPredicate& predicate,
+                 uint64_t* bits) {
+  if (slot_count == 0) {
+    return;
+  }
+  // Every combination of type and comparison has a kernel of its own, chosen here once per call, so none of the loops
+  // below decides anything per value.
+  const size_t value_size = SizeOf(predicate.type);
+  if (stride > value_size * kMaxPackedStep || !IsPackedStride(stride, value_size)) {
+    SelectStridedKernel(predicate.type, predicate.range)(data, slot_count, stride, predicate, bits);
+    return;
+  }
+  const LaneKernel kernel = SelectKernel(isa, predicate);
+  if (stride == value_size) {
+    kernel(data, slot_count, predicate, bits);
+    return;
+  }
+
+  // The kernels only understand densely packed values. Other packed strides are evaluated as densely packed lanes and
+  // the lane bits are then mapped back onto candidate slots.
+  std::fill(bits, bits + WordCount(slot_count), 0);
+  thread_local std::vector<uint64_t> lane_bits;
+  if (stride < value_size) {
+    // Overlapping candidates: every phase is a packed array starting `phase * stride` bytes in.
+    const size_t phases = value_size / stride;
+    for (size_t phase = 0; phase < phases && phase < slot_count; ++phase) {
+      const size_t lanes = (slot_count - phase + phases - 1) / phases;
+      lane_bits.resize(WordCount(lanes));
+      kernel(data + phase * stride, lanes, predicate, lane_bits.data());
+      ForEachSetBit(lane_bits.data(), lanes, [&](size_t lane) { SetBit(bits, lane * phases + phase); });
+    }
+  } else {
+    // Sparse candidates: only every `step`-th packed lane is a candidate, so the other lanes are masked off before the
+    // remaining bits are moved to their slots.
+    const size_t step = stride / value_size;
+    const size_t lanes = (slot_count - 1) * step + 1;
+    lane_bits.resize(WordCount(lanes));
+    kernel(data, lanes, predicate, lane_bits.data());
+    const uint64_t candidate_lanes = EveryNthBit(step);
+    for (auto& word : lane_bits) {
+      word &= candidate_lanes;
+    }
+    ForEachSetBit(lane_bits.data(), lanes, [&](size_t lane) { SetBit(bits, lane / step); });
+  }
+}
+
+}  // namespace maia
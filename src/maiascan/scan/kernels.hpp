@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "maiascan/scan/value.hpp"
+
+namespace maia {
+
+// Value predicate evaluated by the match kernels. Bounds are stored in target representation.
+struct MatchPredicate {
+  ValueType type{ValueType::kInt32};
+  // When false the predicate is bitwise equality with `lower`, otherwise the inclusive range [lower, upper].
+  bool range{};
+  std::array<std::byte, 8> lower{};
+  std::array<std::byte, 8> upper{};
+};
+
+// Floating point values are matched as the range [value - epsilon, value + epsilon], which also makes +0 and -0 compare
+// equal and never matches NaN. `epsilon` is ignored for integer types.
+MatchPredicate MakeExactPredicate(const ScanValue& value, double epsilon = 0);
+MatchPredicate MakeRangePredicate(const ScanValue& lower, const ScanValue& upper);
+
+enum class KernelIsa : uint8_t { kScalar, kSse41, kAvx2 };
+
+// The widest instruction set supported by both the build and the CPU, picked with CPUID on first use.
+KernelIsa ActiveKernelIsa();
+std::string_view ToString(KernelIsa isa);
+
+// Sets bit `i` of `bits` when the value at `data + i * stride` satisfies `predicate`, for every `i < slot_count`, and
+// clears it otherwise. `bits` must hold `WordCount(slot_count)` words and `data` must be readable up to
+// `(slot_count - 1) * stride + SizeOf(predicate.type)` bytes. Strides that are a power-of-two fraction or multiple of
+// the value size run the vector kernels, any other stride loads the values one by one.
+void FindMatches(const std::byte* data,
+                 size_t slot_count,
+                 size_t stride,
+                 const MatchPredicate& predicate,
+                 uint64_t* bits);
+
+// Same as FindMatches() but forces a particular instruction set, which must be supported by the CPU.
+void FindMatches(KernelIsa isa,
+                 const std::byte* data,
+                 size_t slot_count,
+                 size_t stride,
+                 const MatchPredicate& predicate,
+                 uint64_t* bits);
+
+}  // namespace maia
@@ -0,0 +1,299 @@
+// Compiled with AVX2 code generation enabled; only reached after ActiveKernelIsa() confirmed CPU support.
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#include "maiascan/scan/kernels_internal.hpp"
+
+namespace maia::detail {
+
+namespace {
+
+template <typename T>
+__m256i Broadcast(const std::array<std::byte, 8>& bytes) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm256_set1_epi8(LoadAs<char>(bytes));
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm256_set1_epi16(LoadAs<int16_t>(bytes));
+  } else if constexpr (sizeof(T) == 4) {
+    return _mm256_set1_epi32(LoadAs<int32_t>(bytes));
+  } else {
+    return _mm256_set1_epi64x(LoadAs<int64_t>(bytes));
+  }
+}
+
+template <typename T>
+__m256i CompareEqual(__m256i a, __m256i b) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm256_cmpeq_epi8(a, b);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm256_cmpeq_epi16(a, b);
+  } else if constexpr (sizeof(T) == 4) {
+    return _mm256_cmpeq_epi32(a, b);
+  } else {
+    return _mm256_cmpeq_epi64(a, b);
+  }
+}
+
+template <typename T>
+__m256i Min(__m256i a, __m256i b) {
+  if constexpr (std::is_same_v<T, int8_t>) {
+    return _mm256_min_epi8(a, b);
+  } else if constexpr (std::is_same_v<T, uint8_t>) {
+    return _mm256_min_epu8(a, b);
+  } else if constexpr (std::is_same_v<T, int16_t>) {
+    return _mm256_min_epi16(a, b);
+  } else if constexpr (std::is_same_v<T, uint16_t>) {
+    return _mm256_min_epu16(a, b);
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return _mm256_min_epi32(a, b);
+  } else {
+    static_assert(std::is_same_v<T, uint32_t>);
+    return _mm256_min_epu32(a, b);
+  }
+}
+
+template <typename T>
+__m256i Max(__m256i a, __m256i b) {
+  if constexpr (std::is_same_v<T, int8_t>) {
+    return _mm256_max_epi8(a, b);
+  } else if constexpr (std::is_same_v<T, uint8_t>) {
+    return _mm256_max_epu8(a, b);
+  } else if constexpr (std::is_same_v<T, int16_t>) {
+    return _mm256_max_epi16(a, b);
+  } else if constexpr (std::is_same_v<T, uint16_t>) {
+    return _mm256_max_epu16(a, b);
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return _mm256_max_epi32(a, b);
+  } else {
+    static_assert(std::is_same_v<T, uint32_t>);
+    return _mm256_max_epu32(a, b);
+  }
+}
+
+// All-ones lanes where lower <= value <= upper.
+template <typename T>
+__m256i InRange(__m256i value, __m256i lower, __m256i upper) {
+  if constexpr (std::is_same_v<T, float>) {
+    const __m256 v = _mm256_castsi256_ps(value);
+    return _mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(v, _mm256_castsi256_ps(lower), _CMP_GE_OQ),
+                                             _mm256_cmp_ps(v, _mm256_castsi256_ps(upper), _CMP_LE_OQ)));
+  } else if constexpr (std::is_same_v<T, double>) {
+    const __m256d v = _mm256_castsi256_pd(value);
+    return _mm256_castpd_si256(_mm256_and_pd(_mm256_cmp_pd(v, _mm256_castsi256_pd(lower), _CMP_GE_OQ),
+                                             _mm256_cmp_pd(v, _mm256_castsi256_pd(upper), _CMP_LE_OQ)));
+  } else if constexpr (sizeof(T) == 8) {
+    // No 64-bit min/max below AVX-512; use signed compares, biasing unsigned operands into signed order.
+    if constexpr (std::is_unsigned_v<T>) {
+      const __m256i bias = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+      value = _mm256_xor_si256(value, bias);
+      lower = _mm256_xor_si256(lower, bias);
+      upper = _mm256_xor_si256(upper, bias);
+    }
+    const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(lower, value), _mm256_cmpgt_epi64(value, upper));
+    return _mm256_xor_si256(outside, _mm256_set1_epi64x(-1));
+  } else {
+    return _mm256_and_si256(CompareEqual<T>(Max<T>(value, lower), value), CompareEqual<T>(Min<T>(value, upper), value));
+  }
+}
+
+// One bit per lane of a compare result.
+template <typename T>
+uint32_t MoveMask(__m256i mask) {
+  if constexpr (sizeof(T) == 1) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+  } else if constexpr (sizeof(T) == 2) {
+    // Narrow the 16-bit lanes to bytes; packs works per 128-bit half, so restore the order with a permute.
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(mask, mask), 0xD8);
+    return static_cast<uint32_t>(_mm256_movemask_epi8(packed)) & 0xFFFF;
+  } else if constexpr (sizeof(T) == 4) {
+    return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+  } else {
+    return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+  }
+}
+
+template <typename T, bool kRange>
+void Kernel(const std::byte* data, size_t lanes, const MatchPredicate& predicate, uint64_t* bits) {
+  constexpr size_t kLanesPerVector = sizeof(__m256i) / sizeof(T);
+  constexpr size_t kVectorsPerWord = 64 / kLanesPerVector;
+  const __m256i lower = Broadcast<T>(predicate.lower);
+  const __m256i upper = Broadcast<T>(predicate.upper);
+  RunWords<T, kRange>(data, lanes, predicate, bits, [&](const std::byte* word_data) {
+    uint64_t word = 0;
+    for (size_t v = 0; v < kVectorsPerWord; ++v) {
+      const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(word_data + v * sizeof(__m256i)));
+      __m256i mask;
+      if constexpr (kRange) {
+        mask = InRange<T>(value, lower, upper);
+      } else {
+        mask = CompareEqual<T>(value, lower);
+      }
+      word |= uint64_t{MoveMask<T>(mask)} << (v * kLanesPerVector);
+    }
+    return word;
+  });
+}
+
+// Whether the pattern matches at `data`, which must be readable for `signature.padded_size()` bytes.
+bool MatchesPadded(const std::byte* data, const Signature& signature) {
+  for (size_t i = 0; i < signature.padded_size(); i += sizeof(__m256i)) {
+    const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i pattern = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(signature.padded_bytes() + i));
+    const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(signature.padded_mask() + i));
+    if (!_mm256_testz_si256(_mm256_xor_si256(value, pattern), mask)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Whether `encoded` matches at `data`, which must be readable for its padded size.
+bool MatchesPadded(const std::byte* data, const EncodedString& encoded) {
+  for (size_t i = 0; i < encoded.bytes.size(); i += sizeof(__m256i)) {
+    const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i fold = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(encoded.fold.data() + i));
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(encoded.bytes.data() + i));
+    const __m256i equal = _mm256_cmpeq_epi8(_mm256_or_si256(value, fold), bytes);
+    if (static_cast<uint32_t>(_mm256_movemask_epi8(equal)) != 0xFFFFFFFFU) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A vector holding `byte` in every lane.
+__m256i Splat(std::byte byte) { return _mm256_set1_epi8(static_cast<char>(byte)); }
+
+// FindString() for exactly `kEncodings` encodings, so that the filter of every encoding is unrolled into the loop.
+template <size_t kEncodings>
+void FindEncodedStrings(const std::byte* data,
+                        size_t size,
+                        size_t limit,
+                        std::span<const EncodedString> encodings,
+                        std::vector<StringHit>& hits) {
+  const size_t count = std::min(size, limit);
+  __m256i first[kEncodings];
+  __m256i first_fold[kEncodings];
+  __m256i second[kEncodings];
+  __m256i second_fold[kEncodings];
+  for (size_t e = 0; e < kEncodings; ++e) {
+    first[e] = Splat(encodings[e].bytes[0]);
+    first_fold[e] = Splat(encodings[e].fold[0]);
+    second[e] = Splat(encodings[e].bytes[1]);
+    second_fold[e] = Splat(encodings[e].fold[1]);
+  }
+  const auto verify = [&](size_t offset, const EncodedString& encoded) {
+    if (offset + encoded.size > size) {
+      return;
+    }
+    const bool padded = offset + encoded.bytes.size() <= size;
+    if (padded ? MatchesPadded(data + offset, encoded) : encoded.MatchesAt(data + offset)) {
+      hits.push_back({.offset = offset, .encoding = encoded.encoding});
+    }
+  };
+
+  // Every vector is compared at two neighbouring offsets, which checks the first two bytes of all encodings at once.
+  size_t start = 0;
+  for (; start < count && start + sizeof(__m256i) + 1 <= size; start += sizeof(__m256i)) {
+    const __m256i at = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + start));
+    const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + start + 1));
+    std::array<uint32_t, kEncodings> candidates;
+    uint32_t any = 0;
+    for (size_t e = 0; e < kEncodings; ++e) {
+      const __m256i first_equal = _mm256_cmpeq_epi8(_mm256_or_si256(at, first_fold[e]), first[e]);
+      const __m256i second_equal = _mm256_cmpeq_epi8(_mm256_or_si256(next, second_fold[e]), second[e]);
+      candidates[e] = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(first_equal, second_equal)));
+      any |= candidates[e];
+    }
+    for (; any != 0; any &= any - 1) {
+      const auto lane = static_cast<size_t>(std::countr_zero(any));
+      if (start + lane >= count) {
+        break;
+      }
+      for (size_t e = 0; e < kEncodings; ++e) {
+        if ((candidates[e] >> lane & 1) != 0) {
+          verify(start + lane, encodings[e]);
+        }
+      }
+    }
+  }
+  for (; start < count; ++start) {
+    for (const EncodedString& encoded : encodings) {
+      verify(start, encoded);
+    }
+  }
+}
+
+}  // namespace
+
+LaneKernel SelectAvx2Kernel(ValueType type, bool range) {
+  return VisitValueType(type, [&]<typename T>() -> LaneKernel { return range ? &Kernel<T, true> : &Kernel<T, false>; });
+}
+
+void FindSignatureAvx2(const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets) {
+  if (size < signature.size()) {
+    return;
+  }
+  const size_t count = size - signature.size() + 1;
+  // Candidates from here on cannot load the whole padded pattern and are verified byte by byte.
+  const size_t padded_count = size >= signature.padded_size() ? size - signature.padded_size() + 1 : 0;
+  const std::byte* anchors = data + signature.anchor();
+  const __m256i needle = _mm256_set1_epi8(static_cast<char>(signature.anchor_byte()));
+  const auto verify = [&](size_t offset) {
+    if (offset < padded_count ? MatchesPadded(data + offset, signature) : signature.MatchesAt(data + offset)) {
+      offsets.push_back(offset);
+    }
+  };
+
+  // Four vectors per step, checked for any anchor at all with a single branch, as memchr does.
+  constexpr size_t kStep = 4 * sizeof(__m256i);
+  size_t start = 0;
+  const auto scan_vector = [&](size_t at, __m256i equal) {
+    for (auto hits = static_cast<uint32_t>(_mm256_movemask_epi8(equal)); hits != 0; hits &= hits - 1) {
+      verify(at + static_cast<size_t>(std::countr_zero(hits)));
+    }
+  };
+  for (; start + kStep <= count; start += kStep) {
+    const auto* vectors = reinterpret_cast<const __m256i*>(anchors + start);
+    const __m256i equal0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(vectors), needle);
+    const __m256i equal1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(vectors + 1), needle);
+    const __m256i equal2 = _mm256_cmpeq_epi8(_mm256_loadu_si256(vectors + 2), needle);
+    const __m256i equal3 = _mm256_cmpeq_epi8(_mm256_loadu_si256(vectors + 3), needle);
+    const __m256i any = _mm256_or_si256(_mm256_or_si256(equal0, equal1), _mm256_or_si256(equal2, equal3));
+    if (_mm256_testz_si256(any, any)) {
+      continue;
+    }
+    scan_vector(start, equal0);
+    scan_vector(start + sizeof(__m256i), equal1);
+    scan_vector(start + 2 * sizeof(__m256i), equal2);
+    scan_vector(start + 3 * sizeof(__m256i), equal3);
+  }
+  for (; start + sizeof(__m256i) <= count; start += sizeof(__m256i)) {
+    const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(anchors + start));
+    scan_vector(start, _mm256_cmpeq_epi8(value, needle));
+  }
+  for (; start < count; ++start) {
+    if (anchors[start] == signature.anchor_byte()) {
+      verify(start);
+    }
+  }
+}
+
+void FindStringAvx2(
+    const std::byte* data, size_t size, size_t limit, const StringPattern& pattern, std::vector<StringHit>& hits) {
+  const auto encodings = pattern.encodings();
+  if (encodings.size() == 2) {
+    FindEncodedStrings<2>(data, size, limit, encodings, hits);
+  } else {
+    FindEncodedStrings<1>(data, size, limit, encodings, hits);
+  }
+}
+
+}  // namespace maia::detail
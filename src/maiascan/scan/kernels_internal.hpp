@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "maiascan/scan/kernels.hpp"
+#include "maiascan/scan/signature.hpp"
+#include "maiascan/scan/string_pattern.hpp"
+
+namespace maia::detail {
+
+// Evaluates the predicate for `lanes` values packed back to back, i.e. with a stride equal to the value size, and
+// writes one bit per lane into `WordCount(lanes)` words of `bits`.
+using LaneKernel = void (*)(const std::byte* data, size_t lanes, const MatchPredicate& predicate, uint64_t* bits);
+
+// Return nullptr when the instruction set has no vector form for the requested combination.
+LaneKernel SelectSse41Kernel(ValueType type, bool range);
+LaneKernel SelectAvx2Kernel(ValueType type, bool range);
+
+// FindSignature() with the anchor byte searched a vector at a time and candidates verified with masked vector compares.
+void FindSignatureSse41(const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets);
+void FindSignatureAvx2(const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets);
+
+// FindString() filtering on the first two folded bytes of every encoding within one vector pass, and verifying
+// candidates a vector at a time.
+void FindStringSse41(
+    const std::byte* data, size_t size, size_t limit, const StringPattern& pattern, std::vector<StringHit>& hits);
+void FindStringAvx2(
+    const std::byte* data, size_t size, size_t limit, const StringPattern& pattern, std::vector<StringHit>& hits);
+
+template <typename T, size_t N>
+T LoadAs(const std::array<std::byte, N>& bytes) {
+  static_assert(sizeof(T) <= N);
+  T value;
+  std::memcpy(&value, bytes.data(), sizeof(T));
+  return value;
+}
+
+template <typename T>
+T LoadAs(const std::byte* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+// The predicate on a single value, with the kind of comparison fixed at compile time so that scalar loops built on it
+// carry no per-value dispatch.
+template <typename T, bool kRange>
+bool Matches(T value, T lower, T upper) {
+  if constexpr (kRange) {
+    return lower <= value && value <= upper;
+  } else {
+    return value == lower;
+  }
+}
+
+// Scalar evaluation of up to 64 lanes, used for whole buffers by the scalar kernel and for tails by the vector ones.
+template <typename T, bool kRange>
+uint64_t ScalarWord(const std::byte* data, size_t lanes, T lower, T upper) {
+  uint64_t word = 0;
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    word |= uint64_t{Matches<T, kRange>(LoadAs<T>(data + lane * sizeof(T)), lower, upper)} << lane;
+  }
+  return word;
+}
+
+// Runs the 64-lane `word_fn(data)` over every complete word and finishes the remainder with ScalarWord().
+template <typename T, bool kRange, typename WordFn>
+void RunWords(const std::byte* data, size_t lanes, const MatchPredicate& predicate, uint64_t* bits, WordFn&& word_fn) {
+  const size_t full_words = lanes / 64;
+  for (size_t word = 0; word < full_words; ++word) {
+    bits[word] = word_fn(data + word * 64 * sizeof(T));
+  }
+  if (lanes % 64 != 0) {
+    bits[full_words] = ScalarWord<T, kRange>(
+        data + full_words * 64 * sizeof(T), lanes % 64, LoadAs<T>(predicate.lower), LoadAs<T>(predicate.upper));
+  }
+}
+
+}  // namespace maia::detail
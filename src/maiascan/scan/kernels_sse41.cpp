@@ -0,0 +1,291 @@
+// Compiled with SSE4.1 code generation enabled; only reached after ActiveKernelIsa() confirmed CPU support.
+
+#include <smmintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#include <type_traits>
+
+#include "maiascan/scan/kernels_internal.hpp"
+
+namespace maia::detail {
+
+namespace {
+
+template <typename T>
+__m128i Broadcast(const std::array<std::byte, 8>& bytes) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm_set1_epi8(LoadAs<char>(bytes));
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm_set1_epi16(LoadAs<int16_t>(bytes));
+  } else if constexpr (sizeof(T) == 4) {
+    return _mm_set1_epi32(LoadAs<int32_t>(bytes));
+  } else {
+    return _mm_set1_epi64x(LoadAs<int64_t>(bytes));
+  }
+}
+
+template <typename T>
+__m128i CompareEqual(__m128i a, __m128i b) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm_cmpeq_epi8(a, b);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm_cmpeq_epi16(a, b);
+  } else if constexpr (sizeof(T) == 4) {
+    return _mm_cmpeq_epi32(a, b);
+  } else {
+    return _mm_cmpeq_epi64(a, b);
+  }
+}
+
+template <typename T>
+__m128i Min(__m128i a, __m128i b) {
+  if constexpr (std::is_same_v<T, int8_t>) {
+    return _mm_min_epi8(a, b);
+  } else if constexpr (std::is_same_v<T, uint8_t>) {
+    return _mm_min_epu8(a, b);
+  } else if constexpr (std::is_same_v<T, int16_t>) {
+    return _mm_min_epi16(a, b);
+  } else if constexpr (std::is_same_v<T, uint16_t>) {
+    return _mm_min_epu16(a, b);
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return _mm_min_epi32(a, b);
+  } else {
+    static_assert(std::is_same_v<T, uint32_t>);
+    return _mm_min_epu32(a, b);
+  }
+}
+
+template <typename T>
+__m128i Max(__m128i a, __m128i b) {
+  if constexpr (std::is_same_v<T, int8_t>) {
+    return _mm_max_epi8(a, b);
+  } else if constexpr (std::is_same_v<T, uint8_t>) {
+    return _mm_max_epu8(a, b);
+  } else if constexpr (std::is_same_v<T, int16_t>) {
+    return _mm_max_epi16(a, b);
+  } else if constexpr (std::is_same_v<T, uint16_t>) {
+    return _mm_max_epu16(a, b);
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return _mm_max_epi32(a, b);
+  } else {
+    static_assert(std::is_same_v<T, uint32_t>);
+    return _mm_max_epu32(a, b);
+  }
+}
+
+// All-ones lanes where lower <= value <= upper. 64-bit integers are not handled, see SelectSse41Kernel().
+template <typename T>
+__m128i InRange(__m128i value, __m128i lower, __m128i upper) {
+  if constexpr (std::is_same_v<T, float>) {
+    const __m128 v = _mm_castsi128_ps(value);
+    return _mm_castps_si128(
+        _mm_and_ps(_mm_cmpge_ps(v, _mm_castsi128_ps(lower)), _mm_cmple_ps(v, _mm_castsi128_ps(upper))));
+  } else if constexpr (std::is_same_v<T, double>) {
+    const __m128d v = _mm_castsi128_pd(value);
+    return _mm_castpd_si128(
+        _mm_and_pd(_mm_cmpge_pd(v, _mm_castsi128_pd(lower)), _mm_cmple_pd(v, _mm_castsi128_pd(upper))));
+  } else {
+    return _mm_and_si128(CompareEqual<T>(Max<T>(value, lower), value), CompareEqual<T>(Min<T>(value, upper), value));
+  }
+}
+
+template <typename T>
+uint32_t MoveMask(__m128i mask) {
+  if constexpr (sizeof(T) == 1) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(mask));
+  } else if constexpr (sizeof(T) == 2) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(mask, mask))) & 0xFF;
+  } else if constexpr (sizeof(T) == 4) {
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+  } else {
+    return static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(mask)));
+  }
+}
+
+template <typename T, bool kRange>
+void Kernel(const std::byte* data, size_t lanes, const MatchPredicate& predicate, uint64_t* bits) {
+  constexpr size_t kLanesPerVector = sizeof(__m128i) / sizeof(T);
+  constexpr size_t kVectorsPerWord = 64 / kLanesPerVector;
+  const __m128i lower = Broadcast<T>(predicate.lower);
+  const __m128i upper = Broadcast<T>(predicate.upper);
+  RunWords<T, kRange>(data, lanes, predicate, bits, [&](const std::byte* word_data) {
+    uint64_t word = 0;
+    for (size_t v = 0; v < kVectorsPerWord; ++v) {
+      const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(word_data + v * sizeof(__m128i)));
+      __m128i mask;
+      if constexpr (kRange) {
+        mask = InRange<T>(value, lower, upper);
+      } else {
+        mask = CompareEqual<T>(value, lower);
+      }
+      word |= uint64_t{MoveMask<T>(mask)} << (v * kLanesPerVector);
+    }
+    return word;
+  });
+}
+
+// Whether the pattern matches at `data`, which must be readable for `signature.padded_size()` bytes.
+bool MatchesPadded(const std::byte* data, const Signature& signature) {
+  for (size_t i = 0; i < signature.padded_size(); i += sizeof(__m128i)) {
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i pattern = _mm_loadu_si128(reinterpret_cast<const __m128i*>(signature.padded_bytes() + i));
+    const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(signature.padded_mask() + i));
+    if (!_mm_testz_si128(_mm_xor_si128(value, pattern), mask)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Whether `encoded` matches at `data`, which must be readable for its padded size.
+bool MatchesPadded(const std::byte* data, const EncodedString& encoded) {
+  for (size_t i = 0; i < encoded.bytes.size(); i += sizeof(__m128i)) {
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i fold = _mm_loadu_si128(reinterpret_cast<const __m128i*>(encoded.fold.data() + i));
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(encoded.bytes.data() + i));
+    const __m128i equal = _mm_cmpeq_epi8(_mm_or_si128(value, fold), bytes);
+    if (static_cast<uint32_t>(_mm_movemask_epi8(equal)) != 0xFFFFU) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A vector holding `byte` in every lane.
+__m128i Splat(std::byte byte) { return _mm_set1_epi8(static_cast<char>(byte)); }
+
+// FindString() for exactly `kEncodings` encodings, so that the filter of every encoding is unrolled into the loop.
+template <size_t kEncodings>
+void FindEncodedStrings(const std::byte* data,
+                        size_t size,
+                        size_t limit,
+                        std::span<const EncodedString> encodings,
+                        std::vector<StringHit>& hits) {
+  const size_t count = std::min(size, limit);
+  __m128i first[kEncodings];
+  __m128i first_fold[kEncodings];
+  __m128i second[kEncodings];
+  __m128i second_fold[kEncodings];
+  for (size_t e = 0; e < kEncodings; ++e) {
+    first[e] = Splat(encodings[e].bytes[0]);
+    first_fold[e] = Splat(encodings[e].fold[0]);
+    second[e] = Splat(encodings[e].bytes[1]);
+    second_fold[e] = Splat(encodings[e].fold[1]);
+  }
+  const auto verify = [&](size_t offset, const EncodedString& encoded) {
+    if (offset + encoded.size > size) {
+      return;
+    }
+    const bool padded = offset + encoded.bytes.size() <= size;
+    if (padded ? MatchesPadded(data + offset, encoded) : encoded.MatchesAt(data + offset)) {
+      hits.push_back({.offset = offset, .encoding = encoded.encoding});
+    }
+  };
+
+  // Every vector is compared at two neighbouring offsets, which checks the first two bytes of all encodings at once.
+  size_t start = 0;
+  for (; start < count && start + sizeof(__m128i) + 1 <= size; start += sizeof(__m128i)) {
+    const __m128i at = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + start));
+    const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + start + 1));
+    std::array<uint32_t, kEncodings> candidates;
+    uint32_t any = 0;
+    for (size_t e = 0; e < kEncodings; ++e) {
+      const __m128i first_equal = _mm_cmpeq_epi8(_mm_or_si128(at, first_fold[e]), first[e]);
+      const __m128i second_equal = _mm_cmpeq_epi8(_mm_or_si128(next, second_fold[e]), second[e]);
+      candidates[e] = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(first_equal, second_equal)));
+      any |= candidates[e];
+    }
+    for (; any != 0; any &= any - 1) {
+      const auto lane = static_cast<size_t>(std::countr_zero(any));
+      if (start + lane >= count) {
+        break;
+      }
+      for (size_t e = 0; e < kEncodings; ++e) {
+        if ((candidates[e] >> lane & 1) != 0) {
+          verify(start + lane, encodings[e]);
+        }
+      }
+    }
+  }
+  for (; start < count; ++start) {
+    for (const EncodedString& encoded : encodings) {
+      verify(start, encoded);
+    }
+  }
+}
+
+}  // namespace
+
+LaneKernel SelectSse41Kernel(ValueType type, bool range) {
+  return VisitValueType(type, [&]<typename T>() -> LaneKernel {
+    if constexpr (std::is_integral_v<T> && sizeof(T) == 8) {
+      // 64-bit ordered compares need SSE4.2; leave integer ranges of that width to the scalar kernel.
+      return range ? nullptr : &Kernel<T, false>;
+    } else {
+      return range ? &Kernel<T, true> : &Kernel<T, false>;
+    }
+  });
+}
+
+void FindSignatureSse41(const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets) {
+  if (size < signature.size()) {
+    return;
+  }
+  const size_t count = size - signature.size() + 1;
+  // Candidates from here on cannot load the whole padded pattern and are verified byte by byte.
+  const size_t padded_count = size >= signature.padded_size() ? size - signature.padded_size() + 1 : 0;
+  const std::byte* anchors = data + signature.anchor();
+  const __m128i needle = _mm_set1_epi8(static_cast<char>(signature.anchor_byte()));
+  const auto verify = [&](size_t offset) {
+    if (offset < padded_count ? MatchesPadded(data + offset, signature) : signature.MatchesAt(data + offset)) {
+      offsets.push_back(offset);
+    }
+  };
+
+  // Four vectors per step, checked for any anchor at all with a single branch, as memchr does.
+  constexpr size_t kStep = 4 * sizeof(__m128i);
+  size_t start = 0;
+  const auto scan_vector = [&](size_t at, __m128i equal) {
+    for (auto hits = static_cast<uint32_t>(_mm_movemask_epi8(equal)); hits != 0; hits &= hits - 1) {
+      verify(at + static_cast<size_t>(std::countr_zero(hits)));
+    }
+  };
+  for (; start + kStep <= count; start += kStep) {
+    const auto* vectors = reinterpret_cast<const __m128i*>(anchors + start);
+    const __m128i equal0 = _mm_cmpeq_epi8(_mm_loadu_si128(vectors), needle);
+    const __m128i equal1 = _mm_cmpeq_epi8(_mm_loadu_si128(vectors + 1), needle);
+    const __m128i equal2 = _mm_cmpeq_epi8(_mm_loadu_si128(vectors + 2), needle);
+    const __m128i equal3 = _mm_cmpeq_epi8(_mm_loadu_si128(vectors + 3), needle);
+    const __m128i any = _mm_or_si128(_mm_or_si128(equal0, equal1), _mm_or_si128(equal2, equal3));
+    if (_mm_testz_si128(any, any)) {
+      continue;
+    }
+    scan_vector(start, equal0);
+    scan_vector(start + sizeof(__m128i), equal1);
+    scan_vector(start + 2 * sizeof(__m128i), equal2);
+    scan_vector(start + 3 * sizeof(__m128i), equal3);
+  }
+  for (; start + sizeof(__m128i) <= count; start += sizeof(__m128i)) {
+    scan_vector(start, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(anchors + start)), needle));
+  }
+  for (; start < count; ++start) {
+    if (anchors[start] == signature.anchor_byte()) {
+      verify(start);
+    }
+  }
+}
+
+void FindStringSse41(
+    const std::byte* data, size_t size, size_t limit, const StringPattern& pattern, std::vector<StringHit>& hits) {
+  const auto encodings = pattern.encodings();
+  if (encodings.size() == 2) {
+    FindEncodedStrings<2>(data, size, limit, encodings, hits);
+  } else {
+    FindEncodedStrings<1>(data, size, limit, encodings, hits);
+  }
+}
+
+}  // namespace maia::detail
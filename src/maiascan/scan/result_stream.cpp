@@ -0,0 +1,56 @@
+#include "maiascan/scan/result_stream.hpp"
+
+#include <utility>
+
+namespace maia {
+
+bool ResultStream::Pop(CandidateBlock& block) {
+  std::unique_lock lock(mutex_);
+  not_empty_.wait(lock, [this] { return !blocks_.empty() || ended_ || closed_; });
+  if (blocks_.empty()) {
+    return false;
+  }
+  block = blocks_.front();
+  blocks_.pop_front();
+  not_full_.notify_one();
+  return true;
+}
+
+void ResultStream::Close() {
+  {
+    std::lock_guard lock(mutex_);
+    closed_ = true;
+    blocks_.clear();
+  }
+  not_full_.notify_all();
+  not_empty_.notify_all();
+}
+
+void ResultStream::Begin(std::shared_ptr<Arena> arena, size_t stride) {
+  std::lock_guard lock(mutex_);
+  arena_ = std::move(arena);
+  stride_ = stride;
+}
+
+void ResultStream::Push(const CandidateBlock& block) {
+  if (block.empty()) {
+    return;
+  }
+  std::unique_lock lock(mutex_);
+  not_full_.wait(lock, [this] { return blocks_.size() < capacity_ || closed_; });
+  if (closed_) {
+    return;
+  }
+  blocks_.push_back(block);
+  not_empty_.notify_one();
+}
+
+void ResultStream::End() {
+  {
+    std::lock_guard lock(mutex_);
+    ended_ = true;
+  }
+  not_empty_.notify_all();
+}
+
+}  // namespace maia
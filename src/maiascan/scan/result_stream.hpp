@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "maiascan/core/arena.hpp"
+#include "maiascan/scan/candidates.hpp"
+
+namespace maia {
+
+// Receives the candidate blocks of a scan as each shard completes, for callers that consume results incrementally
+// instead of waiting for the ScanResult. Push() is called concurrently by the scan workers, in completion order rather
+// than address order, and only for non-empty blocks; the blocks live in `arena`, so a sink that keeps `arena` can keep
+// them without copying. Begin() and End() are called on the thread running the scan. One sink serves one scan at a
+// time.
+class ResultSink {
+ public:
+  virtual ~ResultSink() = default;
+
+  virtual void Begin(std::shared_ptr<Arena> arena, size_t stride) = 0;
+  virtual void Push(const CandidateBlock& block) = 0;
+  virtual void End() = 0;
+};
+
+// Hands the candidate blocks of a running scan to a consumer as soon as each shard is done, so that a scan matching
+// hundreds of millions of addresses shows its first results right away. Blocks arrive in completion order, not in
+// address order.
+//
+// The queue is bounded: a worker that finds it full waits for the consumer, so blocks cannot pile up behind a slow
+// consumer. A consumer that has seen enough calls Close(), after which blocks are dropped and the scan runs on
+// unhindered. One stream serves one scan.
+class ResultStream final : public ResultSink {
+ public:
+  static constexpr size_t kDefaultCapacity = 256;
+
+  explicit ResultStream(size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+  ResultStream(const ResultStream&) = delete;
+  ResultStream& operator=(const ResultStream&) = delete;
+
+  // Consumer side. Waits for the next non-empty block and returns false once the scan has finished and every block
+  // was delivered. Delivered blocks stay valid for as long as the stream or the result of the scan is alive.
+  bool Pop(CandidateBlock& block);
+
+  // Consumer side. Drops whatever is queued and stops accepting blocks.
+  void Close();
+
+  // Distance between candidate addresses of the blocks; set before the first block is delivered.
+  size_t stride() const { return stride_; }
+
+  // Scanner side.
+  void Begin(std::shared_ptr<Arena> arena, size_t stride) override;
+  void Push(const CandidateBlock& block) override;
+  void End() override;
+
+ private:
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<CandidateBlock> blocks_;
+  // Keeps the storage of delivered blocks alive.
+  std::shared_ptr<Arena> arena_;
+  size_t stride_{};
+  bool closed_{};
+  bool ended_{};
+};
+
+}  // namespace maia
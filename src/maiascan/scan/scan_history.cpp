@@ -0,0 +1,34 @@
+#include "maiascan/scan/scan_history.hpp"
+
+namespace maia {
+
+bool ScanHistory::Record(const ScanResult& result, ThreadPool& pool) {
+  checkpoints_.erase(checkpoints_.begin() + static_cast<ptrdiff_t>(current_ ? *current_ + 1 : checkpoints_.size()),
+                     checkpoints_.end());
+  auto checkpoint = ScanCheckpoint::Capture(result, pool, options_);
+  if (!checkpoint) {
+    current_.reset();
+    return false;
+  }
+  checkpoints_.push_back(std::move(*checkpoint));
+  current_ = checkpoints_.size() - 1;
+  return true;
+}
+
+const ScanCheckpoint* ScanHistory::GoTo(size_t generation) {
+  if (generation >= checkpoints_.size()) {
+    return nullptr;
+  }
+  current_ = generation;
+  return &checkpoints_[generation];
+}
+
+size_t ScanHistory::memory_usage() const {
+  size_t total = checkpoints_.capacity() * sizeof(ScanCheckpoint);
+  for (const auto& checkpoint : checkpoints_) {
+    total += checkpoint.memory_usage();
+  }
+  return total;
+}
+
+}  // namespace maia
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/scan/checkpoint.hpp"
+#include "maiascan/scan/scanner.hpp"
+
+namespace maia {
+
+// Checkpoints of the successive generations of a scan session, for going back to an earlier one when a next scan
+// filtered the wrong way. Generation 0 is the first scan. Recording a generation after going back discards the ones
+// that followed, like the redo steps of an editor.
+class ScanHistory {
+ public:
+  explicit ScanHistory(CheckpointOptions options = {}) : options_(std::move(options)) {}
+
+  // Checkpoints `result` as the generation after the current one. Returns false when the checkpoint exceeded its
+  // memory limit (see CheckpointOptions); the history then ends at the previous generation and current() is empty.
+  bool Record(const ScanResult& result, ThreadPool& pool);
+
+  size_t size() const { return checkpoints_.size(); }
+  const ScanCheckpoint& checkpoint(size_t generation) const { return checkpoints_[generation]; }
+
+  // Generation the session is at: the latest one recorded or gone back to, unless it could not be recorded.
+  std::optional<size_t> current() const { return current_; }
+
+  // Makes `generation` the current one and returns its checkpoint for Scanner::Restore(), or null if there is no such
+  // generation.
+  const ScanCheckpoint* GoTo(size_t generation);
+
+  // Heap held by all checkpoints.
+  size_t memory_usage() const;
+
+ private:
+  CheckpointOptions options_;
+  std::vector<ScanCheckpoint> checkpoints_;
+  std::optional<size_t> current_;
+};
+
+}  // namespace maia
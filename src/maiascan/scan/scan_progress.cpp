@@ -0,0 +1,45 @@
+#include "maiascan/scan/scan_progress.hpp"
+
+#include <algorithm>
+
+namespace maia {
+
+namespace {
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+double ScanProgressSample::fraction() const {
+  return bytes_total == 0 ? 0 : std::min(1.0, static_cast<double>(bytes_done) / static_cast<double>(bytes_total));
+}
+
+std::chrono::nanoseconds ScanProgressSample::remaining() const {
+  if (bytes_done == 0 || bytes_done >= bytes_total) {
+    return {};
+  }
+  const double left = static_cast<double>(bytes_total - bytes_done) / static_cast<double>(bytes_done);
+  return std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(elapsed.count()) * left));
+}
+
+void ScanProgress::Begin(size_t shards_total, uint64_t bytes_total) {
+  bytes_done_.store(0, std::memory_order_relaxed);
+  shards_done_.store(0, std::memory_order_relaxed);
+  bytes_total_.store(bytes_total, std::memory_order_relaxed);
+  shards_total_.store(shards_total, std::memory_order_relaxed);
+  start_ns_.store(NowNs(), std::memory_order_relaxed);
+}
+
+ScanProgressSample ScanProgress::Sample() const {
+  const int64_t start_ns = start_ns_.load(std::memory_order_relaxed);
+  return {.bytes_done = bytes_done_.load(std::memory_order_relaxed),
+          .bytes_total = bytes_total_.load(std::memory_order_relaxed),
+          .shards_done = shards_done_.load(std::memory_order_relaxed),
+          .shards_total = shards_total_.load(std::memory_order_relaxed),
+          .elapsed = std::chrono::nanoseconds(start_ns == 0 ? 0 : NowNs() - start_ns)};
+}
+
+}  // namespace maia
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace maia {
+
+// A consistent-enough reading of a ScanProgress. Counters are sampled one by one, so `bytes_done` and `shards_done`
+// may be a shard apart.
+struct ScanProgressSample {
+  uint64_t bytes_done{};
+  uint64_t bytes_total{};
+  size_t shards_done{};
+  size_t shards_total{};
+  std::chrono::nanoseconds elapsed{};
+
+  // Fraction of the bytes done, in [0, 1].
+  double fraction() const;
+  // Time left at the rate so far, zero until the first shard is done.
+  std::chrono::nanoseconds remaining() const;
+};
+
+// Progress and cancellation of scans. The workers of a scan update the counters with relaxed atomics after every
+// shard and any other thread samples them, so reporting never takes a lock nor slows the scan. Cancel() makes the scan
+// running on it, and every later scan given the same progress, skip the shards they have not started yet and return
+// what they found so far with ScanStats::cancelled set.
+class ScanProgress {
+ public:
+  // Called by the scanner when a scan of `shards_total` shards over `bytes_total` bytes starts.
+  void Begin(size_t shards_total, uint64_t bytes_total);
+  // Called by the scanner for every finished or skipped shard.
+  void Advance(uint64_t bytes) {
+    bytes_done_.fetch_add(bytes, std::memory_order_relaxed);
+    shards_done_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+  ScanProgressSample Sample() const;
+
+ private:
+  std::atomic<uint64_t> bytes_done_{};
+  std::atomic<uint64_t> bytes_total_{};
+  std::atomic<size_t> shards_done_{};
+  std::atomic<size_t> shards_total_{};
+  // steady_clock time of Begin() in nanoseconds.
+  std::atomic<int64_t> start_ns_{};
+  std::atomic<bool> cancelled_{};
+};
+
+}  // namespace maia
@@ -0,0 +1,736 @@
+#include "maiascan/scan/scanner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+#include "maiascan/core/bits.hpp"
+#include "maiascan/core/perf.hpp"
+#include "maiascan/scan/checkpoint.hpp"
+#include "maiascan/scan/kernels_internal.hpp"
+
+namespace maia {
+
+namespace {
+
+size_t EffectiveStride(ValueType type, const ScanOptions& options) {
+  return options.alignment == 0 ? SizeOf(type) : options.alignment;
+}
+
+// Shards must start on a stride boundary so that every shard sees the same candidate grid as its region, which holds for
+// the power-of-two strides of IsValidAlignment().
+size_t EffectiveShardSize(const ScanOptions& options, size_t stride) {
+  return std::max(std::bit_ceil(options.shard_size), std::bit_ceil(stride));
+}
+
+// Number of candidate slots of a shard whose values fit entirely inside the `available` bytes read from it.
+size_t SlotCount(const Shard& shard, size_t available, size_t stride, size_t value_size) {
+  if (available < value_size) {
+    return 0;
+  }
+  return (std::min(shard.size, available - value_size + 1) + stride - 1) / stride;
+}
+
+// Adds the size of a finished scan to the line of its phase.
+ScanResult FinishPhase(PerfPhase& phase, ScanResult result) {
+  phase.Set("candidates", result.candidates.count());
+  phase.Set("truncated", result.stats.truncated);
+  return result;
+}
+
+// Runs `fn(index, worker)` for every shard like ThreadPool::ParallelFor() and reports each one, finished or skipped,
+// to `progress` with the `bytes_of(index)` it covers.
+template <typename BytesOf, typename Fn>
+void ParallelForShards(ThreadPool& pool, ScanProgress& progress, size_t count, BytesOf&& bytes_of, Fn&& fn) {
+  uint64_t bytes_total = 0;
+  for (size_t index = 0; index < count; ++index) {
+    bytes_total += bytes_of(index);
+  }
+  progress.Begin(count, bytes_total);
+  pool.ParallelFor(count, [&](size_t index, size_t worker) {
+    fn(index, worker);
+    progress.Advance(bytes_of(index));
+  });
+}
+
+// Per-scan state shared by the workers. Every block index is written by exactly one worker.
+class ScanContext {
+ public:
+  ScanContext(const ScanOptions& options,
+              const ScanProgress& progress,
+              const MemoryReader& reader,
+              std::shared_ptr<Arena> arena,
+              ResultSink* sink,
+              size_t worker_count,
+              size_t block_count,
+              ValueType type,
+              size_t stride)
+      : progress_(progress),
+        reader_(reader),
+        reads_at_start_(reader.stats()),
+        arena_(std::move(arena)),
+        sink_(sink),
+        max_results_(options.max_results),
+        bits_(worker_count),
+        pages_(worker_count),
+        blocks_(block_count),
+        values_(block_count),
+        type_(type),
+        value_size_(SizeOf(type)),
+        stride_(stride) {
+    if (!options.snapshot_dir.empty()) {
+      snapshot_ = Snapshot::Create(options.snapshot_dir, worker_count);
+    }
+    if (sink_ != nullptr) {
+      sink_->Begin(arena_, stride);
+    }
+  }
+
+  // Storage for the candidate blocks of this scan.
+  Arena& arena() { return *arena_; }
+
+  // Whether the next block should be skipped because the scan was cancelled or enough candidates were found. Skipping
+  // is recorded as cancellation or truncation.
+  bool Skip() {
+    if (progress_.cancelled()) {
+      cancelled_.store(true, std::memory_order_relaxed);
+      return true;
+    }
+    if (max_results_ == 0 || found_.load(std::memory_order_relaxed) < max_results_) {
+      return false;
+    }
+    truncated_.store(true, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Zeroed match bitmap of the worker with room for `slot_count` slots.
+  uint64_t* Bits(size_t worker, size_t slot_count) {
+    auto& bits = bits_[worker];
+    bits.assign(WordCount(slot_count), 0);
+    return bits.data();
+  }
+
+  // Zeroed page selection of the worker for MemoryReader::ReadPages() over `size` bytes.
+  uint64_t* Pages(size_t worker, size_t size) {
+    auto& pages = pages_[worker];
+    pages.assign(WordCount((size + kPageSize - 1) / kPageSize), 0);
+    return pages.data();
+  }
+
+  // Stores the result for block `index` and records the current values of its candidates from `data`, which holds the
+  // memory starting at the block base.
+  void Publish(size_t worker, size_t index, CandidateBlock block, const std::byte* data) {
+    if (snapshot_ && !block.empty()) {
+      auto storage = snapshot_->Allocate(worker, block.count() * value_size_);
+      if (!storage.empty()) {
+        if (block.encoding() == CandidateBlock::Encoding::kAll && stride_ == value_size_) {
+          std::memcpy(storage.data(), data, storage.size());
+        } else {
+          std::byte* out = storage.data();
+          block.ForEachSlot([&](size_t slot) {
+            std::memcpy(out, data + slot * stride_, value_size_);
+            out += value_size_;
+          });
+        }
+        values_[index] = storage;
+      }
+    }
+    found_.fetch_add(block.count(), std::memory_order_relaxed);
+    if (sink_ != nullptr && !block.empty()) {
+      sink_->Push(block);
+    }
+    blocks_[index] = std::move(block);
+  }
+
+  ScanResult Finish(ScanStats stats) {
+    ScopedPerfTimer timer(PerfCounter::kMergeNs);
+    ScanResult result;
+    result.candidates.type = type_;
+    result.candidates.stride = stride_;
+    result.candidates.arena = std::move(arena_);
+    std::vector<std::span<const std::byte>> values;
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      if (!blocks_[i].empty()) {
+        result.candidates.blocks.push_back(std::move(blocks_[i]));
+        values.push_back(values_[i]);
+      }
+    }
+    if (snapshot_ && !snapshot_->failed()) {
+      snapshot_->SetBlocks(std::move(values));
+      result.snapshot = std::move(snapshot_);
+    }
+    const ReadStats reads = reader_.stats();
+    stats.bytes_scanned = reads.bytes - reads_at_start_.bytes;
+    stats.read_calls = reads.calls - reads_at_start_.calls;
+    stats.bytes_mapped = reads.mapped_bytes - reads_at_start_.mapped_bytes;
+    stats.truncated = truncated_.load(std::memory_order_relaxed);
+    stats.cancelled = cancelled_.load(std::memory_order_relaxed);
+    result.stats = stats;
+    if (sink_ != nullptr) {
+      sink_->End();
+    }
+    return result;
+  }
+
+ private:
+  const ScanProgress& progress_;
+  const MemoryReader& reader_;
+  ReadStats reads_at_start_;
+  std::shared_ptr<Arena> arena_;
+  ResultSink* sink_;
+  size_t max_results_;
+  std::atomic<size_t> found_{};
+  std::atomic<bool> truncated_{};
+  std::atomic<bool> cancelled_{};
+  std::vector<std::vector<uint64_t>> bits_;
+  std::vector<std::vector<uint64_t>> pages_;
+  std::vector<CandidateBlock> blocks_;
+  std::vector<std::span<const std::byte>> values_;
+  std::optional<Snapshot> snapshot_;
+  ValueType type_;
+  size_t value_size_;
+  size_t stride_;
+};
+
+// Whether the value at `offset` lies entirely on pages that a sparse read selected and could read.
+bool IsPageRead(const uint64_t* pages, size_t offset, size_t value_size) {
+  return TestBit(pages, offset / kPageSize) && TestBit(pages, (offset + value_size - 1) / kPageSize);
+}
+
+// Selects the pages holding the candidates of `block`.
+void SelectCandidatePages(const CandidateBlock& block, size_t stride, size_t value_size, uint64_t* pages) {
+  block.ForEachSlot([&](size_t slot) {
+    const size_t offset = slot * stride;
+    SetBit(pages, offset / kPageSize);
+    SetBit(pages, (offset + value_size - 1) / kPageSize);
+  });
+}
+
+// Invokes `fn.template operator()<kValue>()` with `value` as a compile-time constant.
+template <typename Fn>
+decltype(auto) VisitBool(bool value, Fn&& fn) {
+  return value ? fn.template operator()<true>() : fn.template operator()<false>();
+}
+
+// Invokes `fn.template operator()<kOp>()` for one of the snapshot comparisons; does nothing for kMatch.
+template <typename Fn>
+void VisitComparison(NextScanOp op, Fn&& fn) {
+  switch (op) {
+    case NextScanOp::kChanged:
+      return fn.template operator()<NextScanOp::kChanged>();
+    case NextScanOp::kUnchanged:
+      return fn.template operator()<NextScanOp::kUnchanged>();
+    case NextScanOp::kIncreased:
+      return fn.template operator()<NextScanOp::kIncreased>();
+    case NextScanOp::kDecreased:
+      return fn.template operator()<NextScanOp::kDecreased>();
+    case NextScanOp::kMatch:
+      break;
+  }
+}
+
+template <typename T, NextScanOp kOp>
+bool Compare(const std::byte* current, const std::byte* previous) {
+  if constexpr (kOp == NextScanOp::kChanged) {
+    return std::memcmp(current, previous, sizeof(T)) != 0;
+  } else if constexpr (kOp == NextScanOp::kUnchanged) {
+    return std::memcmp(current, previous, sizeof(T)) == 0;
+  } else if constexpr (kOp == NextScanOp::kIncreased) {
+    return detail::LoadAs<T>(current) > detail::LoadAs<T>(previous);
+  } else {
+    static_assert(kOp == NextScanOp::kDecreased);
+    return detail::LoadAs<T>(current) < detail::LoadAs<T>(previous);
+  }
+}
+
+// The per-candidate loops below are instantiated for every value type and comparison and picked once per block, so
+// the loop bodies only load, compare and set a bit. Values on pages a sparse read could not fetch are evaluated too,
+// on whatever the buffer holds there, and masked off afterwards rather than branched around.
+
+// Evaluates `predicate` only at the candidate slots of `block`, for blocks too sparse to be worth a full kernel pass.
+// `pages` is the page selection of the sparse read.
+template <typename T, bool kRange>
+void MatchSparse(const CandidateBlock& block,
+                 const std::byte* data,
+                 const uint64_t* pages,
+                 size_t slot_count,
+                 size_t stride,
+                 const MatchPredicate& predicate,
+                 uint64_t* bits) {
+  const T lower = detail::LoadAs<T>(predicate.lower);
+  const T upper = detail::LoadAs<T>(predicate.upper);
+  block.ForEachSlot([&](size_t slot) {
+    if (slot >= slot_count) {
+      return false;
+    }
+    const size_t offset = slot * stride;
+    bool keep = detail::Matches<T, kRange>(detail::LoadAs<T>(data + offset), lower, upper);
+    keep &= IsPageRead(pages, offset, sizeof(T));
+    bits[slot / 64] |= uint64_t{keep} << (slot % 64);
+    return true;
+  });
+}
+
+// Compares every candidate of `block` with its value in the previous snapshot. `pages` is the page selection of a
+// sparse read and only consulted when `kPaged`.
+template <typename T, NextScanOp kOp, bool kPaged>
+void CompareWithSnapshot(const CandidateBlock& block,
+                         const std::byte* data,
+                         const uint64_t* pages,
+                         size_t slot_count,
+                         size_t stride,
+                         std::span<const std::byte> previous,
+                         uint64_t* bits) {
+  const std::byte* previous_value = previous.data();
+  block.ForEachSlot([&](size_t slot) {
+    if (slot >= slot_count) {
+      return false;
+    }
+    const size_t offset = slot * stride;
+    bool keep = Compare<T, kOp>(data + offset, previous_value);
+    if constexpr (kPaged) {
+      keep &= IsPageRead(pages, offset, sizeof(T));
+    }
+    bits[slot / 64] |= uint64_t{keep} << (slot % 64);
+    previous_value += sizeof(T);
+    return true;
+  });
+}
+
+}  // namespace
+
+std::vector<Shard> SplitIntoShards(std::span<const MemoryRegion> regions, size_t shard_size, size_t value_size) {
+  std::vector<Shard> shards;
+  for (const auto& region : regions) {
+    for (uintptr_t base = region.base; base < region.end(); base += shard_size) {
+      const size_t size = std::min<size_t>(shard_size, region.end() - base);
+      const size_t read_size = std::min<size_t>(size + value_size - 1, region.end() - base);
+      shards.push_back({.base = base, .size = size, .read_size = read_size});
+    }
+  }
+  return shards;
+}
+
+void ReadAheadNextShard(MemoryReader& reader, const ThreadPool& pool, std::span<const Shard> shards, size_t worker) {
+  size_t next = 0;
+  if (reader.read_ahead() && pool.PeekNext(worker, next)) {
+    reader.ReadAhead(worker, shards[next].base, shards[next].read_size);
+  }
+}
+
+Scanner::Scanner(const Process& process, ThreadPool& pool, ScanOptions options)
+    : process_(process),
+      pool_(pool),
+      reader_(process, pool.size(), options.read_mode, options.read_ahead, WorkerPlacements(pool, options.large_pages)),
+      region_cache_(process),
+      arenas_(pool.size(),
+              options.chunk_allocator == nullptr && options.large_pages ? &LargePageChunkAllocator()
+                                                                        : options.chunk_allocator),
+      options_(std::move(options)) {}
+
+std::vector<MemoryRegion> Scanner::QueryScanRegions() {
+  if (!IsValidAlignment(options_.alignment)) {
+    return {};
+  }
+  return PrepareScanRegions(region_cache_.Refresh());
+}
+
+std::vector<MemoryRegion> Scanner::PrepareScanRegions(const std::vector<MemoryRegion>& regions) {
+  reader_.PrepareRegions(regions);
+  return CoalesceRegions(regions);
+}
+
+ScanResult Scanner::FirstScan(const MatchPredicate& predicate, ResultSink* sink) {
+  PerfPhase phase("first_scan", &pool_);
+  const size_t value_size = SizeOf(predicate.type);
+  const size_t stride = EffectiveStride(predicate.type, options_);
+  const auto regions = QueryScanRegions();
+  const auto shards = SplitIntoShards(regions, EffectiveShardSize(options_, stride), value_size);
+
+  ScanContext context(
+      options_, *progress_, reader_, arenas_.Acquire(), sink, pool_.size(), shards.size(), predicate.type, stride);
+  const auto shard_bytes = [&](size_t index) { return shards[index].read_size; };
+  ParallelForShards(pool_, *progress_, shards.size(), shard_bytes, [&](size_t index, size_t worker) {
+    if (context.Skip()) {
+      return;
+    }
+    const Shard& shard = shards[index];
+    const auto data = reader_.Read(worker, shard.base, shard.read_size);
+    ReadAheadNextShard(reader_, pool_, shards, worker);
+    const size_t slot_count = SlotCount(shard, data.size(), stride, value_size);
+    if (slot_count == 0) {
+      return;
+    }
+    uint64_t* bits = context.Bits(worker, slot_count);
+    {
+      ScopedPerfTimer timer(PerfCounter::kKernelNs);
+      FindMatches(data.data(), slot_count, stride, predicate, bits);
+    }
+    auto block = CandidateBlock::FromBits(shard.base, static_cast<uint32_t>(slot_count), bits, context.arena(), worker);
+    context.Publish(worker, index, std::move(block), data.data());
+  });
+  reader_.DropReadAhead();
+  return FinishPhase(phase,
+                     context.Finish({.regions = regions.size(),
+                                     .shards = shards.size(),
+                                     .region_queries = region_cache_.stats().query_calls}));
+}
+
+ScanResult Scanner::GroupScan(const GroupPattern& pattern, ResultSink* sink) {
+  PerfPhase phase("group_scan", &pool_);
+  phase.Set("fields", pattern.fields().size());
+  const ValueType type = pattern.first().type;
+  const size_t stride = EffectiveStride(type, options_);
+  const auto regions = QueryScanRegions();
+  // Shards overlap by the whole group, so that every group starting inside a shard is checked by it.
+  const auto shards = SplitIntoShards(regions, EffectiveShardSize(options_, stride), pattern.size());
+
+  ScanContext context(
+      options_, *progress_, reader_, arenas_.Acquire(), sink, pool_.size(), shards.size(), type, stride);
+  const auto shard_bytes = [&](size_t index) { return shards[index].read_size; };
+  ParallelForShards(pool_, *progress_, shards.size(), shard_bytes, [&](size_t index, size_t worker) {
+    if (context.Skip()) {
+      return;
+    }
+    const Shard& shard = shards[index];
+    const auto data = reader_.Read(worker, shard.base, shard.read_size);
+    ReadAheadNextShard(reader_, pool_, shards, worker);
+    const size_t slot_count = SlotCount(shard, data.size(), stride, pattern.size());
+    if (slot_count == 0) {
+      return;
+    }
+    uint64_t* bits = context.Bits(worker, slot_count);
+    {
+      ScopedPerfTimer timer(PerfCounter::kKernelNs);
+      FindGroupMatches(data.data(), slot_count, stride, pattern, bits);
+    }
+    auto block = CandidateBlock::FromBits(shard.base, static_cast<uint32_t>(slot_count), bits, context.arena(), worker);
+    context.Publish(worker, index, std::move(block), data.data());
+  });
+  reader_.DropReadAhead();
+  return FinishPhase(phase,
+                     context.Finish({.regions = regions.size(),
+                                     .shards = shards.size(),
+                                     .region_queries = region_cache_.stats().query_calls}));
+}
+
+ScanResult Scanner::UnknownScan(ValueType type, ResultSink* sink) {
+  PerfPhase phase("unknown_scan", &pool_);
+  const size_t value_size = SizeOf(type);
+  const size_t stride = EffectiveStride(type, options_);
+  const auto regions = QueryScanRegions();
+  const auto shards = SplitIntoShards(regions, EffectiveShardSize(options_, stride), value_size);
+
+  ScanContext context(
+      options_, *progress_, reader_, arenas_.Acquire(), sink, pool_.size(), shards.size(), type, stride);
+  if (options_.snapshot_dir.empty()) {
+    // Without a baseline there is nothing to read; every slot that fits in its region is a candidate.
+    for (size_t index = 0; index < shards.size() && !context.Skip(); ++index) {
+      const size_t slot_count = SlotCount(shards[index], shards[index].read_size, stride, value_size);
+      context.Publish(0, index, CandidateBlock::All(shards[index].base, static_cast<uint32_t>(slot_count)), nullptr);
+    }
+  } else {
+    const auto shard_bytes = [&](size_t index) { return shards[index].read_size; };
+    ParallelForShards(pool_, *progress_, shards.size(), shard_bytes, [&](size_t index, size_t worker) {
+      if (context.Skip()) {
+        return;
+      }
+      const Shard& shard = shards[index];
+      const auto data = reader_.Read(worker, shard.base, shard.read_size);
+      ReadAheadNextShard(reader_, pool_, shards, worker);
+      const size_t slot_count = SlotCount(shard, data.size(), stride, value_size);
+      context.Publish(worker, index, CandidateBlock::All(shard.base, static_cast<uint32_t>(slot_count)), data.data());
+    });
+    reader_.DropReadAhead();
+  }
+  return FinishPhase(phase,
+                     context.Finish({.regions = regions.size(),
+                                     .shards = shards.size(),
+                                     .region_queries = region_cache_.stats().query_calls}));
+}
+
+ScanResult Scanner::NextScan(const ScanResult& previous, const NextScanQuery& query, ResultSink* sink) {
+  PerfPhase phase("next_scan", &pool_);
+  const CandidateSet& candidates = previous.candidates;
+  const ValueType type = candidates.type;
+  const size_t value_size = SizeOf(type);
+  const size_t stride = candidates.stride;
+  const size_t block_count = candidates.blocks.size();
+  ScanContext context(
+      options_, *progress_, reader_, arenas_.Acquire(), sink, pool_.size(), block_count, type, stride);
+  if (query.op != NextScanOp::kMatch && !previous.snapshot) {
+    return FinishPhase(phase, context.Finish({}));
+  }
+  region_cache_.Refresh();
+  const auto read_size_of = [&](const CandidateBlock& block) { return (block.slot_count() - 1) * stride + value_size; };
+
+  const auto block_bytes = [&](size_t index) { return read_size_of(candidates.blocks[index]); };
+  ParallelForShards(pool_, *progress_, block_count, block_bytes, [&](size_t index, size_t worker) {
+    if (context.Skip()) {
+      return;
+    }
+    const CandidateBlock& block = candidates.blocks[index];
+    const size_t read_size = read_size_of(block);
+    // Blocks in memory that was released since the previous scan are dropped without a read.
+    if (!region_cache_.Overlaps(block.base(), read_size)) {
+      return;
+    }
+    const bool sparse = block.encoding() == CandidateBlock::Encoding::kDeltas;
+
+    // Sparse blocks only fetch the pages their candidates live on.
+    uint64_t* pages = nullptr;
+    std::span<const std::byte> data;
+    size_t slot_count = block.slot_count();
+    if (sparse) {
+      pages = context.Pages(worker, read_size);
+      SelectCandidatePages(block, stride, value_size, pages);
+      data = reader_.ReadPages(worker, block.base(), read_size, pages);
+    } else {
+      data = reader_.Read(worker, block.base(), read_size);
+      // Slots whose value is no longer fully readable are dropped.
+      slot_count = data.size() < value_size ? 0 : std::min(slot_count, (data.size() - value_size) / stride + 1);
+    }
+    // Only dense blocks are read in one piece, which is what a read-ahead fetches.
+    size_t next_index = 0;
+    if (reader_.read_ahead() && pool_.PeekNext(worker, next_index)) {
+      const CandidateBlock& next = candidates.blocks[next_index];
+      if (next.encoding() != CandidateBlock::Encoding::kDeltas &&
+          region_cache_.Overlaps(next.base(), read_size_of(next))) {
+        reader_.ReadAhead(worker, next.base(), read_size_of(next));
+      }
+    }
+    if (data.empty() || slot_count == 0) {
+      return;
+    }
+    uint64_t* bits = context.Bits(worker, slot_count);
+
+    {
+      ScopedPerfTimer timer(PerfCounter::kKernelNs);
+      if (query.op != NextScanOp::kMatch) {
+        const auto previous_values = previous.snapshot->block_values(index);
+        VisitValueType(type, [&]<typename T>() {
+          VisitComparison(query.op, [&]<NextScanOp kOp>() {
+            VisitBool(sparse, [&]<bool kPaged>() {
+              CompareWithSnapshot<T, kOp, kPaged>(block, data.data(), pages, slot_count, stride, previous_values, bits);
+            });
+          });
+        });
+      } else if (sparse) {
+        VisitValueType(type, [&]<typename T>() {
+          VisitBool(query.predicate.range, [&]<bool kRange>() {
+            MatchSparse<T, kRange>(block, data.data(), pages, slot_count, stride, query.predicate, bits);
+          });
+        });
+      } else {
+        FindMatches(data.data(), slot_count, stride, query.predicate, bits);
+        if (block.encoding() == CandidateBlock::Encoding::kBitmap) {
+          for (size_t i = 0; i < WordCount(slot_count); ++i) {
+            bits[i] &= block.bits()[i];
+          }
+        }
+      }
+    }
+    auto next =
+        CandidateBlock::FromBits(block.base(), static_cast<uint32_t>(slot_count), bits, context.arena(), worker);
+    context.Publish(worker, index, std::move(next), data.data());
+  });
+  reader_.DropReadAhead();
+  return FinishPhase(phase,
+                     context.Finish({.regions = region_cache_.regions().size(),
+                                     .shards = block_count,
+                                     .region_queries = region_cache_.stats().query_calls}));
+}
+
+ScanResult Scanner::Restore(const ScanCheckpoint& checkpoint) {
+  return checkpoint.Restore(pool_, arenas_.Acquire(), options_.snapshot_dir);
+}
+
+std::vector<MemoryRegion> Scanner::QuerySignatureRegions(const SignatureScanOptions& signature_options) {
+  std::vector<MemoryRegion> selected;
+  for (MemoryRegion region : region_cache_.Refresh()) {
+    const uintptr_t begin = std::max(region.base, signature_options.begin);
+    const uintptr_t end = std::min(region.end(), signature_options.end);
+    if (begin >= end || (signature_options.code_only && !IsExecutableImage(region))) {
+      continue;
+    }
+    region.base = begin;
+    region.size = end - begin;
+    selected.push_back(region);
+  }
+  return PrepareScanRegions(selected);
+}
+
+SignatureScanResult Scanner::SignatureScan(const Signature& signature, const SignatureScanOptions& signature_options) {
+  PerfPhase phase("signature_scan", &pool_);
+  const auto regions = QuerySignatureRegions(signature_options);
+  const auto shards = SplitIntoShards(regions, std::bit_ceil(options_.shard_size), signature.size());
+
+  const ReadStats reads_at_start = reader_.stats();
+  std::vector<std::vector<uintptr_t>> matches(shards.size());
+  std::vector<std::vector<size_t>> offsets(pool_.size());
+  std::atomic<size_t> found{0};
+  std::atomic<bool> truncated{false};
+  std::atomic<bool> cancelled{false};
+  const auto shard_bytes = [&](size_t index) { return shards[index].read_size; };
+  ParallelForShards(pool_, *progress_, shards.size(), shard_bytes, [&](size_t index, size_t worker) {
+    if (progress_->cancelled()) {
+      cancelled.store(true, std::memory_order_relaxed);
+      return;
+    }
+    if (options_.max_results != 0 && found.load(std::memory_order_relaxed) >= options_.max_results) {
+      truncated.store(true, std::memory_order_relaxed);
+      return;
+    }
+    const Shard& shard = shards[index];
+    const auto data = reader_.Read(worker, shard.base, shard.read_size);
+    ReadAheadNextShard(reader_, pool_, shards, worker);
+    // The read overlaps the next shard by one byte less than the signature, so every match starts inside this shard.
+    auto& shard_offsets = offsets[worker];
+    shard_offsets.clear();
+    {
+      ScopedPerfTimer timer(PerfCounter::kKernelNs);
+      FindSignature(data.data(), data.size(), signature, shard_offsets);
+    }
+    if (shard_offsets.empty()) {
+      return;
+    }
+    matches[index].reserve(shard_offsets.size());
+    for (const size_t offset : shard_offsets) {
+      matches[index].push_back(shard.base + offset);
+    }
+    found.fetch_add(shard_offsets.size(), std::memory_order_relaxed);
+  });
+  reader_.DropReadAhead();
+
+  SignatureScanResult result;
+  ScopedPerfTimer merge_timer(PerfCounter::kMergeNs);
+  for (const auto& shard_matches : matches) {
+    result.addresses.insert(result.addresses.end(), shard_matches.begin(), shard_matches.end());
+  }
+  const ReadStats reads = reader_.stats();
+  result.stats = {.regions = regions.size(),
+                  .shards = shards.size(),
+                  .bytes_scanned = reads.bytes - reads_at_start.bytes,
+                  .read_calls = reads.calls - reads_at_start.calls,
+                  .bytes_mapped = reads.mapped_bytes - reads_at_start.mapped_bytes,
+                  .truncated = truncated.load(std::memory_order_relaxed),
+                  .cancelled = cancelled.load(std::memory_order_relaxed),
+                  .region_queries = region_cache_.stats().query_calls};
+  phase.Set("matches", result.addresses.size());
+  return result;
+}
+
+SignatureSetScanResult Scanner::SignatureScan(const SignatureSet& signatures,
+                                              const SignatureScanOptions& signature_options) {
+  PerfPhase phase("signature_set_scan", &pool_);
+  phase.Set("signatures", signatures.size());
+  const auto regions = QuerySignatureRegions(signature_options);
+  const auto shards =
+      SplitIntoShards(regions, std::bit_ceil(options_.shard_size), std::max<size_t>(signatures.max_size(), 1));
+
+  const ReadStats reads_at_start = reader_.stats();
+  std::vector<std::vector<SignatureMatch>> matches(shards.size());
+  std::atomic<size_t> found{0};
+  std::atomic<bool> truncated{false};
+  std::atomic<bool> cancelled{false};
+  const auto shard_bytes = [&](size_t index) { return shards[index].read_size; };
+  ParallelForShards(pool_, *progress_, shards.size(), shard_bytes, [&](size_t index, size_t worker) {
+    if (progress_->cancelled()) {
+      cancelled.store(true, std::memory_order_relaxed);
+      return;
+    }
+    if (options_.max_results != 0 && found.load(std::memory_order_relaxed) >= options_.max_results) {
+      truncated.store(true, std::memory_order_relaxed);
+      return;
+    }
+    const Shard& shard = shards[index];
+    const auto data = reader_.Read(worker, shard.base, shard.read_size);
+    ReadAheadNextShard(reader_, pool_, shards, worker);
+    {
+      ScopedPerfTimer timer(PerfCounter::kKernelNs);
+      signatures.Find(data.data(), data.size(), shard.size, matches[index]);
+    }
+    found.fetch_add(matches[index].size(), std::memory_order_relaxed);
+  });
+  reader_.DropReadAhead();
+
+  SignatureSetScanResult result;
+  ScopedPerfTimer merge_timer(PerfCounter::kMergeNs);
+  result.addresses.resize(signatures.size());
+  for (size_t index = 0; index < shards.size(); ++index) {
+    for (const SignatureMatch& match : matches[index]) {
+      result.addresses[match.signature].push_back(shards[index].base + match.offset);
+    }
+  }
+  const ReadStats reads = reader_.stats();
+  result.stats = {.regions = regions.size(),
+                  .shards = shards.size(),
+                  .bytes_scanned = reads.bytes - reads_at_start.bytes,
+                  .read_calls = reads.calls - reads_at_start.calls,
+                  .bytes_mapped = reads.mapped_bytes - reads_at_start.mapped_bytes,
+                  .truncated = truncated.load(std::memory_order_relaxed),
+                  .cancelled = cancelled.load(std::memory_order_relaxed),
+                  .region_queries = region_cache_.stats().query_calls};
+  size_t match_count = 0;
+  for (const auto& addresses : result.addresses) {
+    match_count += addresses.size();
+  }
+  phase.Set("matches", match_count);
+  return result;
+}
+
+StringScanResult Scanner::StringScan(const StringPattern& pattern, const SignatureScanOptions& signature_options) {
+  PerfPhase phase("string_scan", &pool_);
+  phase.Set("encodings", pattern.encodings().size());
+  const auto regions = QuerySignatureRegions(signature_options);
+  const auto shards = SplitIntoShards(regions, std::bit_ceil(options_.shard_size), pattern.max_size());
+
+  const ReadStats reads_at_start = reader_.stats();
+  std::vector<std::vector<StringHit>> hits(shards.size());
+  std::atomic<size_t> found{0};
+  std::atomic<bool> truncated{false};
+  std::atomic<bool> cancelled{false};
+  const auto shard_bytes = [&](size_t index) { return shards[index].read_size; };
+  ParallelForShards(pool_, *progress_, shards.size(), shard_bytes, [&](size_t index, size_t worker) {
+    if (progress_->cancelled()) {
+      cancelled.store(true, std::memory_order_relaxed);
+      return;
+    }
+    if (options_.max_results != 0 && found.load(std::memory_order_relaxed) >= options_.max_results) {
+      truncated.store(true, std::memory_order_relaxed);
+      return;
+    }
+    const Shard& shard = shards[index];
+    const auto data = reader_.Read(worker, shard.base, shard.read_size);
+    ReadAheadNextShard(reader_, pool_, shards, worker);
+    {
+      ScopedPerfTimer timer(PerfCounter::kKernelNs);
+      FindString(data.data(), data.size(), shard.size, pattern, hits[index]);
+    }
+    found.fetch_add(hits[index].size(), std::memory_order_relaxed);
+  });
+  reader_.DropReadAhead();
+
+  StringScanResult result;
+  ScopedPerfTimer merge_timer(PerfCounter::kMergeNs);
+  for (size_t index = 0; index < shards.size(); ++index) {
+    for (const StringHit& hit : hits[index]) {
+      result.matches.push_back({.address = shards[index].base + hit.offset, .encoding = hit.encoding});
+    }
+  }
+  const ReadStats reads = reader_.stats();
+  result.stats = {.regions = regions.size(),
+                  .shards = shards.size(),
+                  .bytes_scanned = reads.bytes - reads_at_start.bytes,
+                  .read_calls = reads.calls - reads_at_start.calls,
+                  .bytes_mapped = reads.mapped_bytes - reads_at_start.mapped_bytes,
+                  .truncated = truncated.load(std::memory_order_relaxed),
+                  .cancelled = cancelled.load(std::memory_order_relaxed),
+                  .region_queries = region_cache_.stats().query_calls};
+  phase.Set("matches", result.matches.size());
+  return result;
+}
+
+}  // namespace maia
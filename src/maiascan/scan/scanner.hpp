@@ -0,0 +1,219 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/arena.hpp"
+#include "maiascan/core/memory_reader.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/core/region_cache.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/scan/candidates.hpp"
+#include "maiascan/scan/group_pattern.hpp"
+#include "maiascan/scan/kernels.hpp"
+#include "maiascan/scan/result_stream.hpp"
+#include "maiascan/scan/scan_progress.hpp"
+#include "maiascan/scan/signature.hpp"
+#include "maiascan/scan/signature_set.hpp"
+#include "maiascan/scan/snapshot.hpp"
+#include "maiascan/scan/string_pattern.hpp"
+
+namespace maia {
+
+inline constexpr size_t kDefaultShardSize = size_t{1} << 20;
+
+class ScanCheckpoint;
+
+struct ScanOptions {
+  // Distance between candidate addresses, zero or a power of two (see IsValidAlignment()). Zero selects the natural
+  // alignment of the value type.
+  size_t alignment{};
+  // Regions are split into shards of this many bytes, which are the unit of work handed to the thread pool.
+  size_t shard_size{kDefaultShardSize};
+  // How target memory is accessed. Mapped mode falls back to copying for every region that cannot be mapped.
+  ReadMode read_mode{ReadMode::kCopy};
+  // Copy the next shard of every worker on a reader thread while the current one is matched (see
+  // MemoryReader::ReadAhead()). Costs a second buffer and thread per worker and pays off when reads, not matching,
+  // bound the scan.
+  bool read_ahead{};
+  // Back the read buffers of the workers, and candidate storage unless `chunk_allocator` is set, with large pages (see
+  // PagePlacement). Read buffers of a pool pinned to NUMA nodes are allocated on the node of their worker either way.
+  bool large_pages{};
+  // Directory receiving the snapshot files that next scans compare against. Empty disables snapshots, which leaves
+  // only NextScanOp::kMatch available.
+  std::filesystem::path snapshot_dir;
+  // Once this many candidates were found, shards that have not been started yet are skipped, so the result holds at
+  // least this many candidates, plus whatever the shards in flight at that moment added. Zero scans everything.
+  size_t max_results{};
+  // Where candidate storage comes from, the OS when null. Must outlive the scanner and every result it returned.
+  ChunkAllocator* chunk_allocator{};
+};
+
+// Shards are a power of two in size, so only power-of-two alignments keep every shard of a region on the candidate grid
+// the region starts. First scans of a scanner with any other ScanOptions::alignment find nothing.
+constexpr bool IsValidAlignment(size_t alignment) { return alignment == 0 || std::has_single_bit(alignment); }
+
+enum class NextScanOp : uint8_t {
+  // The current value satisfies NextScanQuery::predicate.
+  kMatch,
+  // Comparisons against the snapshot of the previous scan. Changed and unchanged compare bit patterns.
+  kChanged,
+  kUnchanged,
+  kIncreased,
+  kDecreased,
+};
+
+struct NextScanQuery {
+  NextScanOp op{NextScanOp::kMatch};
+  MatchPredicate predicate;
+};
+
+struct ScanStats {
+  size_t regions{};
+  size_t shards{};
+  uint64_t bytes_scanned{};
+  uint64_t read_calls{};
+  // Part of `bytes_scanned` that was scanned in place instead of copied.
+  uint64_t bytes_mapped{};
+  // Shards were skipped because ScanOptions::max_results was reached.
+  bool truncated{};
+  // Shards were skipped because the scan was cancelled through its ScanProgress.
+  bool cancelled{};
+  // Process::Query() calls spent bringing the region map up to date.
+  uint64_t region_queries{};
+};
+
+struct ScanResult {
+  CandidateSet candidates;
+  // Candidate values as of this scan. Absent when snapshots are disabled or the snapshot file could not be written.
+  std::optional<Snapshot> snapshot;
+  ScanStats stats;
+};
+
+struct SignatureScanOptions {
+  // Only search the executable sections of loaded images, where code signatures point. False searches every readable
+  // region.
+  bool code_only{true};
+  // Only search [begin, end), e.g. the extent of a single module.
+  uintptr_t begin{};
+  uintptr_t end{UINTPTR_MAX};
+};
+
+struct SignatureScanResult {
+  // Start addresses of the matches in ascending order.
+  std::vector<uintptr_t> addresses;
+  ScanStats stats;
+};
+
+struct SignatureSetScanResult {
+  // Start addresses of the matches of every signature of the set, in ascending order.
+  std::vector<std::vector<uintptr_t>> addresses;
+  ScanStats stats;
+};
+
+struct StringMatch {
+  uintptr_t address{};
+  StringEncoding encoding{};
+};
+
+struct StringScanResult {
+  // Matches of every encoding of the pattern in ascending order of address.
+  std::vector<StringMatch> matches;
+  ScanStats stats;
+};
+
+// A contiguous piece of a region scanned by a single worker.
+struct Shard {
+  uintptr_t base{};
+  // Candidate addresses start in [base, base + size).
+  size_t size{};
+  // Bytes that have to be read so that values straddling the end of the shard can still be compared. Never extends past
+  // the end of the owning region.
+  size_t read_size{};
+};
+
+// Splits `regions` into shards of at most `shard_size` bytes, each overlapping the next by `value_size - 1` bytes.
+std::vector<Shard> SplitIntoShards(std::span<const MemoryRegion> regions, size_t shard_size, size_t value_size);
+
+// Called by a job of a ThreadPool::ParallelFor() over `shards` once it read its own shard: starts reading the shard
+// `worker` will most likely take next. Does nothing unless `reader` reads ahead.
+void ReadAheadNextShard(MemoryReader& reader, const ThreadPool& pool, std::span<const Shard> shards, size_t worker);
+
+class Scanner {
+ public:
+  Scanner(const Process& process, ThreadPool& pool, ScanOptions options = {});
+
+  const ScanOptions& options() const { return options_; }
+
+  // Region map shared by every scan of this scanner. Next scans refresh it too, so that candidates in memory the
+  // target released since the previous scan are dropped without being read.
+  RegionCache& region_cache() { return region_cache_; }
+
+  // Reader every scan goes through, for its per-worker counters.
+  const MemoryReader& reader() const { return reader_; }
+
+  // Scans report their progress to `progress`, and stop early once it is cancelled, until another one is set. Null
+  // restores the scanner's own, which nobody cancels. Must not change while a scan runs.
+  void set_progress(ScanProgress* progress) { progress_ = progress != nullptr ? progress : &own_progress_; }
+
+  // Every scan also delivers its blocks to `sink`, when given, as they complete; the sink is ended when the scan
+  // returns. A ResultStream lets another thread consume them.
+
+  // Scans every readable region of the target for values satisfying `predicate`.
+  ScanResult FirstScan(const MatchPredicate& predicate, ResultSink* sink = nullptr);
+
+  // Scans for groups of values matching `pattern` in a single pass. Candidates are the addresses of the first field,
+  // on the grid of its type, and hold its value; the other fields are only checked by this scan.
+  ScanResult GroupScan(const GroupPattern& pattern, ResultSink* sink = nullptr);
+
+  // Starts an "unknown initial value" scan: every aligned slot of every readable region becomes a candidate and, with
+  // snapshots enabled, the whole readable memory is recorded as the baseline for the next scan.
+  ScanResult UnknownScan(ValueType type, ResultSink* sink = nullptr);
+
+  // Keeps the candidates of `previous` that pass `query`. Comparisons other than kMatch require `previous.snapshot`
+  // and return an empty result without it.
+  ScanResult NextScan(const ScanResult& previous, const NextScanQuery& query, ResultSink* sink = nullptr);
+
+  // Rebuilds the generation saved in `checkpoint` as a result that next scans can continue from, without reading the
+  // target. It gets a snapshot when the checkpoint kept its values and snapshots are enabled.
+  ScanResult Restore(const ScanCheckpoint& checkpoint);
+
+  // Finds every address at which the bytes of the target match `signature`. ScanOptions::max_results caps the matches
+  // like it caps candidates; alignment and snapshots do not apply.
+  SignatureScanResult SignatureScan(const Signature& signature, const SignatureScanOptions& signature_options = {});
+
+  // Resolves every signature of `signatures` in a single pass over the selected memory. ScanOptions::max_results caps
+  // the matches of all signatures together.
+  SignatureSetScanResult SignatureScan(const SignatureSet& signatures,
+                                       const SignatureScanOptions& signature_options = {});
+
+  // Finds every occurrence of `pattern` in any of its encodings in a single pass over the memory selected by
+  // `signature_options`; strings usually live in data, so callers mostly clear `code_only`. ScanOptions::max_results
+  // caps the matches of all encodings together.
+  StringScanResult StringScan(const StringPattern& pattern, const SignatureScanOptions& signature_options);
+
+ private:
+  // Current regions of the target, merged for reading, after giving the reader a chance to map them. None when the
+  // alignment is invalid.
+  std::vector<MemoryRegion> QueryScanRegions();
+  std::vector<MemoryRegion> PrepareScanRegions(const std::vector<MemoryRegion>& regions);
+  // Current regions selected by `signature_options`, prepared like QueryScanRegions().
+  std::vector<MemoryRegion> QuerySignatureRegions(const SignatureScanOptions& signature_options);
+
+  const Process& process_;
+  ThreadPool& pool_;
+  MemoryReader reader_;
+  RegionCache region_cache_;
+  // Candidate storage of every scan comes from a fresh generation, recycled once no result references it.
+  ArenaPool arenas_;
+  ScanOptions options_;
+  ScanProgress own_progress_;
+  ScanProgress* progress_{&own_progress_};
+};
+
+}  // namespace maia
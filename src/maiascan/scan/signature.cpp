@@ -0,0 +1,142 @@
+#include "maiascan/scan/signature.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <utility>
+
+#include <fmt/core.h>
+
+#include "maiascan/scan/kernels_internal.hpp"
+
+namespace maia {
+
+namespace {
+
+// Padding and immediates, REX prefixes, the mov/lea/call/jcc opcodes and the ModRM and SIB bytes of stack accesses.
+// Good enough to keep anchors off the bytes that show up every few instructions.
+constexpr std::array<uint8_t, 256> kCodeByteRank = [] {
+  std::array<uint8_t, 256> rank{};
+  for (const int byte : {0x00, 0xFF, 0xCC, 0x48, 0x8B, 0x89}) {
+    rank[byte] = 3;
+  }
+  for (const int byte : {0x0F, 0x24, 0x4C, 0x8D, 0xE8, 0x44, 0x41, 0x83, 0x85, 0xC0, 0x49, 0x45, 0x74, 0x75, 0x01,
+                         0x08, 0x10, 0x20, 0x40, 0x90, 0xC3, 0x4D}) {
+    rank[byte] = 2;
+  }
+  for (const int byte : {0x02, 0x03, 0x04, 0x05, 0x18, 0x28, 0x30, 0x33, 0x38, 0x50, 0x58, 0x80, 0x84, 0xC4, 0xC7,
+                         0xC8, 0xD8, 0xE9, 0xEB, 0xF0, 0xF8, 0x1F, 0x66, 0x63}) {
+    rank[byte] = 1;
+  }
+  return rank;
+}();
+
+std::optional<std::byte> ParseHexByte(std::string_view token) {
+  uint8_t value = 0;
+  const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value, 16);
+  if (token.size() != 2 || error != std::errc{} || end != token.data() + token.size()) {
+    return std::nullopt;
+  }
+  return std::byte{value};
+}
+
+void FindSignatureScalar(const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets) {
+  if (size < signature.size()) {
+    return;
+  }
+  const size_t count = size - signature.size() + 1;
+  const std::byte* anchors = data + signature.anchor();
+  const int needle = std::to_integer<int>(signature.anchor_byte());
+  for (size_t start = 0; start < count;) {
+    const void* hit = std::memchr(anchors + start, needle, count - start);
+    if (hit == nullptr) {
+      break;
+    }
+    const size_t offset = static_cast<size_t>(static_cast<const std::byte*>(hit) - anchors);
+    if (signature.MatchesAt(data + offset)) {
+      offsets.push_back(offset);
+    }
+    start = offset + 1;
+  }
+}
+
+}  // namespace
+
+uint8_t CodeByteRank(std::byte byte) { return kCodeByteRank[std::to_integer<uint8_t>(byte)]; }
+
+std::optional<Signature> Signature::Parse(std::string_view text) {
+  Signature signature;
+  std::vector<std::byte> mask;
+  while (true) {
+    const size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+      break;
+    }
+    const size_t end = std::min(text.find_first_of(" \t", begin), text.size());
+    const std::string_view token = text.substr(begin, end - begin);
+    text.remove_prefix(end);
+    if (token == "?" || token == "??") {
+      signature.bytes_.push_back(std::byte{});
+      mask.push_back(std::byte{});
+      continue;
+    }
+    const auto byte = ParseHexByte(token);
+    if (!byte) {
+      return std::nullopt;
+    }
+    signature.bytes_.push_back(*byte);
+    mask.push_back(std::byte{0xFF});
+  }
+
+  // Ties go to the earliest byte.
+  const auto rank = [&](size_t i) { return CodeByteRank(signature.bytes_[i]); };
+  std::optional<size_t> anchor;
+  for (size_t i = 0; i < signature.bytes_.size(); ++i) {
+    if (mask[i] != std::byte{} && (!anchor || rank(i) < rank(*anchor))) {
+      anchor = i;
+    }
+  }
+  if (!anchor) {
+    return std::nullopt;
+  }
+  signature.size_ = signature.bytes_.size();
+  signature.anchor_ = *anchor;
+  const size_t padded = (signature.size_ + kPadding - 1) / kPadding * kPadding;
+  signature.bytes_.resize(padded);
+  mask.resize(padded);
+  signature.mask_ = std::move(mask);
+  return signature;
+}
+
+std::string Signature::ToString() const {
+  std::string text;
+  for (size_t i = 0; i < size_; ++i) {
+    if (i != 0) {
+      text += ' ';
+    }
+    text += mask_[i] == std::byte{} ? std::string("??") : fmt::format("{:02X}", std::to_integer<uint8_t>(bytes_[i]));
+  }
+  return text;
+}
+
+void FindSignature(const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets) {
+  FindSignature(ActiveKernelIsa(), data, size, signature, offsets);
+}
+
+void FindSignature(
+    KernelIsa isa, const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets) {
+  switch (isa) {
+    case KernelIsa::kAvx2:
+      detail::FindSignatureAvx2(data, size, signature, offsets);
+      break;
+    case KernelIsa::kSse41:
+      detail::FindSignatureSse41(data, size, signature, offsets);
+      break;
+    case KernelIsa::kScalar:
+      FindSignatureScalar(data, size, signature, offsets);
+      break;
+  }
+}
+
+}  // namespace maia
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "maiascan/scan/kernels.hpp"
+
+namespace maia {
+
+// A byte signature ("array of bytes") with wildcards, compiled for searching: the pattern and its mask are padded to
+// whole vectors so that candidates can be verified with a few masked vector compares, and the fixed byte expected to
+// be rarest in machine code is picked as the anchor that the search filters on first.
+class Signature {
+ public:
+  // Patterns are padded to a multiple of this many bytes, the widest vector the kernels use.
+  static constexpr size_t kPadding = 32;
+
+  // Parses whitespace-separated hex bytes, with "??" or "?" for wildcards, e.g. "48 8B ?? ?? 89". Fails for malformed
+  // bytes and for patterns without a single fixed byte.
+  static std::optional<Signature> Parse(std::string_view text);
+
+  // Length of the pattern in bytes, wildcards included.
+  size_t size() const { return size_; }
+
+  // Offset of the anchor byte within the pattern.
+  size_t anchor() const { return anchor_; }
+  std::byte anchor_byte() const { return bytes_[anchor_]; }
+
+  // Pattern and mask padded to a multiple of kPadding bytes. Mask bytes are 0xFF for fixed bytes and 0 for wildcards
+  // and padding, and pattern bytes are 0 wherever the mask is.
+  const std::byte* padded_bytes() const { return bytes_.data(); }
+  const std::byte* padded_mask() const { return mask_.data(); }
+  size_t padded_size() const { return bytes_.size(); }
+
+  // Whether the `size()` bytes at `data` match the pattern.
+  bool MatchesAt(const std::byte* data) const {
+    for (size_t i = 0; i < size_; ++i) {
+      if ((data[i] & mask_[i]) != bytes_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The pattern in the form Parse() accepts.
+  std::string ToString() const;
+
+ private:
+  Signature() = default;
+
+  std::vector<std::byte> bytes_;
+  std::vector<std::byte> mask_;
+  size_t size_{};
+  size_t anchor_{};
+};
+
+// Rough frequency rank of `byte` in x86-64 code, from 0 for rare to 3 for the most common. Used to pick anchors.
+uint8_t CodeByteRank(std::byte byte);
+
+// Appends to `offsets`, in ascending order, every offset in [0, size - signature.size()] at which `data` matches
+// `signature`.
+void FindSignature(const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets);
+
+// Same as FindSignature() but forces a particular instruction set, which must be supported by the CPU.
+void FindSignature(
+    KernelIsa isa, const std::byte* data, size_t size, const Signature& signature, std::vector<size_t>& offsets);
+
+}  // namespace maia
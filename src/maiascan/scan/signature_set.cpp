@@ -0,0 +1,131 @@
+#include "maiascan/scan/signature_set.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+namespace maia {
+
+namespace {
+
+bool IsFixed(const Signature& signature, size_t offset) {
+  return offset < signature.size() && signature.padded_mask()[offset] != std::byte{};
+}
+
+// Offset of the rarest pair of adjacent fixed bytes, or nullopt when no two fixed bytes are adjacent.
+std::optional<size_t> FindAnchorPair(const Signature& signature) {
+  std::optional<size_t> best;
+  int best_rank = 0;
+  for (size_t i = 0; i + 1 < signature.size(); ++i) {
+    if (!IsFixed(signature, i) || !IsFixed(signature, i + 1)) {
+      continue;
+    }
+    const int rank = CodeByteRank(signature.padded_bytes()[i]) + CodeByteRank(signature.padded_bytes()[i + 1]);
+    if (!best || rank < best_rank) {
+      best = i;
+      best_rank = rank;
+    }
+  }
+  return best;
+}
+
+// The pair of bytes at `data` as a table index; the first byte ends up in the low half.
+uint16_t LoadPair(const std::byte* data) {
+  return static_cast<uint16_t>(std::to_integer<uint16_t>(data[0]) | std::to_integer<uint16_t>(data[1]) << 8);
+}
+
+}  // namespace
+
+SignatureSet::SignatureSet(std::vector<Signature> signatures)
+    : signatures_(std::move(signatures)), anchors_(signatures_.size()), pairs_(65536 / 64) {
+  std::vector<Anchor> anchors;
+  for (size_t i = 0; i < signatures_.size(); ++i) {
+    const Signature& signature = signatures_[i];
+    const auto pair = FindAnchorPair(signature);
+    const size_t offset = pair ? *pair : signature.anchor();
+    const size_t first = std::to_integer<uint8_t>(signature.padded_bytes()[offset]);
+    if (pair) {
+      const uint16_t bit = LoadPair(signature.padded_bytes() + offset);
+      pairs_[bit / 64] |= uint64_t{1} << (bit % 64);
+    } else {
+      singles_[first / 64] |= uint64_t{1} << (first % 64);
+      for (size_t second = 0; second < 256; ++second) {
+        const size_t bit = first | second << 8;
+        pairs_[bit / 64] |= uint64_t{1} << (bit % 64);
+      }
+    }
+    anchors.push_back({.signature = static_cast<uint32_t>(i), .offset = static_cast<uint32_t>(offset)});
+    ++group_begin_[first + 1];
+    max_size_ = std::max(max_size_, signature.size());
+    max_anchor_ = std::max(max_anchor_, offset);
+  }
+  for (size_t b = 1; b < group_begin_.size(); ++b) {
+    group_begin_[b] += group_begin_[b - 1];
+  }
+  auto next = group_begin_;
+  for (const Anchor& anchor : anchors) {
+    const Signature& signature = signatures_[anchor.signature];
+    anchors_[next[std::to_integer<uint8_t>(signature.padded_bytes()[anchor.offset])]++] = anchor;
+  }
+}
+
+void SignatureSet::Find(const std::byte* data, size_t size, size_t limit, std::vector<SignatureMatch>& matches) const {
+  const auto verify = [&](size_t i, size_t first) {
+    for (uint32_t g = group_begin_[first]; g < group_begin_[first + 1]; ++g) {
+      const Anchor& anchor = anchors_[g];
+      const Signature& signature = signatures_[anchor.signature];
+      if (i < anchor.offset) {
+        continue;
+      }
+      const size_t start = i - anchor.offset;
+      if (start < limit && signature.size() <= size - start && signature.MatchesAt(data + start)) {
+        matches.push_back({.signature = anchor.signature, .offset = start});
+      }
+    }
+  };
+
+  // Anchors further in than this belong to matches starting at or after `limit`.
+  const size_t end = std::min(size, limit + max_anchor_);
+  size_t i = 0;
+  for (; i < end && i + 1 < size; ++i) {
+    const uint16_t pair = LoadPair(data + i);
+    if ((pairs_[pair / 64] >> (pair % 64) & 1) != 0) {
+      verify(i, pair & 0xFF);
+    }
+  }
+  // The last byte of the data has no successor, so only single-byte anchors can start there.
+  if (i < end) {
+    const size_t first = std::to_integer<uint8_t>(data[i]);
+    if ((singles_[first / 64] >> (first % 64) & 1) != 0) {
+      verify(i, first);
+    }
+  }
+}
+
+std::optional<std::vector<NamedSignature>> LoadSignatureFile(const std::filesystem::path& path) {
+  std::ifstream file(path);
+  if (!file) {
+    return std::nullopt;
+  }
+  const auto json = nlohmann::json::parse(file, nullptr, false);
+  if (json.is_discarded() || !json.is_array()) {
+    return std::nullopt;
+  }
+  std::vector<NamedSignature> signatures;
+  for (const auto& entry : json) {
+    if (!entry.is_object() || !entry.contains("name") || !entry["name"].is_string() || !entry.contains("pattern") ||
+        !entry["pattern"].is_string()) {
+      return std::nullopt;
+    }
+    auto signature = Signature::Parse(entry["pattern"].get<std::string>());
+    if (!signature) {
+      return std::nullopt;
+    }
+    signatures.push_back({.name = entry["name"].get<std::string>(), .signature = std::move(*signature)});
+  }
+  return signatures;
+}
+
+}  // namespace maia
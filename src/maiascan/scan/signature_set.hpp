@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "maiascan/scan/signature.hpp"
+
+namespace maia {
+
+struct SignatureMatch {
+  // Index of the signature in its set.
+  uint32_t signature{};
+  size_t offset{};
+};
+
+// Many signatures searched for in a single pass over the data. Each signature is anchored on its rarest pair of
+// adjacent fixed bytes, or on its rarest byte when it has no such pair, and a table of every pair that can start an
+// anchor filters the data two bytes at a time. Only the signatures whose anchor passes are verified, so the cost of a
+// pass barely depends on the number of signatures.
+class SignatureSet {
+ public:
+  explicit SignatureSet(std::vector<Signature> signatures);
+
+  size_t size() const { return signatures_.size(); }
+  const Signature& operator[](size_t index) const { return signatures_[index]; }
+
+  // Length of the longest signature.
+  size_t max_size() const { return max_size_; }
+
+  // Appends every match in the `size` bytes at `data` that starts before `limit`. Matches of one signature are
+  // appended in ascending order.
+  void Find(const std::byte* data, size_t size, size_t limit, std::vector<SignatureMatch>& matches) const;
+
+ private:
+  struct Anchor {
+    uint32_t signature{};
+    // Offset of the first anchor byte within the signature.
+    uint32_t offset{};
+  };
+
+  std::vector<Signature> signatures_;
+  // Anchors whose first byte is `b` are anchors_[group_begin_[b], group_begin_[b + 1]).
+  std::array<uint32_t, 257> group_begin_{};
+  std::vector<Anchor> anchors_;
+  // Bit `a | b << 8` is set when some anchor is the byte `a` followed by `b`, or `a` alone.
+  std::vector<uint64_t> pairs_;
+  // Bit `a` is set when some anchor is the byte `a` alone.
+  std::array<uint64_t, 4> singles_{};
+  size_t max_size_{};
+  size_t max_anchor_{};
+};
+
+struct NamedSignature {
+  std::string name;
+  Signature signature;
+};
+
+// Loads a JSON array of {"name": ..., "pattern": ...} objects, with patterns in the form Signature::Parse() accepts.
+// Fails when the file cannot be read or parsed, or when any entry is malformed.
+std::optional<std::vector<NamedSignature>> LoadSignatureFile(const std::filesystem::path& path);
+
+}  // namespace maia
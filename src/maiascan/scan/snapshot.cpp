@@ -0,0 +1,29 @@
+#include "maiascan/scan/snapshot.hpp"
+
+namespace maia {
+
+std::optional<Snapshot> Snapshot::Create(const std::filesystem::path& directory, size_t worker_count) {
+  auto file = SegmentedFile::CreateTemporary(directory, "maiascan-snapshot");
+  if (!file) {
+    return std::nullopt;
+  }
+  return Snapshot(std::move(file), worker_count);
+}
+
+std::span<std::byte> Snapshot::Allocate(size_t worker, size_t bytes) {
+  Cursor& cursor = cursors_[worker];
+  if (cursor.segment.size() - cursor.used < bytes) {
+    // Each worker fills a segment of its own, so segments are only added under the file lock every few dozen MiB.
+    cursor.segment = file_->AddSegment(bytes);
+    cursor.used = 0;
+    if (cursor.segment.empty()) {
+      failed_->store(true, std::memory_order_relaxed);
+      return {};
+    }
+  }
+  auto storage = cursor.segment.subspan(cursor.used, bytes);
+  cursor.used += bytes;
+  return storage;
+}
+
+}  // namespace maia
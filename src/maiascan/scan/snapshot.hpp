@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/mapped_file.hpp"
+
+namespace maia {
+
+// Values of every candidate of a CandidateSet at the time the set was produced, used by comparisons against the
+// previous scan. Values are packed in candidate order, so the `k`-th candidate of block `b` starts at byte
+// `k * value_size` of `block_values(b)`. The bytes live in a temporary memory-mapped file rather than on the heap.
+class Snapshot {
+ public:
+  // Starts an empty snapshot backed by a new file in `directory`, to be filled by up to `worker_count` writers.
+  static std::optional<Snapshot> Create(const std::filesystem::path& directory, size_t worker_count);
+
+  // Returns `bytes` bytes of storage for values that `worker` is about to record, or an empty span if the file could
+  // not grow. Distinct workers may call this concurrently.
+  std::span<std::byte> Allocate(size_t worker, size_t bytes);
+
+  // True when an earlier Allocate() failed and the snapshot is incomplete.
+  bool failed() const { return failed_->load(std::memory_order_relaxed); }
+
+  // Publishes the recorded values of each candidate block, indexed like CandidateSet::blocks.
+  void SetBlocks(std::vector<std::span<const std::byte>> blocks) { blocks_ = std::move(blocks); }
+
+  std::span<const std::byte> block_values(size_t block) const { return blocks_[block]; }
+
+  // Bytes of the backing file.
+  uint64_t file_size() const { return file_->size(); }
+
+ private:
+  // Padded so that workers advancing their own cursors do not share cache lines.
+  struct alignas(64) Cursor {
+    std::span<std::byte> segment;
+    size_t used{};
+  };
+
+  explicit Snapshot(std::unique_ptr<SegmentedFile> file, size_t worker_count)
+      : file_(std::move(file)), cursors_(worker_count), failed_(std::make_unique<std::atomic<bool>>(false)) {}
+
+  std::unique_ptr<SegmentedFile> file_;
+  std::vector<Cursor> cursors_;
+  std::vector<std::span<const std::byte>> blocks_;
+  std::unique_ptr<std::atomic<bool>> failed_;
+};
+
+}  // namespace maia
@@ -0,0 +1,171 @@
+#include "maiascan/scan/string_pattern.hpp"
+
+#include <algorithm>
+
+#include "maiascan/scan/kernels_internal.hpp"
+
+namespace maia {
+
+namespace {
+
+// Decodes UTF-8 into code points, rejecting overlong forms, surrogates and truncated sequences.
+std::optional<std::vector<char32_t>> DecodeUtf8(std::string_view text) {
+  std::vector<char32_t> code_points;
+  for (size_t i = 0; i < text.size();) {
+    const auto lead = static_cast<uint8_t>(text[i]);
+    size_t length = 0;
+    char32_t code_point = 0;
+    char32_t min = 0;
+    if (lead < 0x80) {
+      length = 1;
+      code_point = lead;
+    } else if ((lead & 0xE0) == 0xC0) {
+      length = 2;
+      code_point = lead & 0x1F;
+      min = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+      length = 3;
+      code_point = lead & 0x0F;
+      min = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+      length = 4;
+      code_point = lead & 0x07;
+      min = 0x10000;
+    } else {
+      return std::nullopt;
+    }
+    if (i + length > text.size()) {
+      return std::nullopt;
+    }
+    for (size_t j = 1; j < length; ++j) {
+      const auto continuation = static_cast<uint8_t>(text[i + j]);
+      if ((continuation & 0xC0) != 0x80) {
+        return std::nullopt;
+      }
+      code_point = code_point << 6 | (continuation & 0x3F);
+    }
+    if (code_point < min || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+      return std::nullopt;
+    }
+    code_points.push_back(code_point);
+    i += length;
+  }
+  return code_points;
+}
+
+bool IsAsciiLetter(char32_t c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); }
+
+// Appends one byte of the encoded string, which with `fold` is the low byte of an ASCII letter.
+void Append(EncodedString& encoded, std::byte byte, bool fold) {
+  constexpr std::byte kCaseBit{0x20};
+  encoded.bytes.push_back(fold ? byte | kCaseBit : byte);
+  encoded.fold.push_back(fold ? kCaseBit : std::byte{});
+}
+
+EncodedString Encode(std::string_view text,
+                     std::span<const char32_t> code_points,
+                     StringEncoding encoding,
+                     bool ignore_case) {
+  EncodedString encoded;
+  encoded.encoding = encoding;
+  if (encoding == StringEncoding::kUtf8) {
+    for (const char c : text) {
+      const auto unit = static_cast<uint8_t>(c);
+      Append(encoded, std::byte{unit}, ignore_case && IsAsciiLetter(unit));
+    }
+  } else {
+    const auto append_unit = [&](uint16_t unit, bool fold) {
+      Append(encoded, std::byte(unit & 0xFF), fold);
+      Append(encoded, std::byte(unit >> 8), false);
+    };
+    for (const char32_t c : code_points) {
+      if (c >= 0x10000) {
+        append_unit(static_cast<uint16_t>(0xD800 + ((c - 0x10000) >> 10)), false);
+        append_unit(static_cast<uint16_t>(0xDC00 + ((c - 0x10000) & 0x3FF)), false);
+      } else {
+        append_unit(static_cast<uint16_t>(c), ignore_case && IsAsciiLetter(c));
+      }
+    }
+  }
+  encoded.size = encoded.bytes.size();
+  constexpr size_t kPadding = StringPattern::kPadding;
+  const size_t padded = (encoded.size + kPadding - 1) / kPadding * kPadding;
+  encoded.bytes.resize(padded, std::byte{0xFF});
+  encoded.fold.resize(padded, std::byte{0xFF});
+  return encoded;
+}
+
+void FindStringScalar(
+    const std::byte* data, size_t size, size_t limit, const StringPattern& pattern, std::vector<StringHit>& hits) {
+  const size_t count = std::min(size, limit);
+  for (size_t offset = 0; offset < count; ++offset) {
+    for (const EncodedString& encoded : pattern.encodings()) {
+      if (offset + encoded.size <= size && encoded.MatchesAt(data + offset)) {
+        hits.push_back({.offset = offset, .encoding = encoded.encoding});
+      }
+    }
+  }
+}
+
+}  // namespace
+
+std::string_view ToString(StringEncoding encoding) {
+  switch (encoding) {
+    case StringEncoding::kUtf8:
+      return "utf8";
+    case StringEncoding::kUtf16:
+      return "utf16";
+  }
+  return "unknown";
+}
+
+std::optional<StringPattern> StringPattern::Create(std::string_view text, bool utf8, bool utf16, bool ignore_case) {
+  const auto code_points = DecodeUtf8(text);
+  if (text.empty() || !code_points || (!utf8 && !utf16)) {
+    return std::nullopt;
+  }
+  StringPattern pattern;
+  pattern.text_ = text;
+  pattern.ignore_case_ = ignore_case;
+  if (utf8) {
+    pattern.encodings_.push_back(Encode(text, *code_points, StringEncoding::kUtf8, ignore_case));
+  }
+  if (utf16) {
+    pattern.encodings_.push_back(Encode(text, *code_points, StringEncoding::kUtf16, ignore_case));
+  }
+  return pattern;
+}
+
+size_t StringPattern::max_size() const {
+  size_t size = 0;
+  for (const EncodedString& encoded : encodings_) {
+    size = std::max(size, encoded.size);
+  }
+  return size;
+}
+
+void FindString(
+    const std::byte* data, size_t size, size_t limit, const StringPattern& pattern, std::vector<StringHit>& hits) {
+  FindString(ActiveKernelIsa(), data, size, limit, pattern, hits);
+}
+
+void FindString(KernelIsa isa,
+                const std::byte* data,
+                size_t size,
+                size_t limit,
+                const StringPattern& pattern,
+                std::vector<StringHit>& hits) {
+  switch (isa) {
+    case KernelIsa::kAvx2:
+      detail::FindStringAvx2(data, size, limit, pattern, hits);
+      break;
+    case KernelIsa::kSse41:
+      detail::FindStringSse41(data, size, limit, pattern, hits);
+      break;
+    case KernelIsa::kScalar:
+      FindStringScalar(data, size, limit, pattern, hits);
+      break;
+  }
+}
+
+}  // namespace maia
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "maiascan/scan/kernels.hpp"
+
+namespace maia {
+
+enum class StringEncoding : uint8_t {
+  kUtf8,
+  // Little-endian, as Windows stores wide strings.
+  kUtf16,
+};
+
+std::string_view ToString(StringEncoding encoding);
+
+// A string pattern in one encoding, laid out so that a candidate is checked with plain byte compares after OR-ing a
+// fold mask into the data: (data[i] | fold[i]) == bytes[i]. Case-insensitive patterns fold ASCII letters by setting
+// their 0x20 bit; every other byte must match exactly.
+struct EncodedString {
+  StringEncoding encoding{};
+  // Length of the encoded string in bytes.
+  size_t size{};
+  // Folded bytes and fold masks, padded to a multiple of StringPattern::kPadding with 0xFF in both, which any data byte
+  // matches. Strings of a single byte therefore have an always-matching second byte, which lets the search filter on
+  // the first two bytes of every encoding alike.
+  std::vector<std::byte> bytes;
+  std::vector<std::byte> fold;
+
+  // Whether the `size` bytes at `data` match.
+  bool MatchesAt(const std::byte* data) const {
+    for (size_t i = 0; i < size; ++i) {
+      if ((data[i] | fold[i]) != bytes[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// Text to search for in one or both encodings at once.
+class StringPattern {
+ public:
+  // Encodings are padded to a multiple of this many bytes, the widest vector the kernels use.
+  static constexpr size_t kPadding = 32;
+
+  // Compiles the UTF-8 `text` for every requested encoding. With `ignore_case`, ASCII letters match either case and
+  // everything else exactly. Fails for empty or malformed text and when no encoding is requested.
+  static std::optional<StringPattern> Create(std::string_view text, bool utf8, bool utf16, bool ignore_case);
+
+  const std::string& text() const { return text_; }
+  bool ignore_case() const { return ignore_case_; }
+
+  // One or two encodings, UTF-8 first.
+  std::span<const EncodedString> encodings() const { return encodings_; }
+
+  // Length of the longest encoding in bytes.
+  size_t max_size() const;
+
+ private:
+  StringPattern() = default;
+
+  std::string text_;
+  bool ignore_case_{};
+  std::vector<EncodedString> encodings_;
+};
+
+struct StringHit {
+  size_t offset;
+  StringEncoding encoding;
+};
+
+// Appends to `hits`, in ascending order of offset, every match of any encoding of `pattern` in `data` that starts
+// before `limit` and ends within `size`. All encodings are searched in the same pass over the data.
+void FindString(
+    const std::byte* data, size_t size, size_t limit, const StringPattern& pattern, std::vector<StringHit>& hits);
+
+// Same as FindString() but forces a particular instruction set, which must be supported by the CPU.
+void FindString(KernelIsa isa,
+                const std::byte* data,
+                size_t size,
+                size_t limit,
+                const StringPattern& pattern,
+                std::vector<StringHit>& hits);
+
+}  // namespace maia
@@ -0,0 +1,103 @@
+#include "maiascan/scan/value.hpp"
+
+#include <charconv>
+#include <limits>
+#include <type_traits>
+
+#include <fmt/core.h>
+
+namespace maia {
+
+namespace {
+
+struct ValueTypeInfo {
+  ValueType type;
+  std::string_view name;
+  size_t size;
+};
+
+constexpr std::array<ValueTypeInfo, 10> kValueTypes{{
+    {ValueType::kInt8, "i8", 1},
+    {ValueType::kUInt8, "u8", 1},
+    {ValueType::kInt16, "i16", 2},
+    {ValueType::kUInt16, "u16", 2},
+    {ValueType::kInt32, "i32", 4},
+    {ValueType::kUInt32, "u32", 4},
+    {ValueType::kInt64, "i64", 8},
+    {ValueType::kUInt64, "u64", 8},
+    {ValueType::kFloat, "f32", 4},
+    {ValueType::kDouble, "f64", 8},
+}};
+
+const ValueTypeInfo& Info(ValueType type) { return kValueTypes[static_cast<size_t>(type)]; }
+
+template <typename T>
+std::optional<ScanValue> ParseAs(ValueType type, std::string_view text) {
+  T value{};
+  const char* first = text.data();
+  const char* last = text.data() + text.size();
+  std::from_chars_result parsed{};
+  if constexpr (std::is_floating_point_v<T>) {
+    parsed = std::from_chars(first, last, value);
+  } else {
+    int base = 10;
+    bool negative = false;
+    if constexpr (std::is_signed_v<T>) {
+      if (first != last && *first == '-') {
+        negative = true;
+        ++first;
+      }
+    }
+    if (last - first > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X')) {
+      base = 16;
+      first += 2;
+    }
+    // Parse the magnitude unsigned so that hexadecimal bit patterns such as 0xFFFFFFFF are accepted for signed types.
+    std::make_unsigned_t<T> magnitude{};
+    parsed = std::from_chars(first, last, magnitude, base);
+    if (negative && magnitude > static_cast<std::make_unsigned_t<T>>(std::numeric_limits<T>::max()) + 1U) {
+      return std::nullopt;
+    }
+    value = static_cast<T>(negative ? static_cast<std::make_unsigned_t<T>>(0 - magnitude) : magnitude);
+  }
+  if (parsed.ec != std::errc() || parsed.ptr != last) {
+    return std::nullopt;
+  }
+  return ScanValue::From(type, value);
+}
+
+template <typename T>
+std::string FormatAs(const std::byte* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  if constexpr (sizeof(T) == 1) {
+    return fmt::format("{}", static_cast<int>(value));
+  } else {
+    return fmt::format("{}", value);
+  }
+}
+
+}  // namespace
+
+size_t SizeOf(ValueType type) { return Info(type).size; }
+
+std::string_view ToString(ValueType type) { return Info(type).name; }
+
+std::optional<ValueType> ParseValueType(std::string_view name) {
+  for (const auto& info : kValueTypes) {
+    if (info.name == name) {
+      return info.type;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<ScanValue> ParseScanValue(ValueType type, std::string_view text) {
+  return VisitValueType(type, [&]<typename T>() { return ParseAs<T>(type, text); });
+}
+
+std::string FormatValue(ValueType type, const std::byte* data) {
+  return VisitValueType(type, [&]<typename T>() { return FormatAs<T>(data); });
+}
+
+}  // namespace maia
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace maia {
+
+enum class ValueType : uint8_t {
+  kInt8,
+  kUInt8,
+  kInt16,
+  kUInt16,
+  kInt32,
+  kUInt32,
+  kInt64,
+  kUInt64,
+  kFloat,
+  kDouble,
+};
+
+size_t SizeOf(ValueType type);
+
+inline bool IsFloatingPoint(ValueType type) { return type == ValueType::kFloat || type == ValueType::kDouble; }
+
+// Invokes `fn.template operator()<T>()` with the C++ type that represents `type`.
+template <typename Fn>
+decltype(auto) VisitValueType(ValueType type, Fn&& fn) {
+  switch (type) {
+    case ValueType::kInt8:
+      return fn.template operator()<int8_t>();
+    case ValueType::kUInt8:
+      return fn.template operator()<uint8_t>();
+    case ValueType::kInt16:
+      return fn.template operator()<int16_t>();
+    case ValueType::kUInt16:
+      return fn.template operator()<uint16_t>();
+    case ValueType::kInt32:
+      return fn.template operator()<int32_t>();
+    case ValueType::kUInt32:
+      return fn.template operator()<uint32_t>();
+    case ValueType::kInt64:
+      return fn.template operator()<int64_t>();
+    case ValueType::kUInt64:
+      return fn.template operator()<uint64_t>();
+    case ValueType::kFloat:
+      return fn.template operator()<float>();
+    case ValueType::kDouble:
+      break;
+  }
+  return fn.template operator()<double>();
+}
+
+// Short names used on the command line: i8, u8, i16, u16, i32, u32, i64, u64, f32 and f64.
+std::string_view ToString(ValueType type);
+std::optional<ValueType> ParseValueType(std::string_view name);
+
+// A typed value as it is laid out in target memory (little-endian, native representation).
+struct ScanValue {
+  ValueType type{ValueType::kInt32};
+  std::array<std::byte, 8> bytes{};
+
+  size_t size() const { return SizeOf(type); }
+
+  template <typename T>
+  T As() const {
+    static_assert(sizeof(T) <= sizeof(bytes));
+    T value;
+    std::memcpy(&value, bytes.data(), sizeof(T));
+    return value;
+  }
+
+  template <typename T>
+  static ScanValue From(ValueType type, T value) {
+    static_assert(sizeof(T) <= sizeof(bytes));
+    ScanValue result{.type = type};
+    std::memcpy(result.bytes.data(), &value, sizeof(T));
+    return result;
+  }
+};
+
+// Parses decimal or 0x-prefixed hexadecimal integers and decimal floating point values.
+std::optional<ScanValue> ParseScanValue(ValueType type, std::string_view text);
+
+// Formats the `SizeOf(type)` bytes at `data` as a value of `type`.
+std::string FormatValue(ValueType type, const std::byte* data);
+
+}  // namespace maia
@@ -0,0 +1,73 @@
+#include "maiascan/session/session.hpp"
+
+#include <utility>
+
+namespace maia {
+
+std::unique_ptr<Session> Session::Attach(uint32_t pid, SessionOptions options) {
+  auto process = Process::Open(pid, options.access);
+  if (!process) {
+    return nullptr;
+  }
+  return std::unique_ptr<Session>(new Session(std::move(*process), options));
+}
+
+std::unique_ptr<Session> Session::AttachDump(const std::filesystem::path& path,
+                                             uintptr_t raw_base,
+                                             SessionOptions options) {
+  auto process = Process::OpenDump(path, raw_base);
+  if (!process) {
+    return nullptr;
+  }
+  return std::unique_ptr<Session>(new Session(std::move(*process), options));
+}
+
+Session::Session(Process process, const SessionOptions& options)
+    : process_(std::move(process)),
+      pool_(options.threads, options.pin_to_nodes),
+      scanner_(process_, pool_, options.scan),
+      pointer_map_options_(options.pointer_map),
+      chunk_allocator_(options.scan.chunk_allocator),
+      modules_(process_.QueryModules()) {}
+
+ScanResult Session::FirstScan(const MatchPredicate& predicate, ResultSink* sink) {
+  return scanner_.FirstScan(predicate, sink);
+}
+
+ScanResult Session::GroupScan(const GroupPattern& pattern, ResultSink* sink) {
+  return scanner_.GroupScan(pattern, sink);
+}
+
+ScanResult Session::UnknownScan(ValueType type, ResultSink* sink) { return scanner_.UnknownScan(type, sink); }
+
+ScanResult Session::NextScan(const ScanResult& previous, const NextScanQuery& query, ResultSink* sink) {
+  return scanner_.NextScan(previous, query, sink);
+}
+
+ScanResult Session::Restore(const ScanCheckpoint& checkpoint) { return scanner_.Restore(checkpoint); }
+
+PointerScanResult Session::PointerScan(uintptr_t target, const PointerScanOptions& options) {
+  if (!pointer_map_) {
+    RefreshPointerMap();
+  }
+  return pointer_scanner_->Scan(target, options);
+}
+
+const PointerMap& Session::RefreshPointerMap() {
+  if (!pointer_reader_) {
+    const ScanOptions& scan_options = scanner_.options();
+    pointer_reader_ = std::make_unique<MemoryReader>(process_,
+                                                     pool_.size(),
+                                                     scan_options.read_mode,
+                                                     scan_options.read_ahead,
+                                                     WorkerPlacements(pool_, scan_options.large_pages));
+  }
+  // The scanner refers to the map, so it goes first.
+  pointer_scanner_.reset();
+  modules_ = process_.QueryModules();
+  pointer_map_ = PointerMap::Build(*pointer_reader_, pool_, pointer_map_options_, &scanner_.region_cache());
+  pointer_scanner_ = std::make_unique<PointerScanner>(*pointer_map_, modules_, pool_, chunk_allocator_);
+  return *pointer_map_;
+}
+
+}  // namespace maia
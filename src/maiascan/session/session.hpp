@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "maiascan/core/memory_reader.hpp"
+#include "maiascan/core/page_buffer.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/core/thread_pool.hpp"
+#include "maiascan/pointer/pointer_map.hpp"
+#include "maiascan/pointer/pointer_scanner.hpp"
+#include "maiascan/scan/checkpoint.hpp"
+#include "maiascan/scan/result_stream.hpp"
+#include "maiascan/scan/scan_progress.hpp"
+#include "maiascan/scan/scanner.hpp"
+
+namespace maia {
+
+struct SessionOptions {
+  // Scan threads, 0 for one per hardware thread.
+  size_t threads{};
+  // Pin the scan threads to NUMA nodes, which also places their read buffers on those nodes (see ThreadPool).
+  bool pin_to_nodes{};
+  ProcessAccess access{ProcessAccess::kRead};
+  // Applies to every value scan. Its chunk_allocator also backs the nodes of pointer scans.
+  ScanOptions scan;
+  PointerMapOptions pointer_map;
+};
+
+// The scan engine behind one target, for embedding it instead of running the command-line tool. A session owns the
+// opened process, the worker threads and the scanner, and keeps what successive scans share: the region map, the
+// recycled candidate arenas and, once a pointer scan built it, the pointer map.
+//
+// Nothing a scan produces is copied on its way to the caller. Candidate storage comes from
+// ScanOptions::chunk_allocator, so an embedder can place it in memory it budgets itself, results are moved out, and a
+// ResultSink receives the blocks of a scan in place as its shards complete. Sessions are not thread-safe, except that
+// the ScanProgress of a running scan may be sampled and cancelled from any thread.
+class Session {
+ public:
+  static std::unique_ptr<Session> Attach(uint32_t pid, SessionOptions options = {});
+
+  // Scans a minidump or raw region dump instead of a live process, see Process::OpenDump(). Writes fail.
+  static std::unique_ptr<Session> AttachDump(const std::filesystem::path& path,
+                                             uintptr_t raw_base,
+                                             SessionOptions options = {});
+
+  Session(const Session&) = delete;
+  Session& operator=(const Session&) = delete;
+
+  const Process& process() const { return process_; }
+  const std::vector<Module>& modules() const { return modules_; }
+  // Worker threads of the session, which ScanHistory::Record() compresses checkpoints with.
+  ThreadPool& pool() { return pool_; }
+
+  // Value scans, see Scanner. Results keep their candidate storage alive on their own and may outlive the session only
+  // as long as the chunk allocator does.
+  ScanResult FirstScan(const MatchPredicate& predicate, ResultSink* sink = nullptr);
+  ScanResult GroupScan(const GroupPattern& pattern, ResultSink* sink = nullptr);
+  ScanResult UnknownScan(ValueType type, ResultSink* sink = nullptr);
+  ScanResult NextScan(const ScanResult& previous, const NextScanQuery& query, ResultSink* sink = nullptr);
+
+  // Rebuilds an earlier generation from its checkpoint, see ScanCheckpoint and ScanHistory.
+  ScanResult Restore(const ScanCheckpoint& checkpoint);
+
+  // Searches for static pointer paths to `target`. The pointer map is built on the first call and reused by later ones
+  // until RefreshPointerMap().
+  PointerScanResult PointerScan(uintptr_t target, const PointerScanOptions& options = {});
+  // Rebuilds the pointer map from the current memory of the target, reusing the region map of the value scans.
+  const PointerMap& RefreshPointerMap();
+
+  // Copies target memory into `out` up to the first unreadable byte and returns how many bytes were copied.
+  size_t Read(uintptr_t address, std::span<std::byte> out) const { return process_.Read(address, out); }
+  // Requires ProcessAccess::kReadWrite. Returns how many bytes were written.
+  size_t Write(uintptr_t address, std::span<const std::byte> data) const { return process_.Write(address, data); }
+
+  // Makes the next scan walk every region of the target again instead of carrying over unchanged-looking images, for
+  // embedders that know the target re-protected one (see RegionCache).
+  void InvalidateRegions() { scanner_.region_cache().Invalidate(); }
+
+  // Scans report to `progress` until another one is set, see Scanner::set_progress().
+  void set_progress(ScanProgress* progress) { scanner_.set_progress(progress); }
+
+ private:
+  Session(Process process, const SessionOptions& options);
+
+  Process process_;
+  ThreadPool pool_;
+  Scanner scanner_;
+  PointerMapOptions pointer_map_options_;
+  ChunkAllocator* chunk_allocator_;
+  std::vector<Module> modules_;
+  // Created with the pointer map, since pointer scans keep their own reader.
+  std::unique_ptr<MemoryReader> pointer_reader_;
+  std::optional<PointerMap> pointer_map_;
+  std::unique_ptr<PointerScanner> pointer_scanner_;
+};
+
+}  // namespace maia
@@ -0,0 +1,160 @@
+#include "maiascan/watch/freezer.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <span>
+
+namespace maia {
+
+Freezer::Freezer(const Process& process) : process_(process) {}
+
+Freezer::~Freezer() { Stop(); }
+
+uint32_t Freezer::Freeze(uintptr_t address, const ScanValue& value) {
+  std::lock_guard lock(mutex_);
+  const uint32_t id = next_id_++;
+  added_.push_back({.address = address, .id = id, .value = value});
+  changed_.store(true, std::memory_order_release);
+  return id;
+}
+
+void Freezer::Unfreeze(uint32_t id) {
+  std::lock_guard lock(mutex_);
+  removed_.push_back(id);
+  changed_.store(true, std::memory_order_release);
+}
+
+void Freezer::ApplyChanges() {
+  std::vector<Entry> added;
+  std::vector<uint32_t> removed;
+  {
+    std::lock_guard lock(mutex_);
+    added.swap(added_);
+    removed.swap(removed_);
+  }
+  entries_.insert(entries_.end(), added.begin(), added.end());
+  std::sort(removed.begin(), removed.end());
+  std::erase_if(entries_,
+                [&](const Entry& entry) { return std::binary_search(removed.begin(), removed.end(), entry.id); });
+  std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+    return a.address != b.address ? a.address < b.address : a.id < b.id;
+  });
+  BuildRuns();
+}
+
+void Freezer::BuildRuns() {
+  runs_.clear();
+  std::vector<size_t> run_of(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const Entry& entry = entries_[i];
+    const uintptr_t end = entry.address + entry.value.size();
+    if (runs_.empty() || entry.address > runs_.back().address + runs_.back().size) {
+      const size_t offset = runs_.empty() ? 0 : runs_.back().offset + runs_.back().size;
+      runs_.push_back({.address = entry.address, .offset = offset, .size = 0});
+    }
+    Run& run = runs_.back();
+    run.size = std::max<size_t>(run.size, end - run.address);
+    run_of[i] = runs_.size() - 1;
+  }
+
+  // Lay the values out in the order they were frozen, so that later ones overwrite the bytes they share.
+  bytes_.assign(runs_.empty() ? 0 : runs_.back().offset + runs_.back().size, std::byte{});
+  std::vector<size_t> order(entries_.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return entries_[a].id < entries_[b].id; });
+  for (const size_t i : order) {
+    const Run& run = runs_[run_of[i]];
+    const Entry& entry = entries_[i];
+    std::byte* out = bytes_.data() + run.offset + (entry.address - run.address);
+    std::memcpy(out, entry.value.bytes.data(), entry.value.size());
+  }
+}
+
+void Freezer::RunTick(std::chrono::steady_clock::time_point due) {
+  if (changed_.exchange(false, std::memory_order_acquire)) {
+    ApplyChanges();
+  }
+  uint64_t failed = 0;
+  for (const Run& run : runs_) {
+    if (process_.Write(run.address, std::span(bytes_).subspan(run.offset, run.size)) < run.size) {
+      ++failed;
+    }
+  }
+
+  const int64_t latency =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - due).count();
+  ticks_.fetch_add(1, std::memory_order_relaxed);
+  write_calls_.store(runs_.size(), std::memory_order_relaxed);
+  failed_writes_.fetch_add(failed, std::memory_order_relaxed);
+  last_latency_ns_.store(latency, std::memory_order_relaxed);
+  total_latency_ns_.fetch_add(latency, std::memory_order_relaxed);
+  if (latency > max_latency_ns_.load(std::memory_order_relaxed)) {
+    max_latency_ns_.store(latency, std::memory_order_relaxed);
+  }
+}
+
+void Freezer::Start(std::chrono::nanoseconds period) {
+  Stop();
+  stop_event_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (stop_event_ == nullptr) {
+    return;
+  }
+  thread_ = std::thread([this, period] { TickLoop(period); });
+}
+
+void Freezer::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  SetEvent(stop_event_);
+  thread_.join();
+  CloseHandle(stop_event_);
+  stop_event_ = nullptr;
+}
+
+void Freezer::TickLoop(std::chrono::nanoseconds period) {
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+  // Regular waitable timers, like Sleep(), only fire on the scheduler tick of about 15.6 ms, which is coarser than
+  // the periods freezing needs; the high-resolution kind is available from Windows 10 1803 on.
+  HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+  if (timer == nullptr) {
+    timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+  }
+  if (timer == nullptr) {
+    return;
+  }
+
+  const HANDLE handles[] = {stop_event_, timer};
+  auto due = std::chrono::steady_clock::now();
+  while (true) {
+    RunTick(due);
+    // Ticks that overrun the period delay the next one instead of piling up.
+    const auto now = std::chrono::steady_clock::now();
+    due = std::max(due + period, now);
+    // Negative due times are relative, in units of 100 ns.
+    const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(due - now);
+    LARGE_INTEGER delay{};
+    delay.QuadPart = -std::max<LONGLONG>(1, wait.count() / 100);
+    if (!SetWaitableTimer(timer, &delay, 0, nullptr, nullptr, FALSE) ||
+        WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+      break;
+    }
+  }
+  CloseHandle(timer);
+}
+
+FreezeStats Freezer::stats() const {
+  const uint64_t ticks = ticks_.load(std::memory_order_relaxed);
+  const int64_t total = total_latency_ns_.load(std::memory_order_relaxed);
+  return {.ticks = ticks,
+          .write_calls = write_calls_.load(std::memory_order_relaxed),
+          .failed_writes = failed_writes_.load(std::memory_order_relaxed),
+          .last_latency = std::chrono::nanoseconds(last_latency_ns_.load(std::memory_order_relaxed)),
+          .max_latency = std::chrono::nanoseconds(max_latency_ns_.load(std::memory_order_relaxed)),
+          .mean_latency = std::chrono::nanoseconds(ticks == 0 ? 0 : total / static_cast<int64_t>(ticks))};
+}
+
+}  // namespace maia
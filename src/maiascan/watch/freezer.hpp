@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "maiascan/core/process.hpp"
+#include "maiascan/scan/value.hpp"
+
+namespace maia {
+
+struct FreezeStats {
+  uint64_t ticks{};
+  // WriteProcessMemory calls of the latest tick, after merging contiguous values.
+  uint64_t write_calls{};
+  // Writes that did not go through completely, over all ticks.
+  uint64_t failed_writes{};
+  // Time from when a tick was due until its last write completed, which includes the wake-up delay of the thread.
+  std::chrono::nanoseconds last_latency{};
+  std::chrono::nanoseconds max_latency{};
+  std::chrono::nanoseconds mean_latency{};
+};
+
+// Holds values of the target at fixed contents by rewriting them every tick. Frozen values are kept sorted by address
+// and values that touch or overlap are merged into a single write, so a frozen structure costs one WriteProcessMemory
+// call per tick instead of one per field. Where values overlap, the most recent Freeze() wins.
+//
+// Ticks run on a dedicated thread of raised priority, woken by a high-resolution timer where the system has one, so
+// that the period holds while the machine is busy. The process must have been opened with ProcessAccess::kReadWrite.
+class Freezer {
+ public:
+  explicit Freezer(const Process& process);
+  Freezer(const Freezer&) = delete;
+  Freezer& operator=(const Freezer&) = delete;
+  ~Freezer();
+
+  // Keeps writing `value` to `address` until Unfreeze() is called with the returned id. Callable from any thread; the
+  // change takes effect at the next tick.
+  uint32_t Freeze(uintptr_t address, const ScanValue& value);
+  void Unfreeze(uint32_t id);
+
+  // Writes every frozen value once. Must not run concurrently with itself.
+  void Tick() { RunTick(std::chrono::steady_clock::now()); }
+
+  // Ticks on the freezer thread every `period` until Stop().
+  void Start(std::chrono::nanoseconds period);
+  void Stop();
+
+  FreezeStats stats() const;
+
+ private:
+  struct Entry {
+    uintptr_t address{};
+    uint32_t id{};
+    ScanValue value;
+  };
+
+  // One merged write of `size` bytes from `bytes_[offset]` to `address`.
+  struct Run {
+    uintptr_t address{};
+    size_t offset{};
+    size_t size{};
+  };
+
+  void ApplyChanges();
+  void BuildRuns();
+  void RunTick(std::chrono::steady_clock::time_point due);
+  void TickLoop(std::chrono::nanoseconds period);
+
+  const Process& process_;
+
+  // Owned by the ticking thread.
+  std::vector<Entry> entries_;
+  std::vector<Run> runs_;
+  std::vector<std::byte> bytes_;
+
+  // Requests from other threads, guarded by `mutex_`.
+  std::mutex mutex_;
+  std::vector<Entry> added_;
+  std::vector<uint32_t> removed_;
+  uint32_t next_id_{};
+  std::atomic<bool> changed_{};
+
+  std::thread thread_;
+  // Event that wakes the freezer thread for Stop().
+  void* stop_event_{};
+
+  std::atomic<uint64_t> ticks_{};
+  std::atomic<uint64_t> write_calls_{};
+  std::atomic<uint64_t> failed_writes_{};
+  std::atomic<int64_t> last_latency_ns_{};
+  std::atomic<int64_t> max_latency_ns_{};
+  std::atomic<int64_t> total_latency_ns_{};
+};
+
+}  // namespace maia
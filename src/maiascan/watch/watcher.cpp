@@ -0,0 +1,149 @@
+#include "maiascan/watch/watcher.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "maiascan/core/bits.hpp"
+
+namespace maia {
+
+Watcher::Watcher(const Process& process, size_t queue_capacity)
+    : reader_(process, 1), updates_(queue_capacity) {}
+
+Watcher::~Watcher() { Stop(); }
+
+uint32_t Watcher::Add(uintptr_t address, ValueType type) {
+  std::lock_guard lock(mutex_);
+  const uint32_t id = next_id_++;
+  added_.push_back({.address = address, .id = id, .type = type});
+  changed_.store(true, std::memory_order_release);
+  return id;
+}
+
+void Watcher::Remove(uint32_t id) {
+  std::lock_guard lock(mutex_);
+  removed_.push_back(id);
+  changed_.store(true, std::memory_order_release);
+}
+
+void Watcher::ApplyChanges() {
+  std::vector<Watch> added;
+  std::vector<uint32_t> removed;
+  {
+    std::lock_guard lock(mutex_);
+    added.swap(added_);
+    removed.swap(removed_);
+  }
+  // Adds go first so that a watch removed before its first tick never shows up.
+  watches_.insert(watches_.end(), added.begin(), added.end());
+  std::sort(removed.begin(), removed.end());
+  std::erase_if(watches_,
+                [&](const Watch& watch) { return std::binary_search(removed.begin(), removed.end(), watch.id); });
+  std::sort(watches_.begin(), watches_.end(), [](const Watch& a, const Watch& b) {
+    return a.address != b.address ? a.address < b.address : a.id < b.id;
+  });
+  BuildSpans();
+}
+
+void Watcher::BuildSpans() {
+  spans_.clear();
+  for (size_t i = 0; i < watches_.size(); ++i) {
+    const uintptr_t first_page = watches_[i].address / kPageSize;
+    const uintptr_t last_page = (watches_[i].address + SizeOf(watches_[i].type) - 1) / kPageSize;
+    if (spans_.empty() || last_page - spans_.back().base / kPageSize >= kSpanPages) {
+      spans_.push_back({.base = first_page * kPageSize, .size = 0, .first = i, .last = i, .pages = 0});
+    }
+    Span& span = spans_.back();
+    const uintptr_t span_page = span.base / kPageSize;
+    span.last = i + 1;
+    span.size = std::max(span.size, (last_page - span_page + 1) * kPageSize);
+    span.pages |= uint64_t{1} << (first_page - span_page);
+    span.pages |= uint64_t{1} << (last_page - span_page);
+  }
+}
+
+void Watcher::Tick() {
+  const auto start = std::chrono::steady_clock::now();
+  if (changed_.exchange(false, std::memory_order_acquire)) {
+    ApplyChanges();
+  }
+  ++tick_;
+
+  const uint64_t calls_at_start = reader_.stats().calls;
+  uint64_t published = 0;
+  uint64_t deferred = 0;
+  for (const Span& span : spans_) {
+    uint64_t pages = span.pages;
+    const auto data = reader_.ReadPages(0, span.base, span.size, &pages);
+    for (size_t i = span.first; i < span.last; ++i) {
+      Watch& watch = watches_[i];
+      const size_t size = SizeOf(watch.type);
+      const size_t offset = watch.address - span.base;
+      const bool readable = !data.empty() && TestBit(&pages, offset / kPageSize) &&
+                            TestBit(&pages, (offset + size - 1) / kPageSize);
+      const std::byte* current = readable ? data.data() + offset : watch.last.data();
+      if (watch.published && readable == watch.readable && std::memcmp(current, watch.last.data(), size) == 0) {
+        continue;
+      }
+      WatchUpdate update{.id = watch.id, .readable = readable, .value = {.type = watch.type}, .tick = tick_};
+      std::memcpy(update.value.bytes.data(), current, size);
+      if (!updates_.TryPush(update)) {
+        // Leave the watch as it was so that the next tick notices the change again.
+        ++deferred;
+        continue;
+      }
+      watch.published = true;
+      watch.readable = readable;
+      std::memcpy(watch.last.data(), current, size);
+      ++published;
+    }
+  }
+
+  ticks_.store(tick_, std::memory_order_relaxed);
+  read_calls_.store(reader_.stats().calls - calls_at_start, std::memory_order_relaxed);
+  published_.fetch_add(published, std::memory_order_relaxed);
+  deferred_.fetch_add(deferred, std::memory_order_relaxed);
+  last_tick_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                          .count(),
+                      std::memory_order_relaxed);
+}
+
+void Watcher::Start(std::chrono::nanoseconds period) {
+  Stop();
+  stopping_ = false;
+  thread_ = std::thread([this, period] { TickLoop(period); });
+}
+
+void Watcher::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  stop_.notify_all();
+  thread_.join();
+}
+
+void Watcher::TickLoop(std::chrono::nanoseconds period) {
+  auto next = std::chrono::steady_clock::now();
+  while (true) {
+    Tick();
+    next = std::max(next + period, std::chrono::steady_clock::now());
+    std::unique_lock lock(mutex_);
+    if (stop_.wait_until(lock, next, [this] { return stopping_; })) {
+      return;
+    }
+  }
+}
+
+WatchStats Watcher::stats() const {
+  return {.ticks = ticks_.load(std::memory_order_relaxed),
+          .read_calls = read_calls_.load(std::memory_order_relaxed),
+          .published = published_.load(std::memory_order_relaxed),
+          .deferred = deferred_.load(std::memory_order_relaxed),
+          .last_tick = std::chrono::nanoseconds(last_tick_ns_.load(std::memory_order_relaxed))};
+}
+
+}  // namespace maia
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "maiascan/core/memory_reader.hpp"
+#include "maiascan/core/process.hpp"
+#include "maiascan/core/spsc_ring.hpp"
+#include "maiascan/scan/value.hpp"
+
+namespace maia {
+
+// A watched value that differs from what was last published for it.
+struct WatchUpdate {
+  uint32_t id{};
+  // False when the value could not be read; `value` then still holds the last value that could.
+  bool readable{};
+  ScanValue value;
+  // Tick that observed the change, counted from 1.
+  uint64_t tick{};
+};
+
+struct WatchStats {
+  uint64_t ticks{};
+  // ReadProcessMemory calls of the latest tick.
+  uint64_t read_calls{};
+  uint64_t published{};
+  // Changes that found the update queue full. They are not lost: the next tick sees the same change and tries again.
+  uint64_t deferred{};
+  std::chrono::nanoseconds last_tick{};
+};
+
+// Keeps a set of addresses under observation and reports the values that change. Watches are grouped into spans of
+// nearby pages and every tick fetches each span's selected pages with as few reads as possible, so thousands of
+// watches typically cost a handful of ReadProcessMemory calls per tick rather than one each.
+//
+// Changes travel to the consumer through a lock-free single-producer ring: ticks run on one thread (the one of
+// Start(), or the caller's) and Poll() on one other, typically the UI or CLI thread. Add() and Remove() may be called
+// from any thread and take effect at the next tick; the first tick after Add() always publishes the value.
+class Watcher {
+ public:
+  static constexpr size_t kDefaultQueueCapacity = size_t{1} << 14;
+
+  // Watches whose pages fall within this many pages of the first page of a span share that span; a span is read with
+  // MemoryReader::ReadPages(), so unwatched pages inside it are only fetched when they bridge a short gap.
+  static constexpr size_t kSpanPages = 64;
+
+  explicit Watcher(const Process& process, size_t queue_capacity = kDefaultQueueCapacity);
+  Watcher(const Watcher&) = delete;
+  Watcher& operator=(const Watcher&) = delete;
+  ~Watcher();
+
+  // Returns the id that updates for the new watch carry.
+  uint32_t Add(uintptr_t address, ValueType type);
+
+  // Updates already queued for `id` are still delivered.
+  void Remove(uint32_t id);
+
+  // Refreshes every watch once and publishes those that changed. Must not run concurrently with itself.
+  void Tick();
+
+  // Ticks on a thread of the watcher every `period` until Stop(). Ticks that overrun the period delay the next one
+  // instead of piling up.
+  void Start(std::chrono::nanoseconds period);
+  void Stop();
+
+  // Moves pending updates into `out`, oldest first, and returns how many there were. Single consumer only.
+  size_t Poll(std::span<WatchUpdate> out) { return updates_.PopBatch(out); }
+
+  WatchStats stats() const;
+
+ private:
+  struct Watch {
+    uintptr_t address{};
+    uint32_t id{};
+    ValueType type{};
+    bool published{};
+    bool readable{};
+    std::array<std::byte, 8> last{};
+  };
+
+  // Watches [first, last) of `watches_`, all within `size` bytes from the page-aligned `base`.
+  struct Span {
+    uintptr_t base{};
+    size_t size{};
+    size_t first{};
+    size_t last{};
+    // One bit per page of the span that holds part of a watched value.
+    uint64_t pages{};
+  };
+
+  void ApplyChanges();
+  void BuildSpans();
+  void TickLoop(std::chrono::nanoseconds period);
+
+  MemoryReader reader_;
+  SpscRing<WatchUpdate> updates_;
+
+  // Owned by the ticking thread.
+  std::vector<Watch> watches_;
+  std::vector<Span> spans_;
+  uint64_t tick_{};
+
+  // Requests from other threads, guarded by `mutex_`.
+  std::mutex mutex_;
+  std::vector<Watch> added_;
+  std::vector<uint32_t> removed_;
+  uint32_t next_id_{};
+  std::atomic<bool> changed_{};
+
+  std::thread thread_;
+  std::condition_variable stop_;
+  bool stopping_{};
+
+  std::atomic<uint64_t> ticks_{};
+  std::atomic<uint64_t> read_calls_{};
+  std::atomic<uint64_t> published_{};
+  std::atomic<uint64_t> deferred_{};
+  std::atomic<int64_t> last_tick_ns_{};
+};
+
+}  // namespace maia
@@ -0,0 +1,159 @@
+#include "maiascan/scan/candidates.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace maia {
+namespace {
+
+constexpr uintptr_t kBase = 0x10000;
+
+std::vector<uint64_t> BitsOf(const std::vector<size_t>& slots, size_t slot_count) {
+  std::vector<uint64_t> bits(WordCount(slot_count));
+  for (const size_t slot : slots) {
+    SetBit(bits.data(), slot);
+  }
+  return bits;
+}
+
+std::vector<size_t> SlotsOf(const CandidateBlock& block) {
+  std::vector<size_t> slots;
+  block.ForEachSlot([&](size_t slot) { slots.push_back(slot); });
+  return slots;
+}
+
+std::vector<size_t> EverySlot(size_t slot_count, size_t step) {
+  std::vector<size_t> slots;
+  for (size_t slot = 0; slot < slot_count; slot += step) {
+    slots.push_back(slot);
+  }
+  return slots;
+}
+
+class CandidateBlockTest : public testing::Test {
+ protected:
+  CandidateBlock Build(const std::vector<size_t>& slots, size_t slot_count) {
+    const auto bits = BitsOf(slots, slot_count);
+    return CandidateBlock::FromBits(kBase, static_cast<uint32_t>(slot_count), bits.data(), arena_, 0);
+  }
+
+  Arena arena_{1};
+};
+
+TEST_F(CandidateBlockTest, AllSlotsNeedNoStorage) {
+  const CandidateBlock block = Build(EverySlot(100, 1), 100);
+  EXPECT_EQ(block.encoding(), CandidateBlock::Encoding::kAll);
+  EXPECT_EQ(block.count(), 100);
+  EXPECT_EQ(block.memory_usage(), 0);
+  EXPECT_EQ(SlotsOf(block), EverySlot(100, 1));
+}
+
+TEST_F(CandidateBlockTest, NoSlotsIsEmpty) {
+  const CandidateBlock block = Build({}, 1000);
+  EXPECT_TRUE(block.empty());
+  EXPECT_EQ(block.memory_usage(), 0);
+  EXPECT_TRUE(SlotsOf(block).empty());
+}
+
+TEST_F(CandidateBlockTest, SparseSlotsUseDeltas) {
+  const std::vector<size_t> slots = {3, 4, 900, 1'000'000, 1'048'575};
+  const CandidateBlock block = Build(slots, 1 << 20);
+  EXPECT_EQ(block.encoding(), CandidateBlock::Encoding::kDeltas);
+  EXPECT_EQ(block.count(), slots.size());
+  EXPECT_LT(block.memory_usage(), 16);
+  EXPECT_EQ(SlotsOf(block), slots);
+}
+
+TEST_F(CandidateBlockTest, DenseSlotsUseBitmap) {
+  const auto slots = EverySlot(1000, 2);
+  const CandidateBlock block = Build(slots, 1000);
+  EXPECT_EQ(block.encoding(), CandidateBlock::Encoding::kBitmap);
+  EXPECT_EQ(block.count(), slots.size());
+  EXPECT_EQ(block.memory_usage(), WordCount(1000) * sizeof(uint64_t));
+  EXPECT_EQ(SlotsOf(block), slots);
+}
+
+TEST_F(CandidateBlockTest, SwitchesEncodingWithDensity) {
+  // Deltas cost about a byte per candidate and the bitmap a bit per slot, so the switch happens near one in eight.
+  constexpr size_t kSlots = 4096;
+  EXPECT_EQ(Build(EverySlot(kSlots, 64), kSlots).encoding(), CandidateBlock::Encoding::kDeltas);
+  EXPECT_EQ(Build(EverySlot(kSlots, 4), kSlots).encoding(), CandidateBlock::Encoding::kBitmap);
+  for (const size_t step : {1, 2, 3, 5, 7, 8, 9, 16, 100, 4095}) {
+    const auto slots = EverySlot(kSlots, step);
+    const CandidateBlock block = Build(slots, kSlots);
+    EXPECT_EQ(SlotsOf(block), slots) << "step " << step;
+    EXPECT_LE(block.memory_usage(), WordCount(kSlots) * sizeof(uint64_t)) << "step " << step;
+  }
+}
+
+TEST_F(CandidateBlockTest, IgnoresBitsPastTheLastSlot) {
+  std::vector<uint64_t> bits(2, ~uint64_t{0});
+  ClearBit(bits.data(), 5);
+  const CandidateBlock block = CandidateBlock::FromBits(kBase, 70, bits.data(), arena_, 0);
+  EXPECT_EQ(block.count(), 69);
+  const auto slots = SlotsOf(block);
+  ASSERT_EQ(slots.size(), 69);
+  EXPECT_EQ(slots.back(), 69);
+}
+
+TEST_F(CandidateBlockTest, StopsWalkWhenAsked) {
+  const CandidateBlock block = Build(EverySlot(1000, 3), 1000);
+  size_t visited = 0;
+  EXPECT_FALSE(block.ForEachSlot([&](size_t) { return ++visited < 10; }));
+  EXPECT_EQ(visited, 10);
+}
+
+TEST_F(CandidateBlockTest, RebuildsFromEncodedBytes) {
+  for (const size_t step : {1, 2, 50}) {
+    const CandidateBlock block = Build(EverySlot(3000, step), 3000);
+    Arena other(1);
+    const CandidateBlock copy = CandidateBlock::FromEncoded(block.base(),
+                                                            block.slot_count(),
+                                                            static_cast<uint32_t>(block.count()),
+                                                            block.encoding(),
+                                                            block.encoded(),
+                                                            other,
+                                                            0);
+    EXPECT_EQ(copy.encoding(), block.encoding()) << "step " << step;
+    EXPECT_EQ(copy.count(), block.count()) << "step " << step;
+    EXPECT_EQ(SlotsOf(copy), SlotsOf(block)) << "step " << step;
+  }
+}
+
+TEST(CandidateSetTest, WalksAddressesOnTheStride) {
+  auto arena = std::make_shared<Arena>(1);
+  const auto bits = BitsOf({1, 5}, 8);
+  CandidateSet candidates{.type = ValueType::kInt64, .stride = 8, .blocks = {}, .arena = arena};
+  candidates.blocks.push_back(CandidateBlock::FromBits(kBase, 8, bits.data(), *arena, 0));
+  candidates.blocks.push_back(CandidateBlock::All(kBase + 0x1000, 2));
+  EXPECT_EQ(candidates.count(), 4);
+
+  std::vector<uintptr_t> addresses;
+  candidates.ForEachAddress([&](uintptr_t address) { addresses.push_back(address); });
+  EXPECT_EQ(addresses, (std::vector<uintptr_t>{kBase + 8, kBase + 40, kBase + 0x1000, kBase + 0x1008}));
+}
+
+TEST(CandidatePagerTest, ReadsPagesByRank) {
+  Arena arena(1);
+  CandidatePager pager(4);
+  const auto bits = BitsOf(EverySlot(640, 10), 640);
+  pager.Append(CandidateBlock::All(0x1000, 3));
+  pager.Append(CandidateBlock::All(0x2000, 0));
+  pager.Append(CandidateBlock::FromBits(0x3000, 640, bits.data(), arena, 0));
+  ASSERT_EQ(pager.size(), 3 + 64);
+
+  std::array<uintptr_t, 4> page{};
+  ASSERT_EQ(pager.Read(1, page), 4);
+  EXPECT_EQ(page, (std::array<uintptr_t, 4>{0x1004, 0x1008, 0x3000, 0x3028}));
+  EXPECT_EQ(pager.Read(3 + 62, page), 2);
+  EXPECT_EQ(page[0], 0x3000 + 620 * 4);
+  EXPECT_EQ(page[1], 0x3000 + 630 * 4);
+  EXPECT_EQ(pager.Read(pager.size(), page), 0);
+}
+
+}  // namespace
+}  // namespace maia
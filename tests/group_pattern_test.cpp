@@ -0,0 +1,81 @@
+#include "maiascan/scan/group_pattern.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "maiascan/core/bits.hpp"
+
+namespace maia {
+namespace {
+
+template <typename T>
+void Store(std::vector<std::byte>& data, size_t offset, T value) {
+  std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+TEST(GroupPatternTest, PlacesFieldsBackToBack) {
+  const auto pattern = GroupPattern::Parse("f32:100 f32:100 i32:42");
+  ASSERT_TRUE(pattern);
+  ASSERT_EQ(pattern->fields().size(), 3);
+  EXPECT_EQ(pattern->fields()[1].offset, 4);
+  EXPECT_EQ(pattern->fields()[2].offset, 8);
+  EXPECT_EQ(pattern->size(), 12);
+  EXPECT_EQ(pattern->first().type, ValueType::kFloat);
+}
+
+TEST(GroupPatternTest, PlacesFieldsAtExplicitOffsets) {
+  const auto pattern = GroupPattern::Parse("i32:1 +0x10 i64:2 +6 u8:3");
+  ASSERT_TRUE(pattern);
+  ASSERT_EQ(pattern->fields().size(), 3);
+  EXPECT_EQ(pattern->fields()[1].offset, 0x10);
+  EXPECT_EQ(pattern->fields()[2].offset, 6);
+  EXPECT_EQ(pattern->size(), 0x18);
+  EXPECT_EQ(pattern->ToString(), "i32:1 +0x10 i64:2 +0x6 u8:3");
+}
+
+TEST(GroupPatternTest, ParsesRanges) {
+  const auto pattern = GroupPattern::Parse("u16:10..20");
+  ASSERT_TRUE(pattern);
+  EXPECT_TRUE(pattern->first().range);
+  EXPECT_EQ(pattern->ToString(), "u16:10..20");
+}
+
+TEST(GroupPatternTest, RejectsMalformedPatterns) {
+  EXPECT_FALSE(GroupPattern::Parse(""));
+  EXPECT_FALSE(GroupPattern::Parse("i32"));
+  EXPECT_FALSE(GroupPattern::Parse("x32:1"));
+  EXPECT_FALSE(GroupPattern::Parse("i32:abc"));
+  EXPECT_FALSE(GroupPattern::Parse("+4 i32:1"));
+  EXPECT_FALSE(GroupPattern::Parse("i32:1 +4"));
+  EXPECT_FALSE(GroupPattern::Parse("i32:1 +4 +8 i32:2"));
+  EXPECT_FALSE(GroupPattern::Parse("i32:1 +zz i32:2"));
+  EXPECT_FALSE(GroupPattern::Parse("i32:1..x"));
+}
+
+TEST(GroupPatternTest, MatchesOnlyWholeGroups) {
+  const auto pattern = GroupPattern::Parse("i32:7 +8 f32:1.5");
+  ASSERT_TRUE(pattern);
+  constexpr size_t kSlots = 5000;
+  std::vector<std::byte> data(kSlots * 4 + pattern->size());
+  std::vector<size_t> expected;
+  for (size_t slot = 0; slot < kSlots; slot += 37) {
+    Store<int32_t>(data, slot * 4, 7);
+    // Every other group is missing its second field.
+    if (slot % 2 == 0) {
+      Store<float>(data, slot * 4 + 8, 1.5F);
+      expected.push_back(slot);
+    }
+  }
+
+  std::vector<uint64_t> bits(WordCount(kSlots));
+  FindGroupMatches(data.data(), kSlots, 4, *pattern, bits.data());
+  std::vector<size_t> slots;
+  ForEachSetBit(bits.data(), kSlots, [&](size_t slot) { slots.push_back(slot); });
+  EXPECT_EQ(slots, expected);
+}
+
+}  // namespace
+}  // namespace maia
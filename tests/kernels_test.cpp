@@ -0,0 +1,122 @@
+#include "maiascan/scan/kernels.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "maiascan/core/bits.hpp"
+#include "maiascan/core/cpu_features.hpp"
+
+namespace maia {
+namespace {
+
+std::vector<KernelIsa> SupportedIsas() {
+  std::vector<KernelIsa> isas = {KernelIsa::kScalar};
+  if (GetCpuFeatures().sse41) {
+    isas.push_back(KernelIsa::kSse41);
+  }
+  if (GetCpuFeatures().avx2) {
+    isas.push_back(KernelIsa::kAvx2);
+  }
+  return isas;
+}
+
+template <typename T>
+std::vector<size_t> FindNaive(const std::vector<std::byte>& data, size_t slot_count, size_t stride, T lower, T upper) {
+  std::vector<size_t> slots;
+  for (size_t slot = 0; slot < slot_count; ++slot) {
+    T value;
+    std::memcpy(&value, data.data() + slot * stride, sizeof(T));
+    if (value >= lower && value <= upper) {
+      slots.push_back(slot);
+    }
+  }
+  return slots;
+}
+
+std::vector<size_t> Find(KernelIsa isa,
+                         const std::vector<std::byte>& data,
+                         size_t slot_count,
+                         size_t stride,
+                         const MatchPredicate& predicate) {
+  // Every bit starts out set, so kernels that leave non-matching slots alone do not go unnoticed.
+  std::vector<uint64_t> bits(WordCount(slot_count), ~uint64_t{0});
+  FindMatches(isa, data.data(), slot_count, stride, predicate, bits.data());
+  std::vector<size_t> slots;
+  ForEachSetBit(bits.data(), slot_count, [&](size_t slot) { slots.push_back(slot); });
+  return slots;
+}
+
+// Values drawn from a handful of small integers, so that every predicate matches a good share of the slots at every
+// phase of every stride.
+template <typename T>
+std::vector<std::byte> RandomData(size_t size, std::mt19937& random) {
+  std::vector<std::byte> data(size);
+  for (size_t offset = 0; offset + sizeof(T) <= size; offset += sizeof(T)) {
+    const T value = static_cast<T>(random() % 4);
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+  }
+  return data;
+}
+
+template <typename T>
+void ExpectKernelsMatchNaive(ValueType type) {
+  std::mt19937 random(4);
+  for (size_t stride = 1; stride <= 80; ++stride) {
+    for (const size_t slot_count : {1, 63, 64, 65, 200, 1000}) {
+      const auto data = RandomData<T>((slot_count - 1) * stride + sizeof(T), random);
+      const T one = 1;
+      const T two = 2;
+      const ScanValue exact = ScanValue::From(type, one);
+      const ScanValue upper = ScanValue::From(type, two);
+      const auto expected_exact = FindNaive<T>(data, slot_count, stride, one, one);
+      const auto expected_range = FindNaive<T>(data, slot_count, stride, one, two);
+      for (const KernelIsa isa : SupportedIsas()) {
+        EXPECT_EQ(Find(isa, data, slot_count, stride, MakeExactPredicate(exact)), expected_exact)
+            << ToString(type) << ", stride " << stride << ", " << slot_count << " slots, " << ToString(isa);
+        EXPECT_EQ(Find(isa, data, slot_count, stride, MakeRangePredicate(exact, upper)), expected_range)
+            << ToString(type) << ", stride " << stride << ", " << slot_count << " slots, " << ToString(isa);
+      }
+    }
+  }
+}
+
+TEST(KernelsTest, MatchNaiveScanAtEveryStride) {
+  ExpectKernelsMatchNaive<int8_t>(ValueType::kInt8);
+  ExpectKernelsMatchNaive<uint16_t>(ValueType::kUInt16);
+  ExpectKernelsMatchNaive<int32_t>(ValueType::kInt32);
+  ExpectKernelsMatchNaive<uint64_t>(ValueType::kUInt64);
+  ExpectKernelsMatchNaive<float>(ValueType::kFloat);
+  ExpectKernelsMatchNaive<double>(ValueType::kDouble);
+}
+
+TEST(KernelsTest, FindsValueAtStructStrides) {
+  // One int32 planted at slot 100 of a struct array of each stride, in an otherwise zero buffer.
+  for (const size_t stride : {3, 4, 6, 12, 16, 24, 48}) {
+    std::vector<std::byte> data(200 * stride + sizeof(int32_t));
+    const int32_t value = 42;
+    std::memcpy(data.data() + 100 * stride, &value, sizeof(value));
+    const MatchPredicate predicate = MakeExactPredicate(ScanValue::From(ValueType::kInt32, value));
+    for (const KernelIsa isa : SupportedIsas()) {
+      EXPECT_EQ(Find(isa, data, 200, stride, predicate), std::vector<size_t>{100})
+          << "stride " << stride << ", " << ToString(isa);
+    }
+  }
+}
+
+TEST(KernelsTest, FloatRangesAcceptBothZerosAndRejectNan) {
+  const float values[] = {0.0F, -0.0F, std::numeric_limits<float>::quiet_NaN(), 0.5F, 2.0F};
+  std::vector<std::byte> data(sizeof(values));
+  std::memcpy(data.data(), values, sizeof(values));
+  const MatchPredicate predicate = MakeExactPredicate(ScanValue::From(ValueType::kFloat, 0.0F), 0.5);
+  for (const KernelIsa isa : SupportedIsas()) {
+    EXPECT_EQ(Find(isa, data, 5, sizeof(float), predicate), (std::vector<size_t>{0, 1, 3})) << ToString(isa);
+  }
+}
+
+}  // namespace
+}  // namespace maia
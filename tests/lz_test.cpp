@@ -0,0 +1,94 @@
+#include "maiascan/core/lz.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace maia {
+namespace {
+
+std::vector<uint8_t> RoundTrip(const std::vector<uint8_t>& input) {
+  std::vector<uint8_t> compressed;
+  LzCompress(input, compressed);
+  std::vector<uint8_t> output(input.size());
+  EXPECT_TRUE(LzDecompress(compressed, output));
+  return output;
+}
+
+TEST(LzTest, RoundTripsEmptyAndShortInput) {
+  for (size_t size = 0; size < 32; ++size) {
+    std::vector<uint8_t> input(size);
+    for (size_t i = 0; i < size; ++i) {
+      input[i] = static_cast<uint8_t>(i * 7);
+    }
+    EXPECT_EQ(RoundTrip(input), input) << "size " << size;
+  }
+}
+
+TEST(LzTest, RoundTripsRandomData) {
+  std::mt19937 random(1);
+  std::vector<uint8_t> input(100'000);
+  for (auto& byte : input) {
+    byte = static_cast<uint8_t>(random());
+  }
+  EXPECT_EQ(RoundTrip(input), input);
+}
+
+TEST(LzTest, CompressesRunsAndRepeats) {
+  // Zero runs with a repeating record in between, like a sparse bitmap or a snapshot of a struct array.
+  std::vector<uint8_t> input(1 << 20);
+  for (size_t i = 0; i < input.size(); i += 4096) {
+    for (size_t j = 0; j < 16; ++j) {
+      input[i + j] = static_cast<uint8_t>(0xA0 + j);
+    }
+  }
+  std::vector<uint8_t> compressed;
+  LzCompress(input, compressed);
+  EXPECT_LT(compressed.size(), input.size() / 100);
+  std::vector<uint8_t> output(input.size());
+  ASSERT_TRUE(LzDecompress(compressed, output));
+  EXPECT_EQ(output, input);
+}
+
+TEST(LzTest, AppendsToExistingOutput) {
+  const std::vector<uint8_t> input(1000, 42);
+  std::vector<uint8_t> compressed = {1, 2, 3};
+  LzCompress(input, compressed);
+  ASSERT_GT(compressed.size(), 3);
+  EXPECT_EQ(compressed[0], 1);
+  std::vector<uint8_t> output(input.size());
+  ASSERT_TRUE(LzDecompress({compressed.data() + 3, compressed.size() - 3}, output));
+  EXPECT_EQ(output, input);
+}
+
+TEST(LzTest, RejectsWrongSizeAndCorruptInput) {
+  std::vector<uint8_t> input(5000);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<uint8_t>(i % 251);
+  }
+  std::vector<uint8_t> compressed;
+  LzCompress(input, compressed);
+
+  std::vector<uint8_t> shorter(input.size() - 1);
+  EXPECT_FALSE(LzDecompress(compressed, shorter));
+  std::vector<uint8_t> longer(input.size() + 1);
+  EXPECT_FALSE(LzDecompress(compressed, longer));
+  std::vector<uint8_t> output(input.size());
+  EXPECT_FALSE(LzDecompress({compressed.data(), compressed.size() / 2}, output));
+
+  // Garbage must be rejected or decoded within bounds, never read or written past either buffer.
+  std::mt19937 random(2);
+  for (int round = 0; round < 1000; ++round) {
+    std::vector<uint8_t> garbage(random() % 64);
+    for (auto& byte : garbage) {
+      byte = static_cast<uint8_t>(random());
+    }
+    std::vector<uint8_t> out(random() % 256);
+    LzDecompress(garbage, out);
+  }
+}
+
+}  // namespace
+}  // namespace maia
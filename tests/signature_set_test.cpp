@@ -0,0 +1,126 @@
+#include "maiascan/scan/signature_set.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace maia {
+namespace {
+
+using Matches = std::vector<std::pair<size_t, uint32_t>>;
+
+Matches Find(const SignatureSet& set, const std::vector<std::byte>& data, size_t limit) {
+  std::vector<SignatureMatch> found;
+  set.Find(data.data(), data.size(), limit, found);
+  Matches matches;
+  for (const SignatureMatch& match : found) {
+    matches.emplace_back(match.offset, match.signature);
+  }
+  std::sort(matches.begin(), matches.end());
+  return matches;
+}
+
+// Runs every signature of `set` on its own through FindSignature().
+Matches FindEachAlone(const SignatureSet& set, const std::vector<std::byte>& data, size_t limit) {
+  Matches matches;
+  for (size_t i = 0; i < set.size(); ++i) {
+    std::vector<size_t> offsets;
+    FindSignature(KernelIsa::kScalar, data.data(), data.size(), set[i], offsets);
+    for (const size_t offset : offsets) {
+      if (offset < limit) {
+        matches.emplace_back(offset, static_cast<uint32_t>(i));
+      }
+    }
+  }
+  std::sort(matches.begin(), matches.end());
+  return matches;
+}
+
+std::filesystem::path WriteFile(std::string_view name, std::string_view contents) {
+  const auto path = std::filesystem::path(testing::TempDir()) / name;
+  std::ofstream(path) << contents;
+  return path;
+}
+
+TEST(SignatureSetTest, AgreesWithEachSignatureAlone) {
+  // Pair anchors, single-byte anchors between wildcards, a one-byte signature that can match on the last byte of the
+  // data, and anchors deep into their signature, so that matches starting just before `limit` are only seen once
+  // the scan has run past it.
+  const std::vector<const char*> texts = {"00 01", "01 ?? 02", "?? 02 ?? 00", "03", "00 ?? ?? ?? ?? ?? ?? ?? 03 03",
+                                          "?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? 02", "01 01 01", "01 02 ?? 03 ?? ?? 00"};
+  std::vector<Signature> signatures;
+  for (const char* text : texts) {
+    auto signature = Signature::Parse(text);
+    ASSERT_TRUE(signature) << text;
+    signatures.push_back(std::move(*signature));
+  }
+  const SignatureSet set(signatures);
+  EXPECT_EQ(set.size(), texts.size());
+  EXPECT_EQ(set.max_size(), 13);
+
+  std::mt19937 random(6);
+  for (const size_t size : {0, 1, 2, 3, 12, 13, 14, 100, 1000}) {
+    for (int round = 0; round < 4; ++round) {
+      std::vector<std::byte> data(size);
+      for (auto& byte : data) {
+        byte = std::byte{static_cast<uint8_t>(random() % 5)};
+      }
+      for (const size_t limit : {size_t{0}, size_t{1}, size / 2, size - std::min<size_t>(size, 1), size, size + 20}) {
+        EXPECT_EQ(Find(set, data, limit), FindEachAlone(set, data, limit)) << "size " << size << ", limit " << limit;
+      }
+    }
+  }
+}
+
+TEST(SignatureSetTest, FindsSingleByteAnchorOnTheLastByte) {
+  auto signature = Signature::Parse("?? 7F");
+  ASSERT_TRUE(signature);
+  const SignatureSet set({std::move(*signature)});
+  const std::vector<std::byte> data = {std::byte{0x7F}, std::byte{0}, std::byte{0x7F}};
+  EXPECT_EQ(Find(set, data, data.size()), (Matches{{1, 0}}));
+  // The match starts at 1 but its anchor sits at 2, past the limit.
+  EXPECT_EQ(Find(set, data, 2), (Matches{{1, 0}}));
+  EXPECT_TRUE(Find(set, data, 1).empty());
+}
+
+TEST(SignatureSetTest, LoadsNamedSignatures) {
+  const auto signatures = LoadSignatureFile(WriteFile(
+      "signatures.json", R"([{"name": "hp", "pattern": "48 8b ?? 3d"}, {"name": "ammo", "pattern": "e8 ??"}])"));
+  ASSERT_TRUE(signatures);
+  ASSERT_EQ(signatures->size(), 2);
+  EXPECT_EQ((*signatures)[0].name, "hp");
+  EXPECT_EQ((*signatures)[0].signature.ToString(), "48 8B ?? 3D");
+  EXPECT_EQ((*signatures)[1].name, "ammo");
+  EXPECT_EQ((*signatures)[1].signature.ToString(), "E8 ??");
+
+  const auto empty = LoadSignatureFile(WriteFile("empty.json", "[]"));
+  ASSERT_TRUE(empty);
+  EXPECT_TRUE(empty->empty());
+}
+
+TEST(SignatureSetTest, RejectsMalformedSignatureFiles) {
+  EXPECT_FALSE(LoadSignatureFile(std::filesystem::path(testing::TempDir()) / "missing.json"));
+  for (const std::string_view contents : {
+           std::string_view(R"([{"name": "a", "pattern": "01"})"),
+           std::string_view(R"({"name": "a", "pattern": "01"})"),
+           std::string_view(R"(["01"])"),
+           std::string_view(R"([{"pattern": "01"}])"),
+           std::string_view(R"([{"name": "a"}])"),
+           std::string_view(R"([{"name": 1, "pattern": "01"}])"),
+           std::string_view(R"([{"name": "a", "pattern": 1}])"),
+           std::string_view(R"([{"name": "a", "pattern": "01"}, {"name": "b", "pattern": "?? ??"}])"),
+           std::string_view(R"([{"name": "a", "pattern": "0G"}])"),
+       }) {
+    EXPECT_FALSE(LoadSignatureFile(WriteFile("malformed.json", contents))) << contents;
+  }
+}
+
+}  // namespace
+}  // namespace maia
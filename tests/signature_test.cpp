@@ -0,0 +1,104 @@
+#include "maiascan/scan/signature.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "maiascan/core/cpu_features.hpp"
+
+namespace maia {
+namespace {
+
+std::vector<KernelIsa> SupportedIsas() {
+  std::vector<KernelIsa> isas = {KernelIsa::kScalar};
+  if (GetCpuFeatures().sse41) {
+    isas.push_back(KernelIsa::kSse41);
+  }
+  if (GetCpuFeatures().avx2) {
+    isas.push_back(KernelIsa::kAvx2);
+  }
+  return isas;
+}
+
+std::vector<size_t> FindNaive(const std::vector<std::byte>& data, const Signature& signature) {
+  std::vector<size_t> offsets;
+  for (size_t offset = 0; offset + signature.size() <= data.size(); ++offset) {
+    if (signature.MatchesAt(data.data() + offset)) {
+      offsets.push_back(offset);
+    }
+  }
+  return offsets;
+}
+
+TEST(SignatureTest, ParsesBytesAndWildcards) {
+  const auto signature = Signature::Parse("48 8b ?? ? 89");
+  ASSERT_TRUE(signature);
+  EXPECT_EQ(signature->size(), 5);
+  EXPECT_EQ(signature->ToString(), "48 8B ?? ?? 89");
+  EXPECT_EQ(signature->padded_size() % Signature::kPadding, 0);
+  EXPECT_EQ(signature->padded_mask()[2], std::byte{});
+  EXPECT_EQ(signature->padded_mask()[4], std::byte{0xFF});
+  EXPECT_EQ(signature->padded_mask()[5], std::byte{});
+}
+
+TEST(SignatureTest, RejectsMalformedPatterns) {
+  EXPECT_FALSE(Signature::Parse(""));
+  EXPECT_FALSE(Signature::Parse("?? ??"));
+  EXPECT_FALSE(Signature::Parse("48 8"));
+  EXPECT_FALSE(Signature::Parse("48 8G"));
+  EXPECT_FALSE(Signature::Parse("488B"));
+  EXPECT_FALSE(Signature::Parse("48 ???"));
+}
+
+TEST(SignatureTest, AnchorsOnTheRarestFixedByte) {
+  // 48 and 8B show up every few instructions, 3D much less often.
+  const auto signature = Signature::Parse("48 8B ?? 3D");
+  ASSERT_TRUE(signature);
+  EXPECT_EQ(signature->anchor(), 3);
+  EXPECT_EQ(signature->anchor_byte(), std::byte{0x3D});
+}
+
+TEST(SignatureTest, MatchesWildcardsAnywhere) {
+  const auto signature = Signature::Parse("E8 ?? ?? ?? ?? 48");
+  ASSERT_TRUE(signature);
+  const std::vector<std::byte> data = {std::byte{0xE8}, std::byte{1}, std::byte{2}, std::byte{3}, std::byte{4},
+                                       std::byte{0x48}};
+  EXPECT_TRUE(signature->MatchesAt(data.data()));
+  std::vector<std::byte> other = data;
+  other[5] = std::byte{0x49};
+  EXPECT_FALSE(signature->MatchesAt(other.data()));
+}
+
+TEST(SignatureTest, KernelsAgreeWithNaiveSearch) {
+  // A small alphabet makes anchors and partial matches frequent, and sizes around the vector widths exercise the
+  // tails that cannot load a whole padded pattern.
+  constexpr const char* kLong = "00 01 02 ?? 00 01 02 ?? 00 01 02 ?? 00 01 02 ?? 00 01 02 ?? 00 01 02 ?? 00 01 02 ?? "
+                                "00 01 02 ?? 03";
+  std::mt19937 random(3);
+  for (const char* text : {"01", "01 ?? 02", "?? 00 01 ?? ?? 02 03", kLong}) {
+    const auto signature = Signature::Parse(text);
+    ASSERT_TRUE(signature) << text;
+    for (const size_t size : {0, 1, 31, 32, 33, 127, 128, 129, 1000, 4096}) {
+      std::vector<std::byte> data(size);
+      for (auto& byte : data) {
+        byte = std::byte{static_cast<uint8_t>(random() % 4)};
+      }
+      if (size >= signature->size()) {
+        const std::byte* bytes = signature->padded_bytes();
+        std::copy(bytes, bytes + signature->size(), data.end() - static_cast<ptrdiff_t>(signature->size()));
+      }
+      const auto expected = FindNaive(data, *signature);
+      for (const KernelIsa isa : SupportedIsas()) {
+        std::vector<size_t> offsets;
+        FindSignature(isa, data.data(), data.size(), *signature, offsets);
+        EXPECT_EQ(offsets, expected) << text << ", size " << size << ", " << ToString(isa);
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace maia
@@ -0,0 +1,198 @@
+#include "maiascan/scan/string_pattern.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "maiascan/core/cpu_features.hpp"
+
+namespace maia {
+namespace {
+
+using Hits = std::vector<std::pair<size_t, StringEncoding>>;
+
+std::vector<KernelIsa> SupportedIsas() {
+  std::vector<KernelIsa> isas = {KernelIsa::kScalar};
+  if (GetCpuFeatures().sse41) {
+    isas.push_back(KernelIsa::kSse41);
+  }
+  if (GetCpuFeatures().avx2) {
+    isas.push_back(KernelIsa::kAvx2);
+  }
+  return isas;
+}
+
+std::vector<std::byte> Bytes(std::string_view text) {
+  std::vector<std::byte> bytes(text.size());
+  std::transform(text.begin(), text.end(), bytes.begin(), [](char c) { return static_cast<std::byte>(c); });
+  return bytes;
+}
+
+Hits Find(KernelIsa isa, const std::vector<std::byte>& data, size_t limit, const StringPattern& pattern) {
+  std::vector<StringHit> hits;
+  FindString(isa, data.data(), data.size(), limit, pattern, hits);
+  Hits result;
+  for (const StringHit& hit : hits) {
+    result.emplace_back(hit.offset, hit.encoding);
+  }
+  return result;
+}
+
+// Expects every instruction set to find `expected` in `data`.
+void ExpectHits(const std::vector<std::byte>& data, size_t limit, const StringPattern& pattern, const Hits& expected) {
+  for (const KernelIsa isa : SupportedIsas()) {
+    EXPECT_EQ(Find(isa, data, limit, pattern), expected) << pattern.text() << ", " << ToString(isa);
+  }
+}
+
+TEST(StringPatternTest, RejectsMalformedUtf8) {
+  for (const std::string_view text : {
+           std::string_view(""),
+           std::string_view("\x80"),                  // Continuation byte without a lead.
+           std::string_view("\xC0\x80"),              // Overlong NUL.
+           std::string_view("\xC1\xBF"),              // Overlong 0x7F.
+           std::string_view("\xE0\x80\xAF"),          // Overlong '/'.
+           std::string_view("\xF0\x8F\xBF\xBF"),      // Overlong U+FFFF.
+           std::string_view("\xED\xA0\x80"),          // High surrogate.
+           std::string_view("\xED\xBF\xBF"),          // Low surrogate.
+           std::string_view("\xF4\x90\x80\x80"),      // Past U+10FFFF.
+           std::string_view("\xF8\x88\x80\x80\x80"),  // Five-byte lead.
+           std::string_view("a\xC3"),                 // Truncated two-byte sequence.
+           std::string_view("\xE2\x82"),              // Truncated three-byte sequence.
+           std::string_view("\xF0\x9F\x98"),          // Truncated four-byte sequence.
+           std::string_view("\xC3\x28"),              // Lead followed by a non-continuation byte.
+       }) {
+    EXPECT_FALSE(StringPattern::Create(text, true, true, false)) << testing::PrintToString(text);
+  }
+  EXPECT_FALSE(StringPattern::Create("text", false, false, false));
+}
+
+TEST(StringPatternTest, EncodesUtf8AsIs) {
+  const auto pattern = StringPattern::Create("h\xC3\xA9\xE2\x82\xAC", true, false, false);
+  ASSERT_TRUE(pattern);
+  ASSERT_EQ(pattern->encodings().size(), 1);
+  const EncodedString& encoded = pattern->encodings()[0];
+  EXPECT_EQ(encoded.encoding, StringEncoding::kUtf8);
+  ASSERT_EQ(encoded.size, 6);
+  EXPECT_EQ(std::vector(encoded.bytes.begin(), encoded.bytes.begin() + 6), Bytes("h\xC3\xA9\xE2\x82\xAC"));
+  EXPECT_EQ(encoded.bytes.size() % StringPattern::kPadding, 0);
+  EXPECT_EQ(encoded.bytes[6], std::byte{0xFF});
+  EXPECT_EQ(encoded.fold[6], std::byte{0xFF});
+}
+
+TEST(StringPatternTest, EncodesSupplementaryCharactersAsSurrogatePairs) {
+  // U+1F600 is D83D DE00 in UTF-16, stored little-endian.
+  const auto pattern = StringPattern::Create("a\xF0\x9F\x98\x80", false, true, true);
+  ASSERT_TRUE(pattern);
+  ASSERT_EQ(pattern->encodings().size(), 1);
+  const EncodedString& encoded = pattern->encodings()[0];
+  EXPECT_EQ(encoded.encoding, StringEncoding::kUtf16);
+  ASSERT_EQ(encoded.size, 6);
+  EXPECT_EQ(std::vector(encoded.bytes.begin(), encoded.bytes.begin() + 6),
+            Bytes(std::string_view("a\0\x3D\xD8\0\xDE", 6)));
+  // Only the low byte of the letter folds; surrogates are never touched.
+  EXPECT_EQ(std::vector(encoded.fold.begin(), encoded.fold.begin() + 6),
+            Bytes(std::string_view("\x20\0\0\0\0\0", 6)));
+
+  ExpectHits(Bytes(std::string_view("xxA\0\x3D\xD8\x00\xDExx", 10)), 10, *pattern, {{2, StringEncoding::kUtf16}});
+  // Half of the pair is not the character.
+  ExpectHits(Bytes(std::string_view("xxA\0\x3D\xD8\x01\xDExx", 10)), 10, *pattern, {});
+}
+
+TEST(StringPatternTest, IgnoreCaseFoldsOnlyLetters) {
+  const auto pattern = StringPattern::Create("a@[", true, true, true);
+  ASSERT_TRUE(pattern);
+  ExpectHits(Bytes("a@[ A@[ a`[ a@{ A`{"), 19, *pattern, {{0, StringEncoding::kUtf8}, {4, StringEncoding::kUtf8}});
+  ExpectHits(Bytes(std::string_view("A\0@\0[\0 a\0`\0[\0", 13)), 13, *pattern, {{0, StringEncoding::kUtf16}});
+
+  // '@' and '`' differ only in the case bit, as do 'A' and 'a'.
+  const auto at = StringPattern::Create("@", true, false, true);
+  ASSERT_TRUE(at);
+  ExpectHits(Bytes("`@`"), 3, *at, {{1, StringEncoding::kUtf8}});
+}
+
+TEST(StringPatternTest, MatchesCaseExactlyUnlessIgnoringIt) {
+  const auto exact = StringPattern::Create("Ab", true, false, false);
+  ASSERT_TRUE(exact);
+  ExpectHits(Bytes("ab Ab AB aB"), 11, *exact, {{3, StringEncoding::kUtf8}});
+  const auto folded = StringPattern::Create("Ab", true, false, true);
+  ASSERT_TRUE(folded);
+  ExpectHits(
+      Bytes("ab Ab AB aB"),
+      11,
+      *folded,
+      {{0, StringEncoding::kUtf8}, {3, StringEncoding::kUtf8}, {6, StringEncoding::kUtf8}, {9, StringEncoding::kUtf8}});
+}
+
+TEST(StringPatternTest, MatchesStartBeforeLimitAndEndWithinSize) {
+  // Matches every 10 bytes; a shard's limit cuts where the next shard starts, so matches may run past it.
+  const auto pattern = StringPattern::Create("abc", true, false, false);
+  ASSERT_TRUE(pattern);
+  for (const size_t size : {30, 31, 32, 33, 64, 65, 100}) {
+    std::vector<std::byte> data(size, std::byte{'x'});
+    for (size_t offset = 0; offset + 3 <= size + 2; offset += 10) {
+      const std::string_view text = "abc";
+      for (size_t i = 0; i < 3 && offset + i < size; ++i) {
+        data[offset + i] = std::byte(text[i]);
+      }
+    }
+    for (const size_t limit : {size_t{0}, size_t{1}, size_t{10}, size_t{11}, size - 2, size - 1, size, size + 5}) {
+      Hits expected;
+      for (size_t offset = 0; offset < std::min(limit, size) && offset + 3 <= size; offset += 10) {
+        expected.emplace_back(offset, StringEncoding::kUtf8);
+      }
+      for (const KernelIsa isa : SupportedIsas()) {
+        EXPECT_EQ(Find(isa, data, limit, *pattern), expected)
+            << "size " << size << ", limit " << limit << ", " << ToString(isa);
+      }
+    }
+  }
+}
+
+TEST(StringPatternTest, KernelsAgreeWithScalarSearch) {
+  // The data draws from the bytes of the patterns themselves in either case, so partial matches of both encodings,
+  // fold-only differences and the two-byte filter all come up often. Sizes around the vector widths exercise the tails
+  // that cannot load a whole padded pattern.
+  const std::string_view alphabet("aAbB@`\0\x3D\xD8\xDE\xC3\xA9", 12);
+  const std::string_view texts[] = {"a", "ab", "a@", "\xC3\xA9", "a\xF0\x9F\x98\x80", "abababababababababab"};
+  std::mt19937 random(5);
+  for (const std::string_view text : texts) {
+    for (const bool ignore_case : {false, true}) {
+      for (const auto& [utf8, utf16] : {std::pair(true, false), std::pair(false, true), std::pair(true, true)}) {
+        const auto pattern = StringPattern::Create(text, utf8, utf16, ignore_case);
+        ASSERT_TRUE(pattern) << text;
+        for (const size_t size : {0, 1, 2, 15, 16, 17, 31, 32, 33, 34, 63, 64, 65, 200, 1000}) {
+          std::vector<std::byte> data(size);
+          for (auto& byte : data) {
+            byte = std::byte(alphabet[random() % alphabet.size()]);
+          }
+          // Plant every encoding a few times, the last one as close to the end as it fits.
+          for (const EncodedString& encoded : pattern->encodings()) {
+            if (encoded.size > size) {
+              continue;
+            }
+            for (const size_t offset : {size_t{0}, random() % (size - encoded.size + 1), size - encoded.size}) {
+              std::copy(encoded.bytes.begin(), encoded.bytes.begin() + encoded.size, data.begin() + offset);
+            }
+          }
+          for (const size_t limit : {size, size / 2, size - std::min<size_t>(size, 3)}) {
+            const Hits expected = Find(KernelIsa::kScalar, data, limit, *pattern);
+            for (const KernelIsa isa : SupportedIsas()) {
+              EXPECT_EQ(Find(isa, data, limit, *pattern), expected)
+                  << testing::PrintToString(text) << (ignore_case ? " ignoring case" : "") << ", utf8 " << utf8
+                  << ", utf16 " << utf16 << ", size " << size << ", limit " << limit << ", " << ToString(isa);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace maia
@@ -0,0 +1,80 @@
+#include "maiascan/core/varint.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace maia {
+namespace {
+
+constexpr std::array<uint64_t, 9> kValues = {
+    0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, uint64_t{1} << 35, std::numeric_limits<uint64_t>::max() - 1,
+    std::numeric_limits<uint64_t>::max()};
+
+TEST(VarintTest, RoundTripsAppendedValues) {
+  std::vector<uint8_t> bytes;
+  for (const uint64_t value : kValues) {
+    AppendVarint(bytes, value);
+  }
+  const uint8_t* data = bytes.data();
+  for (const uint64_t expected : kValues) {
+    uint64_t value = 0;
+    ASSERT_TRUE(ReadVarint(data, bytes.data() + bytes.size(), value));
+    EXPECT_EQ(value, expected);
+  }
+  EXPECT_EQ(data, bytes.data() + bytes.size());
+}
+
+TEST(VarintTest, WriteMatchesAppend) {
+  for (const uint64_t value : kValues) {
+    std::vector<uint8_t> appended;
+    AppendVarint(appended, value);
+    std::array<uint8_t, kMaxVarintSize> written{};
+    const size_t size = WriteVarint(written.data(), value);
+    ASSERT_EQ(size, appended.size());
+    EXPECT_TRUE(std::equal(appended.begin(), appended.end(), written.begin()));
+  }
+}
+
+TEST(VarintTest, SevenBitsPerByte) {
+  std::vector<uint8_t> bytes;
+  AppendVarint(bytes, 0x7F);
+  EXPECT_EQ(bytes.size(), 1);
+  bytes.clear();
+  AppendVarint(bytes, 0x80);
+  EXPECT_EQ(bytes, (std::vector<uint8_t>{0x80, 0x01}));
+  bytes.clear();
+  AppendVarint(bytes, std::numeric_limits<uint64_t>::max());
+  EXPECT_EQ(bytes.size(), kMaxVarintSize);
+}
+
+TEST(VarintTest, RejectsTruncatedAndOverlongInput) {
+  const std::array<uint8_t, 2> truncated = {0x80, 0x80};
+  const uint8_t* data = truncated.data();
+  uint64_t value = 0;
+  EXPECT_FALSE(ReadVarint(data, truncated.data() + truncated.size(), value));
+
+  std::array<uint8_t, kMaxVarintSize + 1> overlong{};
+  overlong.fill(0x80);
+  overlong.back() = 0x01;
+  data = overlong.data();
+  EXPECT_FALSE(ReadVarint(data, overlong.data() + overlong.size(), value));
+}
+
+TEST(VarintTest, ZigZagKeepsSmallMagnitudesSmall) {
+  EXPECT_EQ(ZigZagEncode(0), 0);
+  EXPECT_EQ(ZigZagEncode(-1), 1);
+  EXPECT_EQ(ZigZagEncode(1), 2);
+  EXPECT_EQ(ZigZagEncode(-2), 3);
+  for (const int64_t value : {int64_t{0}, int64_t{-1}, int64_t{12345}, std::numeric_limits<int64_t>::min(),
+                              std::numeric_limits<int64_t>::max()}) {
+    EXPECT_EQ(ZigZagDecode(ZigZagEncode(value)), value);
+  }
+}
+
+}  // namespace
+}  // namespace maia